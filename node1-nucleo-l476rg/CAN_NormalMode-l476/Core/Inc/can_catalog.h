@@ -0,0 +1,118 @@
+/*
+ * can_catalog.h
+ *
+ * CAN message catalogue
+ * GENERATED by tools/can_catalog/gen_catalog.py from messages.dbc - do not edit.
+ * Shared by node1 and node2: IDs, DLCs, filter entries and pack/unpack helpers.
+ */
+
+#ifndef INC_CAN_CATALOG_H_
+#define INC_CAN_CATALOG_H_
+
+#include <stdint.h>
+
+/* bxCAN filter register encodings for a standard ID */
+#define CAN_FILTER16(id, rtr)    ((uint16_t)(((id) << 5) | ((rtr) << 4)))
+#define CAN_FILTER32_HIGH(id)    ((uint16_t)((id) << 5))
+
+/* ---------------- LED_CMD ---------------- */
+/* LED command: Node2 turns on LED #LED_NO (1 green, 2 orange, 3 red, 4 blue) */
+#define CAN_ID_LED_CMD              0x65DU
+#define CAN_DLC_LED_CMD             1U
+#define CAN_RTR_REQUEST_LED_CMD     0
+
+typedef struct
+{
+	uint8_t  led_no;      // raw, [1..4]
+} CAN_LED_CMD_t;
+
+static inline void CAN_LED_CMD_Pack(uint8_t data[], const CAN_LED_CMD_t *msg)
+{
+	data[0] = (uint8_t)((uint32_t)msg->led_no);
+}
+
+static inline void CAN_LED_CMD_Unpack(CAN_LED_CMD_t *msg, const uint8_t data[])
+{
+	msg->led_no = (uint8_t)((uint32_t)data[0]);
+}
+
+/* ---------------- SENSOR_DATA ---------------- */
+/* Requested by NODE1 with a remote frame of the same ID, answered by NODE2 (MSB first). Slave n uses ID 0x680 + n; a request on 0x680 is a broadcast answered by every slave in its reply slot */
+#define CAN_ID_SENSOR_DATA          0x680U
+#define CAN_DLC_SENSOR_DATA         2U
+#define CAN_RTR_REQUEST_SENSOR_DATA 1
+#define CAN_SENSOR_DATA_NODES       31U
+#define CAN_ID_SENSOR_DATA_NODE(n)  (CAN_ID_SENSOR_DATA + (n))
+
+typedef struct
+{
+	uint16_t value;       // raw, [0..65535]
+} CAN_SENSOR_DATA_t;
+
+static inline void CAN_SENSOR_DATA_Pack(uint8_t data[], const CAN_SENSOR_DATA_t *msg)
+{
+	data[0] = (uint8_t)(((uint32_t)msg->value >> 8));
+	data[1] = (uint8_t)((uint32_t)msg->value);
+}
+
+static inline void CAN_SENSOR_DATA_Unpack(CAN_SENSOR_DATA_t *msg, const uint8_t data[])
+{
+	msg->value = (uint16_t)((uint32_t)data[1] | ((uint32_t)data[0] << 8));
+}
+
+/* ---------------- SENSOR_SUMMARY ---------------- */
+/* Sent by NODE2 at the end of each aggregation window of SIGNAL: min, max and rounded mean of the COUNT samples (saturated at 4095). Slave n uses ID 0x6C0 + n, slaves 1..8 only */
+#define CAN_ID_SENSOR_SUMMARY       0x6C0U
+#define CAN_DLC_SENSOR_SUMMARY      8U
+#define CAN_RTR_REQUEST_SENSOR_SUMMARY 0
+#define CAN_SENSOR_SUMMARY_NODES    8U
+#define CAN_ID_SENSOR_SUMMARY_NODE(n) (CAN_ID_SENSOR_SUMMARY + (n))
+
+typedef struct
+{
+	uint8_t  signal;      // raw, [0..15]
+	uint16_t count;       // raw, [0..4095]
+	uint16_t min;         // raw, [0..65535]
+	uint16_t max;         // raw, [0..65535]
+	uint16_t mean;        // raw, [0..65535]
+} CAN_SENSOR_SUMMARY_t;
+
+static inline void CAN_SENSOR_SUMMARY_Pack(uint8_t data[], const CAN_SENSOR_SUMMARY_t *msg)
+{
+	data[0] = (uint8_t)((((uint32_t)msg->signal & 0x0FU) << 4) | (((uint32_t)msg->count >> 8) & 0x0FU));
+	data[1] = (uint8_t)((uint32_t)msg->count);
+	data[2] = (uint8_t)(((uint32_t)msg->min >> 8));
+	data[3] = (uint8_t)((uint32_t)msg->min);
+	data[4] = (uint8_t)(((uint32_t)msg->max >> 8));
+	data[5] = (uint8_t)((uint32_t)msg->max);
+	data[6] = (uint8_t)(((uint32_t)msg->mean >> 8));
+	data[7] = (uint8_t)((uint32_t)msg->mean);
+}
+
+static inline void CAN_SENSOR_SUMMARY_Unpack(CAN_SENSOR_SUMMARY_t *msg, const uint8_t data[])
+{
+	msg->signal = (uint8_t)((((uint32_t)data[0] >> 4) & 0x0FU));
+	msg->count = (uint16_t)((uint32_t)data[1] | (((uint32_t)data[0] & 0x0FU) << 8));
+	msg->min = (uint16_t)((uint32_t)data[3] | ((uint32_t)data[2] << 8));
+	msg->max = (uint16_t)((uint32_t)data[5] | ((uint32_t)data[4] << 8));
+	msg->mean = (uint16_t)((uint32_t)data[7] | ((uint32_t)data[6] << 8));
+}
+
+/* ---------------- Receive lists (bxCAN 16-bit list-mode entries) ---------------- */
+#define CAN_NODE1_RX_COUNT      39U
+#define CAN_NODE1_RX_FILTERS    { \
+	CAN_FILTER16(0x681U, 0), CAN_FILTER16(0x682U, 0), CAN_FILTER16(0x683U, 0), CAN_FILTER16(0x684U, 0), \
+	CAN_FILTER16(0x685U, 0), CAN_FILTER16(0x686U, 0), CAN_FILTER16(0x687U, 0), CAN_FILTER16(0x688U, 0), \
+	CAN_FILTER16(0x689U, 0), CAN_FILTER16(0x68AU, 0), CAN_FILTER16(0x68BU, 0), CAN_FILTER16(0x68CU, 0), \
+	CAN_FILTER16(0x68DU, 0), CAN_FILTER16(0x68EU, 0), CAN_FILTER16(0x68FU, 0), CAN_FILTER16(0x690U, 0), \
+	CAN_FILTER16(0x691U, 0), CAN_FILTER16(0x692U, 0), CAN_FILTER16(0x693U, 0), CAN_FILTER16(0x694U, 0), \
+	CAN_FILTER16(0x695U, 0), CAN_FILTER16(0x696U, 0), CAN_FILTER16(0x697U, 0), CAN_FILTER16(0x698U, 0), \
+	CAN_FILTER16(0x699U, 0), CAN_FILTER16(0x69AU, 0), CAN_FILTER16(0x69BU, 0), CAN_FILTER16(0x69CU, 0), \
+	CAN_FILTER16(0x69DU, 0), CAN_FILTER16(0x69EU, 0), CAN_FILTER16(0x69FU, 0), CAN_FILTER16(0x6C1U, 0), \
+	CAN_FILTER16(0x6C2U, 0), CAN_FILTER16(0x6C3U, 0), CAN_FILTER16(0x6C4U, 0), CAN_FILTER16(0x6C5U, 0), \
+	CAN_FILTER16(0x6C6U, 0), CAN_FILTER16(0x6C7U, 0), CAN_FILTER16(0x6C8U, 0) \
+}
+#define CAN_NODE2_RX_COUNT      3U
+#define CAN_NODE2_RX_FILTERS(node)  { CAN_FILTER16(0x65DU, 0), CAN_FILTER16(CAN_ID_SENSOR_DATA_NODE(node), 1), CAN_FILTER16(0x680U, 1) }
+
+#endif /* INC_CAN_CATALOG_H_ */
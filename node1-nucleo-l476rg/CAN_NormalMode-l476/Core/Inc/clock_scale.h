@@ -0,0 +1,78 @@
+/*
+ * clock_scale.h
+ *
+ * Operating-point manager (node1, L476)
+ * Follows the CAN frame rate with SYSCLK and the regulator range:
+ *   - every CLOCK_SCALE_WINDOW_MS the frames dispatched by CAN_IF_Poll()
+ *     are counted; above the current point's max_fps the clock goes up to
+ *     the first point that keeps up, below 3/4 of the next lower point's
+ *     max_fps for CLOCK_SCALE_DOWN_WINDOWS windows it steps down one point
+ *   - a switch waits for a quiet bus: no poll request in flight and the
+ *     next sweep at least CLOCK_SCALE_QUIET_MS away, TX mailboxes, RX ring
+ *     and UART TX idle
+ *   - every point keeps 500 kbit/s, UART_LINK_BAUD and the TIM6 count
+ *     rate: CAN BTR, USART2 BRR/OVER8 and TIM6 PSC are rewritten with it
+ * CAN is in initialisation mode for the length of a switch (a few hundred
+ * us, clock_scale_stats.switch_us_max); frames sent in that window are not
+ * received.
+ *
+ * The table is checked on the host: tools/clock_scale/check_points.py
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_CLOCK_SCALE_H_
+#define INC_CLOCK_SCALE_H_
+
+#include "main.h"
+
+#define CLOCK_SCALE_ENABLE        1U       // 0: stay at the SystemClock_Config() point
+#define CLOCK_SCALE_WINDOW_MS     100U     // frame rate measurement window
+#define CLOCK_SCALE_DOWN_WINDOWS  10U      // quiet windows before stepping down
+#define CLOCK_SCALE_QUIET_MS      2U       // bus must stay quiet this long for a switch
+
+#define CLOCK_SCALE_HSE_HZ        8000000U // ST-LINK MCO, PLLM = 1
+#define CLOCK_SCALE_TIM_HZ        10000U   // TIM6 count rate at every point (TIMER6_Init)
+
+typedef struct
+{
+	uint32_t sysclk_hz;                  // HSE * pll_n / pll_r, HCLK = PCLK1 = PCLK2
+	uint8_t  range;                      // regulator voltage range, 1 or 2
+	uint8_t  flash_ws;                   // flash wait states for sysclk_hz in that range
+	uint8_t  pll_n;
+	uint8_t  pll_r;                      // 2, 4, 6 or 8
+	uint16_t can_brp;                    // CAN prescaler
+	uint8_t  can_bs1;                    // time quanta, SJW = 1
+	uint8_t  can_bs2;
+	uint16_t tim_psc;                    // TIM6 prescaler for CLOCK_SCALE_TIM_HZ
+	uint16_t max_fps;                    // CAN frames/s this point keeps up with, 0 = no limit
+} Clock_Point_t;
+
+/* Lowest point first, the last one is SystemClock_Config() (boot). ws is the
+ * minimum for the range (RM0351): range 2 needs 2 WS above 12 MHz, 3 above 18 MHz.
+ *  sysclk_hz  range ws  pll_n pll_r  brp bs1 bs2  tim_psc max_fps */
+#define CLOCK_SCALE_POINTS                                         \
+{                                                                  \
+	{ 16000000U, 2U, 2U,  8U, 4U,  2U, 13U, 2U, 1599U,  300U },    \
+	{ 24000000U, 2U, 3U, 12U, 4U,  3U, 13U, 2U, 2399U, 1000U },    \
+	{ 42000000U, 1U, 2U, 21U, 4U,  6U, 11U, 2U, 4199U,    0U },    \
+}
+#define CLOCK_SCALE_POINT_COUNT   3U
+
+typedef struct
+{
+	uint32_t point;                      // index into CLOCK_SCALE_POINTS
+	uint32_t fps;                        // frame rate of the last window
+	uint32_t switches;
+	uint32_t deferred;                   // windows a wanted switch waited for a quiet bus
+	uint32_t switch_us_max;              // CAN stop -> CAN running again
+	uint32_t ms_at[CLOCK_SCALE_POINT_COUNT];
+} Clock_Scale_Stats_t;
+
+extern volatile Clock_Scale_Stats_t clock_scale_stats;
+
+void Clock_Scale_Init(void);
+void Clock_Scale_Process(void);
+
+#endif /* INC_CLOCK_SCALE_H_ */
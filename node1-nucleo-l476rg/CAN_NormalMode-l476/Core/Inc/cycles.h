@@ -0,0 +1,63 @@
+/*
+ * cycles.h
+ *
+ * DWT cycle counter helpers
+ * Used to measure ISR execution time in CPU cycles (min / max / mean).
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_CYCLES_H_
+#define INC_CYCLES_H_
+
+#include "main.h"
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+} Cycle_Stats_t;
+
+/**
+  * @brief Enable the DWT cycle counter
+  */
+static inline void Cycles_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t Cycles_Now(void)
+{
+	return DWT->CYCCNT;
+}
+
+/**
+  * @brief Add one measurement (end - start, wrap-safe) to a statistics block
+  */
+static inline void Cycle_Stats_Add(volatile Cycle_Stats_t *stats, uint32_t start)
+{
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	if(stats->count == 0U || cycles < stats->min)
+	{
+		stats->min = cycles;
+	}
+	if(cycles > stats->max)
+	{
+		stats->max = cycles;
+	}
+	stats->total += cycles;
+	stats->count++;
+}
+
+static inline uint32_t Cycle_Stats_Mean(const volatile Cycle_Stats_t *stats)
+{
+	return (stats->count != 0U) ? (uint32_t)(stats->total / stats->count) : 0U;
+}
+
+#endif /* INC_CYCLES_H_ */
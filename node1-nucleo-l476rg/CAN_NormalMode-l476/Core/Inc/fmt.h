@@ -0,0 +1,34 @@
+/*
+ * fmt.h
+ *
+ * printf-free text formatting (log lines)
+ * Covers what the LOG_xxx() sites use: %lu / %u, %ld / %d, %lX / %lx with
+ * an optional zero-padded width (%08lX), %c and %%; strings are appended
+ * with Fmt_Str(). No heap, no static state, no newlib: every call only
+ * touches the caller's Fmt_Buf_t, so it is reentrant and ISR-safe.
+ * Output is truncated to the buffer and always NUL-terminated.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_FMT_H_
+#define INC_FMT_H_
+
+#include "main.h"
+
+typedef struct
+{
+	char *buf;
+	uint32_t size;                       // including the terminating NUL
+	uint32_t len;                        // characters written so far
+} Fmt_Buf_t;
+
+void Fmt_Init(Fmt_Buf_t *out, char *buf, uint32_t size);
+void Fmt_Char(Fmt_Buf_t *out, char c);
+void Fmt_Str(Fmt_Buf_t *out, const char *str);
+void Fmt_Dec(Fmt_Buf_t *out, uint32_t value, uint32_t width, char pad);
+void Fmt_Hex(Fmt_Buf_t *out, uint32_t value, uint32_t width, char pad, uint8_t upper);
+void Fmt_Format(Fmt_Buf_t *out, const char *fmt, uint32_t arg0, uint32_t arg1);
+
+#endif /* INC_FMT_H_ */
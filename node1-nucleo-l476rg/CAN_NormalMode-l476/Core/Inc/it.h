@@ -11,6 +11,20 @@
 #ifndef INC_IT_H_
 #define INC_IT_H_
 
+#include "cycles.h"
+
 /* Add custom interrupt prototypes here if needed */
 
+/* --- CAN vector dispatch --- */
+#define CAN_ISR_LEAN    1U   // 1: per-vector handlers in it.c, 0: HAL_CAN_IRQHandler (cycle baseline)
+
+/* --- CAN vector cycle statistics (DWT), index into can_isr_cycles[] --- */
+#define CAN_ISR_TX      0U
+#define CAN_ISR_RX0     1U
+#define CAN_ISR_RX1     2U
+#define CAN_ISR_SCE     3U
+#define CAN_ISR_COUNT   4U
+
+extern volatile Cycle_Stats_t can_isr_cycles[CAN_ISR_COUNT];
+
 #endif /* INC_IT_H_ */
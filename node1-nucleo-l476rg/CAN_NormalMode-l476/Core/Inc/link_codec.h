@@ -0,0 +1,40 @@
+/*
+ * link_codec.h
+ *
+ * Debug link packet codec: CRC-16/CCITT-FALSE, COBS encode, and a byte-wise
+ * receive decoder. No HAL dependency, builds unchanged on the host.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_LINK_CODEC_H_
+#define INC_LINK_CODEC_H_
+
+#include <stdint.h>
+
+#define LINK_PAYLOAD_MAX          64U      // largest payload per packet
+#define LINK_PACKET_MAX           (1U + LINK_PAYLOAD_MAX + 2U)                // type + payload + CRC
+#define LINK_WIRE_MAX             (LINK_PACKET_MAX + (LINK_PACKET_MAX / 254U) + 2U)
+
+/* --- Receive decoder status --- */
+#define LINK_RX_NONE              0U       // packet not complete yet
+#define LINK_RX_PACKET            1U       // valid packet in packet[0..len)
+#define LINK_RX_BAD               2U       // delimiter reached, COBS/CRC/length error
+
+typedef struct
+{
+	uint8_t  wire[LINK_WIRE_MAX];   // COBS bytes since the last delimiter
+	uint32_t wire_len;
+	uint8_t  overflow;              // current packet exceeded LINK_WIRE_MAX
+	uint8_t  packet[LINK_PACKET_MAX];
+	uint32_t len;                   // decoded length without CRC (type + payload)
+} Link_Rx_t;
+
+uint16_t Link_Crc16(const uint8_t *data, uint32_t len);
+uint32_t Link_Cobs_Encode(uint8_t *dst, const uint8_t *src, uint32_t len);
+uint32_t Link_Encode(uint8_t *wire, uint8_t type, const uint8_t *payload, uint32_t len);
+void Link_Rx_Reset(Link_Rx_t *rx);
+uint8_t Link_Rx_Feed(Link_Rx_t *rx, uint8_t byte);
+
+#endif /* INC_LINK_CODEC_H_ */
@@ -0,0 +1,84 @@
+/*
+ * poll.h
+ *
+ * Slave polling engine (node1, master)
+ * Requests CAN_SENSOR_DATA from slaves 1..NODE_SLAVES with a bounded bus load:
+ *   - pipelined: up to POLL_OUTSTANDING remote requests in flight to
+ *                different slaves, replies matched by CAN ID, timeouts
+ *                retried; one sweep over all slaves per POLL_PERIOD_MS
+ *   - broadcast: one request on the base ID per POLL_PERIOD_MS, every slave
+ *                answers node_id * NODE_REPLY_SLOT_MS later (node_id.h)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_POLL_H_
+#define INC_POLL_H_
+
+#include "main.h"
+#include "node_id.h"
+#include "can_if.h"
+
+#define POLL_MODE_PIPELINED     0U
+#define POLL_MODE_BROADCAST     1U
+
+#define POLL_MODE               POLL_MODE_PIPELINED
+#define NODE_SLAVES             30U      // slaves on the bus, node IDs 1..NODE_SLAVES
+#define POLL_PERIOD_MS          50U      // start of one sweep / broadcast to the next
+
+/* --- Pipelined sweep --- */
+#define POLL_OUTSTANDING        4U       // requests in flight at once (K)
+#define POLL_TIMEOUT_US         2000U    // no reply within this time: retry
+#define POLL_RETRIES            1U       // retries before a slave counts as missed
+#define POLL_TABLE_SIZE         8U       // in-flight hash table, power of two >= 2 * K
+
+/* --- Bus load budget (500 kbit/s, see CAN1_Init) --- */
+#define POLL_BITRATE            500000U
+#define POLL_REQUEST_BITS       55U      // standard remote frame, worst-case stuffing + intermission
+#define POLL_REPLY_BITS         75U      // standard data frame with CAN_DLC_SENSOR_DATA bytes, idem
+#define POLL_BUS_LOAD_MAX_PCT   20U
+
+#if NODE_SLAVES > NODE_ID_MAX
+#error "NODE_SLAVES exceeds the node-indexed ID range"
+#endif
+
+#if POLL_MODE == POLL_MODE_PIPELINED
+#if (POLL_TABLE_SIZE & (POLL_TABLE_SIZE - 1U)) != 0U || POLL_TABLE_SIZE < 2U * POLL_OUTSTANDING
+#error "POLL_TABLE_SIZE must be a power of two of at least 2 * POLL_OUTSTANDING"
+#endif
+#if NODE_SLAVES * (POLL_REQUEST_BITS + POLL_REPLY_BITS) * 100U > POLL_BITRATE / 1000U * POLL_BUS_LOAD_MAX_PCT * POLL_PERIOD_MS
+#error "POLL_PERIOD_MS too short for POLL_BUS_LOAD_MAX_PCT"
+#endif
+#else
+#if (POLL_REQUEST_BITS + NODE_SLAVES * POLL_REPLY_BITS) * 100U > POLL_BITRATE / 1000U * POLL_BUS_LOAD_MAX_PCT * POLL_PERIOD_MS
+#error "POLL_PERIOD_MS too short for POLL_BUS_LOAD_MAX_PCT"
+#endif
+#if (NODE_SLAVES + 1U) * NODE_REPLY_SLOT_MS > POLL_PERIOD_MS
+#error "reply slots do not fit in POLL_PERIOD_MS"
+#endif
+#endif
+
+typedef struct
+{
+	uint32_t requests;                   // remote frames sent, retries included
+	uint32_t replies;                    // replies matched to a request
+	uint32_t retries;                    // requests repeated after POLL_TIMEOUT_US
+	uint32_t missed;                     // slaves silent for a whole sweep
+	uint32_t unexpected;                 // reply with no request in flight (late, duplicate)
+	uint32_t tx_busy;                    // request postponed, no TX mailbox free
+	uint32_t cycles;                     // completed sweeps
+	uint32_t cycle_us;                   // first request -> last reply/timeout of the last sweep
+	uint32_t cycle_us_max;
+	uint32_t reply_us_max;               // request on the bus -> reply received
+	uint32_t tx_lost;                    // request aborted or failed in its mailbox, retried at once
+} Poll_Stats_t;
+
+extern volatile Poll_Stats_t poll_stats;
+
+void Poll_Process(void);
+void Poll_Reply(uint32_t StdId);
+void Poll_Tx_Done(const CAN_IF_Tx_Event_t *event);
+uint32_t Poll_Quiet_Ms(void);
+
+#endif /* INC_POLL_H_ */
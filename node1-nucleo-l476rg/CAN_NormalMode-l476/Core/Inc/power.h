@@ -0,0 +1,70 @@
+/*
+ * power.h
+ *
+ * Low-power listen mode
+ * Power_Idle() runs last in the main loop. When no deferred work is left
+ * (RX ring, log queue) the core waits for the next interrupt:
+ *   - POWER_LEVEL_SLEEP: WFI, peripherals keep running, nothing is lost;
+ *     SysTick still wakes the core every millisecond
+ *   - POWER_LEVEL_STOP: after POWER_STOP_IDLE_MS without a frame, and only
+ *     with the CAN TX mailboxes, the UART TX ring and TIM6 idle: bxCAN
+ *     sleep (HAL_CAN_RequestSleep, AutoWakeUp), Stop mode, woken by a
+ *     falling edge on the CAN RX pin (EXTI). HSE/PLL are restored by
+ *     register writes, SysTick is advanced by the time spent in Stop.
+ *     The frame whose SOF wakes the MCU is lost: the bxCAN clock is only
+ *     back after the PLL has locked, so a sender without retransmission
+ *     must repeat it.
+ * Time in Stop is measured with the RTC subsecond counter on LSI, which
+ * keeps counting in Stop; LSI is calibrated against SysTick at init.
+ *
+ * Reported every POWER_REPORT_MS: awake share of wall time and the
+ * latency from a CAN wakeup to the first frame handled in the main loop.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_POWER_H_
+#define INC_POWER_H_
+
+#include "main.h"
+#include "cycles.h"
+
+#define POWER_LEVEL_RUN           0U       // never wait, busy main loop
+#define POWER_LEVEL_SLEEP         1U
+#define POWER_LEVEL_STOP          2U
+
+#define POWER_LEVEL               POWER_LEVEL_SLEEP
+#define POWER_STOP_IDLE_MS        200U     // bus quiet this long before Stop
+#define POWER_SLEEP_ACK_MS        5U       // bxCAN finishes the frame on the bus, then SLAK
+#define POWER_LSI_CAL_MS          100U     // LSI calibration window at init
+#define POWER_REPORT_MS           1000U
+
+/* --- Board: NUCLEO-L476RG --- */
+#define POWER_WAKE_PIN            GPIO_PIN_11       // CAN1_RX, PA11
+#define POWER_WAKE_IRQn           EXTI15_10_IRQn    // shared with the user button
+#define POWER_WAKE_PORT_SELECT()  MODIFY_REG(SYSCFG->EXTICR[2], SYSCFG_EXTICR3_EXTI11, SYSCFG_EXTICR3_EXTI11_PA)
+#define POWER_EXTI_IMR            (EXTI->IMR1)
+#define POWER_EXTI_FTSR           (EXTI->FTSR1)
+#define POWER_HSE_STATE           RCC_HSE_BYPASS    // 8 MHz MCO from the ST-LINK
+
+typedef struct
+{
+	uint32_t sleeps;                     // WFI entries
+	uint32_t stops;                      // Stop mode entries
+	uint32_t stop_aborted;               // bxCAN did not acknowledge sleep in time
+	uint32_t can_wakes;                  // woken by CAN RX (RX interrupt or RX pin edge)
+	uint32_t rtc_hz;                     // RTC subsecond rate (LSI / 2), calibrated
+	uint64_t asleep_us;                  // total time in Sleep and Stop
+	uint32_t awake_permille;             // last report window
+	Cycle_Stats_t wake_latency;          // CAN wakeup -> first frame handled (DWT cycles)
+} Power_Stats_t;
+
+extern volatile Power_Stats_t power_stats;
+
+void Power_Init(CAN_HandleTypeDef *hcan);
+void Power_Idle(void);
+void Power_Rx_Handled(void);
+void Power_Wake_Isr(void);
+
+#endif /* INC_POWER_H_ */
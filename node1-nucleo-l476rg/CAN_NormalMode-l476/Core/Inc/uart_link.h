@@ -0,0 +1,57 @@
+/*
+ * uart_link.h
+ *
+ * Framed debug link on USART2 (TX DMA, RX DMA receive-to-idle)
+ * Packet: [type][payload...][CRC-16/CCITT-FALSE, LE over type+payload]
+ * Wire:   COBS(packet) 0x00 (link_codec.h)
+ * Host side: tools/can_trace/can_trace.py, tools/can_trace/can_console.py
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_UART_LINK_H_
+#define INC_UART_LINK_H_
+
+#include "main.h"
+#include "link_codec.h"
+
+#define UART_LINK_BAUD            2000000U // exact from a 42 MHz APB1 with 16x oversampling
+#define UART_LINK_TX_SIZE         2048U    // TX byte ring, power of two
+#define UART_LINK_RX_DMA_SIZE     64U      // circular RX DMA buffer
+#define UART_LINK_RX_SIZE         256U     // RX byte ring, power of two
+#define UART_LINK_PAYLOAD_MAX     LINK_PAYLOAD_MAX
+
+/* --- Packet types --- */
+#define UART_LINK_TYPE_CAN        0x01U    // u32 time_us, u32 id | flags, u8 dlc, data[dlc]
+#define UART_LINK_TYPE_TEXT       0x02U    // free-form debug text, no terminator
+#define UART_LINK_TYPE_CMD        0x10U    // host -> node command (console.h)
+#define UART_LINK_TYPE_REPLY      0x11U    // node -> host command reply
+
+/* --- CAN packet id flags --- */
+#define UART_LINK_CAN_EXT         0x80000000U
+#define UART_LINK_CAN_RTR         0x40000000U
+#define UART_LINK_CAN_TX          0x20000000U
+
+typedef struct
+{
+	uint32_t packets;      // packets queued
+	uint32_t dropped;      // packets dropped, TX ring full
+	uint32_t high_water;   // most bytes ever waiting in the ring
+	uint32_t rx_packets;   // valid packets received
+	uint32_t rx_bad;       // COBS/CRC/length errors
+	uint32_t rx_overrun;   // bytes lost, RX ring full or UART error
+} UART_Link_Stats_t;
+
+extern volatile UART_Link_Stats_t uart_link_stats;
+
+void UART_Link_Init(UART_HandleTypeDef *huart);
+uint8_t UART_Link_Send(uint8_t type, const uint8_t *payload, uint32_t len);
+void UART_Link_Text(const char *text);
+void UART_Link_TxCplt(UART_HandleTypeDef *huart);
+void UART_Link_RxEvent(UART_HandleTypeDef *huart, uint16_t Size);
+void UART_Link_RxError(UART_HandleTypeDef *huart);
+const uint8_t *UART_Link_Receive(uint32_t *len);
+uint8_t UART_Link_Tx_Busy(void);
+
+#endif /* INC_UART_LINK_H_ */
@@ -0,0 +1,238 @@
+/*
+ * clock_scale.c
+ *
+ * Operating-point manager (see clock_scale.h)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "clock_scale.h"
+#include "can_if.h"
+#include "uart_link.h"
+#include "poll.h"
+#include "trace.h"
+#include "log.h"
+
+extern UART_HandleTypeDef huart2;
+extern TIM_HandleTypeDef  htimer6;
+extern CAN_HandleTypeDef  hcan1;
+
+volatile Clock_Scale_Stats_t clock_scale_stats;
+
+static const Clock_Point_t points[CLOCK_SCALE_POINT_COUNT] = CLOCK_SCALE_POINTS;
+
+static uint32_t window_tick;
+static uint32_t window_frames;
+static uint32_t target;              // point wanted by the rate policy
+static uint32_t down_windows;        // consecutive windows below the step-down rate
+
+/**
+  * @brief Lowest point whose max_fps covers the frame rate
+  * @retval index into points
+  */
+static uint32_t Clock_Scale_Fit(uint32_t fps)
+{
+	uint32_t i = 0;
+
+	while(i < CLOCK_SCALE_POINT_COUNT - 1U && fps > points[i].max_fps)
+	{
+		i++;
+	}
+	return i;
+}
+
+/**
+  * @brief Nothing on the bus or the link may be lost to the switch
+  * @retval TRUE if the peripherals can be reprogrammed now
+  */
+static uint8_t Clock_Scale_Quiet(void)
+{
+	const uint32_t tme = CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2;
+
+	return (Poll_Quiet_Ms() >= CLOCK_SCALE_QUIET_MS)
+	    && ((hcan1.Instance->TSR & tme) == tme)
+	    && (CAN_IF_Rx_Pending() == FALSE)
+	    && (UART_Link_Tx_Busy() == FALSE);
+}
+
+/**
+  * @brief Reprogram USART2 for UART_LINK_BAUD at the current PCLK1
+  * 16x oversampling needs PCLK1 >= 16 * baud, below that 8x is used.
+  * BRR and OVER8 are only writable with UE = 0; the TX DMA is idle
+  * (Clock_Scale_Quiet), the circular RX DMA resumes when UE is set again.
+  * @retval None
+  */
+static void Clock_Scale_Uart(void)
+{
+	uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+	uint32_t div;
+
+	__HAL_UART_DISABLE(&huart2);
+	if(pclk >= 16U * UART_LINK_BAUD)
+	{
+		huart2.Init.OverSampling = UART_OVERSAMPLING_16;
+		CLEAR_BIT(huart2.Instance->CR1, USART_CR1_OVER8);
+		huart2.Instance->BRR = UART_DIV_SAMPLING16(pclk, UART_LINK_BAUD);
+	}
+	else
+	{
+		huart2.Init.OverSampling = UART_OVERSAMPLING_8;
+		SET_BIT(huart2.Instance->CR1, USART_CR1_OVER8);
+		div = UART_DIV_SAMPLING8(pclk, UART_LINK_BAUD);
+		huart2.Instance->BRR = (div & 0xFFF0U) | ((div & 0x000FU) >> 1U);
+	}
+	__HAL_UART_ENABLE(&huart2);
+}
+
+/**
+  * @brief Move to another operating point
+  * Regulator range 1 is set before the clock goes up and range 2 only after
+  * it came down; HAL_RCC_ClockConfig() orders the flash wait states and
+  * restarts SysTick for the new HCLK.
+  * @retval None
+  */
+static void Clock_Scale_Switch(uint32_t to)
+{
+	const Clock_Point_t *p = &points[to];
+	RCC_OscInitTypeDef osc = {0};
+	RCC_ClkInitTypeDef clk = {0};
+	uint32_t start_us = Trace_Time_Us();
+	uint32_t elapsed;
+
+	if(HAL_CAN_Stop(&hcan1) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	if(p->range == 1U && HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE1) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	/* The PLL can only be reprogrammed while it does not drive SYSCLK */
+	clk.ClockType = RCC_CLOCKTYPE_SYSCLK;
+	clk.SYSCLKSource = RCC_SYSCLKSOURCE_HSE;
+	if(HAL_RCC_ClockConfig(&clk, __HAL_FLASH_GET_LATENCY()) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+	osc.PLL.PLLState = RCC_PLL_ON;
+	osc.PLL.PLLSource = RCC_PLLSOURCE_HSE;
+	osc.PLL.PLLM = 1;
+	osc.PLL.PLLN = p->pll_n;
+	osc.PLL.PLLP = RCC_PLLP_DIV7;
+	osc.PLL.PLLQ = RCC_PLLQ_DIV2;
+	osc.PLL.PLLR = p->pll_r;
+	if(HAL_RCC_OscConfig(&osc) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+	clk.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+	clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+	clk.APB1CLKDivider = RCC_HCLK_DIV1;
+	clk.APB2CLKDivider = RCC_HCLK_DIV1;
+	if(HAL_RCC_ClockConfig(&clk, p->flash_ws) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	if(p->range == 2U && HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE2) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	/* Same bit time from the new kernel clock; filters and IER are kept */
+	hcan1.Init.Prescaler = p->can_brp;
+	hcan1.Init.TimeSeg1 = (uint32_t)(p->can_bs1 - 1U) << CAN_BTR_TS1_Pos;
+	hcan1.Init.TimeSeg2 = (uint32_t)(p->can_bs2 - 1U) << CAN_BTR_TS2_Pos;
+	if(HAL_CAN_Init(&hcan1) != HAL_OK || HAL_CAN_Start(&hcan1) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	Clock_Scale_Uart();
+
+	/* Takes effect at the next update event, the running period ends late or early */
+	htimer6.Init.Prescaler = p->tim_psc;
+	__HAL_TIM_SET_PRESCALER(&htimer6, p->tim_psc);
+
+	elapsed = Trace_Time_Us() - start_us;
+	if(elapsed > clock_scale_stats.switch_us_max)
+	{
+		clock_scale_stats.switch_us_max = elapsed;
+	}
+	clock_scale_stats.switches++;
+	clock_scale_stats.point = to;
+	LOG_INFO(LOG_MOD_APP, "clock %lu Hz (%lu frames/s)", p->sysclk_hz, clock_scale_stats.fps);
+}
+
+/**
+  * @brief Start at the SystemClock_Config() point
+  * @retval None
+  */
+void Clock_Scale_Init(void)
+{
+	clock_scale_stats.point = CLOCK_SCALE_POINT_COUNT - 1U;
+	target = clock_scale_stats.point;
+	window_tick = HAL_GetTick();
+	window_frames = can_if_rx_frames;
+}
+
+/**
+  * @brief Measure the frame rate and change the operating point (main loop context)
+  * @retval None
+  */
+void Clock_Scale_Process(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t elapsed = now - window_tick;
+	uint32_t point = clock_scale_stats.point;
+	uint32_t frames;
+
+	if(elapsed >= CLOCK_SCALE_WINDOW_MS)
+	{
+		frames = can_if_rx_frames;
+		clock_scale_stats.fps = ((frames - window_frames) * 1000U) / elapsed;
+		clock_scale_stats.ms_at[point] += elapsed;
+		window_frames = frames;
+		window_tick = now;
+
+		if(points[point].max_fps != 0U && clock_scale_stats.fps > points[point].max_fps)
+		{
+			target = Clock_Scale_Fit(clock_scale_stats.fps);	// up at once, as far as needed
+			down_windows = 0;
+		}
+		else if(point > 0U && clock_scale_stats.fps < (points[point - 1U].max_fps * 3U) / 4U)
+		{
+			if(++down_windows >= CLOCK_SCALE_DOWN_WINDOWS)
+			{
+				target = point - 1U;					// down one point at a time
+				down_windows = 0;
+			}
+		}
+		else
+		{
+			target = point;
+			down_windows = 0;
+		}
+
+#if CLOCK_SCALE_ENABLE
+		if(target != point && Clock_Scale_Quiet() == FALSE)
+		{
+			clock_scale_stats.deferred++;
+		}
+#endif
+	}
+
+#if CLOCK_SCALE_ENABLE
+	if(target != point && Clock_Scale_Quiet() != FALSE)
+	{
+		Clock_Scale_Switch(target);
+	}
+#endif
+}
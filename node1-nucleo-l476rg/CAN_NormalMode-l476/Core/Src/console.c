@@ -0,0 +1,382 @@
+/*
+ * console.c
+ *
+ * Binary command console on the debug link
+ * - Packets are received by uart_link (RX DMA, idle line) and decoded here
+ *   in the main loop, so commands never run in interrupt context
+ * - Every command gets exactly one reply, including unknown ones
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "console.h"
+#include "can_catalog.h"
+#include "log.h"
+#include "can_diag.h"
+#include "can_if.h"
+#include "it.h"
+#include "publish.h"
+#include "trace.h"
+#include "uart_link.h"
+
+extern TIM_HandleTypeDef htimer6;
+extern CAN_HandleTypeDef hcan1;
+
+static uint16_t console_filters[CONSOLE_FILTERS_MAX];
+
+#if (2U + 6U + (2U * CAN_IF_RX_MODES * CAN_IF_RX_LOAD_BUCKETS)) > LINK_PAYLOAD_MAX
+#error "GET_RX_LOAD reply does not fit a link packet, reduce CAN_IF_RX_LOAD_BUCKETS"
+#endif
+#if (2U + 1U + (20U * PUBLISH_SIGNAL_COUNT)) > LINK_PAYLOAD_MAX
+#error "GET_PUBLISH reply does not fit a link packet"
+#endif
+
+/**
+  * @brief Little-endian field helpers
+  */
+static uint16_t Console_Get_U16(const uint8_t *src)
+{
+	return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static void Console_Put_U16(uint8_t *dst, uint16_t value)
+{
+	dst[0] = (uint8_t)value;
+	dst[1] = (uint8_t)(value >> 8);
+}
+
+static void Console_Put_U32(uint8_t *dst, uint32_t value)
+{
+	dst[0] = (uint8_t)value;
+	dst[1] = (uint8_t)(value >> 8);
+	dst[2] = (uint8_t)(value >> 16);
+	dst[3] = (uint8_t)(value >> 24);
+}
+
+/**
+  * @brief Reprogram the TIM6 period (periodic TX rate)
+  */
+static uint8_t Console_Set_Tx_Period(const uint8_t *args, uint32_t len)
+{
+	uint32_t timer_clk = HAL_RCC_GetPCLK1Freq();
+	uint32_t period_ms;
+	uint32_t reload;
+
+	if(len != 2U)
+	{
+		return CONSOLE_ERR_LENGTH;
+	}
+
+	if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1)
+	{
+		timer_clk *= 2U;	// APB1 timers run at 2x PCLK1 when APB1 is divided
+	}
+
+	period_ms = Console_Get_U16(args);
+	reload = (uint32_t)(((uint64_t)timer_clk / (htimer6.Init.Prescaler + 1U)) * period_ms / 1000U);
+	if(period_ms == 0U || reload == 0U || reload > 0x10000U)
+	{
+		return CONSOLE_ERR_ARG;
+	}
+
+	htimer6.Init.Period = reload - 1U;
+	__HAL_TIM_SET_AUTORELOAD(&htimer6, reload - 1U);
+	__HAL_TIM_SET_COUNTER(&htimer6, 0);
+
+	return CONSOLE_OK;
+}
+
+/**
+  * @brief Replace the CAN1 receive list (exact-match, 16-bit list filters)
+  */
+static uint8_t Console_Set_Filters(const uint8_t *args, uint32_t len)
+{
+	uint32_t count = len / 2U;
+	uint16_t entry;
+	uint32_t i;
+
+	if((len & 1U) != 0U || count > CONSOLE_FILTERS_MAX)
+	{
+		return CONSOLE_ERR_LENGTH;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		entry = Console_Get_U16(&args[2U * i]);
+		if((entry & 0x7800U) != 0U)
+		{
+			return CONSOLE_ERR_ARG;	// not a standard ID
+		}
+		console_filters[i] = CAN_FILTER16(entry & 0x7FFU, (entry >> 15) & 1U);
+	}
+
+	CAN_IF_Config_List_Filters(&hcan1, console_filters, count);
+
+	return CONSOLE_OK;
+}
+
+/**
+  * @brief Set the frame trace level ([level]) or a module log level ([module][level])
+  */
+static uint8_t Console_Set_Log(const uint8_t *args, uint32_t len)
+{
+	if(len == 1U)
+	{
+		if(args[0] > TRACE_LEVEL_FRAMES)
+		{
+			return CONSOLE_ERR_ARG;
+		}
+		trace_level = args[0];
+		return CONSOLE_OK;
+	}
+
+	if(len == 2U)
+	{
+		if((args[0] >= LOG_MOD_COUNT && args[0] != 0xFFU) || args[1] > LOG_LEVEL_DEBUG)
+		{
+			return CONSOLE_ERR_ARG;
+		}
+		Log_Set_Level(args[0], args[1]);
+		return CONSOLE_OK;
+	}
+
+	return CONSOLE_ERR_LENGTH;
+}
+
+/**
+  * @brief Change the CAN1 bit timing: stop, re-init, restart
+  * Filters and interrupt enables survive HAL_CAN_Init(); pending TX is lost.
+  */
+static uint8_t Console_Set_Bit_Timing(const uint8_t *args, uint32_t len)
+{
+	uint32_t prescaler;
+	uint32_t bs1;
+	uint32_t bs2;
+	uint32_t sjw;
+
+	if(len != 5U)
+	{
+		return CONSOLE_ERR_LENGTH;
+	}
+
+	prescaler = Console_Get_U16(args);
+	bs1 = args[2];
+	bs2 = args[3];
+	sjw = args[4];
+	if(prescaler < 1U || prescaler > 1024U || bs1 < 1U || bs1 > 16U ||
+	   bs2 < 1U || bs2 > 8U || sjw < 1U || sjw > 4U)
+	{
+		return CONSOLE_ERR_ARG;
+	}
+
+	if(HAL_CAN_Stop(&hcan1) != HAL_OK)
+	{
+		return CONSOLE_ERR_HAL;
+	}
+
+	hcan1.Init.Prescaler = prescaler;
+	hcan1.Init.TimeSeg1 = (bs1 - 1U) << CAN_BTR_TS1_Pos;
+	hcan1.Init.TimeSeg2 = (bs2 - 1U) << CAN_BTR_TS2_Pos;
+	hcan1.Init.SyncJumpWidth = (sjw - 1U) << CAN_BTR_SJW_Pos;
+
+	if(HAL_CAN_Init(&hcan1) != HAL_OK || HAL_CAN_Start(&hcan1) != HAL_OK)
+	{
+		return CONSOLE_ERR_HAL;
+	}
+
+	return CONSOLE_OK;
+}
+
+/**
+  * @brief Fill the statistics reply
+  * TEC, REC, then u32: bus-off, error passive, error warning, FIFO overrun,
+  * pool high water, alloc failures, RX ring full, link TX packets,
+  * link TX dropped, link RX packets, link RX bad, link RX overrun,
+  * log messages suppressed, log queue full, mean cycles per log line
+  * @retval data length
+  */
+static uint32_t Console_Get_Stats(uint8_t *data)
+{
+	uint32_t esr = hcan1.Instance->ESR;
+	const uint32_t values[] =
+	{
+		can_diag.bus_off, can_diag.error_passive, can_diag.error_warning, can_diag.rx_overrun,
+		frame_pool_stats.high_water, frame_pool_stats.alloc_fail, frame_pool_stats.ring_full,
+		uart_link_stats.packets, uart_link_stats.dropped,
+		uart_link_stats.rx_packets, uart_link_stats.rx_bad, uart_link_stats.rx_overrun,
+		log_stats.suppressed, log_stats.dropped, Cycle_Stats_Mean(&log_stats.format)
+	};
+	uint32_t i;
+
+	data[0] = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+	data[1] = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+	for(i = 0; i < (sizeof(values) / sizeof(values[0])); i++)
+	{
+		Console_Put_U32(&data[2U + (4U * i)], values[i]);
+	}
+
+	return 2U + (4U * i);
+}
+
+/**
+  * @brief Fill the RX load reply (adaptive RX, can_if.h)
+  * Mode, bucket count, bucket width in frames/s, last window's frame rate,
+  * then per mode (interrupt first, polling second) one u16 per bucket:
+  * RX CPU load in 1/1000, 0xFFFF where no window was measured.
+  * @retval data length
+  */
+static uint32_t Console_Get_Rx_Load(uint8_t *data)
+{
+	volatile CAN_IF_Rx_Load_t *load;
+	uint32_t len = 6U;
+	uint32_t permille;
+	uint32_t mode;
+	uint32_t i;
+
+	data[0] = (uint8_t)can_rx_stats.mode;
+	data[1] = (uint8_t)CAN_IF_RX_LOAD_BUCKETS;
+	Console_Put_U16(&data[2], (uint16_t)CAN_IF_RX_LOAD_BUCKET_FPS);
+	Console_Put_U16(&data[4], (uint16_t)can_rx_stats.fps);
+	for(mode = 0; mode < CAN_IF_RX_MODES; mode++)
+	{
+		for(i = 0; i < CAN_IF_RX_LOAD_BUCKETS; i++)
+		{
+			load = &can_rx_stats.load[mode][i];
+			permille = 0xFFFFU;
+			if(load->span_cycles != 0U)
+			{
+				permille = (uint32_t)((load->rx_cycles * 1000U) / load->span_cycles);
+			}
+			Console_Put_U16(&data[len], (uint16_t)permille);
+			len += 2U;
+		}
+	}
+
+	return len;
+}
+
+/**
+  * @brief Fill the CAN ISR cycles reply
+  * Build flags (bit 0 CAN_ISR_IN_RAM, bit 1 CAN_ISR_LEAN), then for the TX,
+  * RX0, RX1 and SCE vectors: entries, min, max and mean DWT cycles per
+  * entry (u16 saturated). Compare a CAN_ISR_LEAN 0 build against a 1 build
+  * to see what the per-vector handlers save.
+  * @retval data length
+  */
+static uint32_t Console_Get_Isr_Cycles(uint8_t *data)
+{
+	volatile Cycle_Stats_t *stats;
+	uint32_t values[3];
+	uint32_t len = 1U;
+	uint32_t i;
+	uint32_t j;
+
+	data[0] = (uint8_t)(CAN_ISR_IN_RAM | (CAN_ISR_LEAN << 1));
+	for(i = 0; i < CAN_ISR_COUNT; i++)
+	{
+		stats = &can_isr_cycles[i];
+		values[0] = stats->min;
+		values[1] = stats->max;
+		values[2] = Cycle_Stats_Mean(stats);
+		Console_Put_U32(&data[len], stats->count);
+		len += 4U;
+		for(j = 0; j < 3U; j++)
+		{
+			Console_Put_U16(&data[len], (uint16_t)((values[j] > 0xFFFFU) ? 0xFFFFU : values[j]));
+			len += 2U;
+		}
+	}
+
+	return len;
+}
+
+/**
+  * @brief Fill the send-on-change reply (publish.h)
+  * Signal count, then per signal: updates, frames sent, refreshes,
+  * suppressed (deadband) and coalesced (min interval) updates.
+  * @retval data length
+  */
+static uint32_t Console_Get_Publish(uint8_t *data)
+{
+	volatile Publish_Stats_t *stats;
+	uint32_t len = 1U;
+	uint32_t i;
+
+	data[0] = (uint8_t)PUBLISH_SIGNAL_COUNT;
+	for(i = 0; i < PUBLISH_SIGNAL_COUNT; i++)
+	{
+		stats = &publish_stats[i];
+		Console_Put_U32(&data[len], stats->updates);
+		Console_Put_U32(&data[len + 4U], stats->sent);
+		Console_Put_U32(&data[len + 8U], stats->refreshes);
+		Console_Put_U32(&data[len + 12U], stats->suppressed);
+		Console_Put_U32(&data[len + 16U], stats->coalesced);
+		len += 20U;
+	}
+
+	return len;
+}
+
+/**
+  * @brief Execute every command received since the last call (main loop context)
+  * @retval None
+  */
+void Console_Poll(void)
+{
+	uint8_t reply[LINK_PAYLOAD_MAX];
+	const uint8_t *packet;
+	uint32_t reply_len;
+	uint32_t len;
+
+	while((packet = UART_Link_Receive(&len)) != NULL)
+	{
+		if(packet[0] != UART_LINK_TYPE_CMD || len < 2U)
+		{
+			continue;	// not a command (or no opcode): nothing to answer
+		}
+
+		reply[0] = packet[1];
+		reply_len = 2U;
+
+		switch(packet[1])
+		{
+		case CONSOLE_OP_PING:
+			reply[1] = CONSOLE_OK;
+			break;
+		case CONSOLE_OP_SET_TX_PERIOD:
+			reply[1] = Console_Set_Tx_Period(&packet[2], len - 2U);
+			break;
+		case CONSOLE_OP_SET_FILTERS:
+			reply[1] = Console_Set_Filters(&packet[2], len - 2U);
+			break;
+		case CONSOLE_OP_SET_LOG:
+			reply[1] = Console_Set_Log(&packet[2], len - 2U);
+			break;
+		case CONSOLE_OP_SET_BITTIMING:
+			reply[1] = Console_Set_Bit_Timing(&packet[2], len - 2U);
+			break;
+		case CONSOLE_OP_GET_STATS:
+			reply[1] = CONSOLE_OK;
+			reply_len += Console_Get_Stats(&reply[2]);
+			break;
+		case CONSOLE_OP_GET_RX_LOAD:
+			reply[1] = CONSOLE_OK;
+			reply_len += Console_Get_Rx_Load(&reply[2]);
+			break;
+		case CONSOLE_OP_GET_ISR_CYCLES:
+			reply[1] = CONSOLE_OK;
+			reply_len += Console_Get_Isr_Cycles(&reply[2]);
+			break;
+		case CONSOLE_OP_GET_PUBLISH:
+			reply[1] = CONSOLE_OK;
+			reply_len += Console_Get_Publish(&reply[2]);
+			break;
+		default:
+			reply[1] = CONSOLE_ERR_OPCODE;
+			break;
+		}
+
+		UART_Link_Send(UART_LINK_TYPE_REPLY, reply, reply_len);
+	}
+}
@@ -0,0 +1,205 @@
+/*
+ * fmt.c
+ *
+ * printf-free text formatting (see fmt.h)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "fmt.h"
+
+#define FMT_DIGITS_MAX  10U      // 4294967295
+
+static const char fmt_hex_upper[] = "0123456789ABCDEF";
+static const char fmt_hex_lower[] = "0123456789abcdef";
+
+/**
+  * @brief Start an empty string in buf
+  * @param size: bytes available in buf, including the terminating NUL
+  * @retval None
+  */
+void Fmt_Init(Fmt_Buf_t *out, char *buf, uint32_t size)
+{
+	out->buf = buf;
+	out->size = size;
+	out->len = 0;
+	if(size != 0U)
+	{
+		buf[0] = '\0';
+	}
+}
+
+/**
+  * @brief Append one character, dropped once the buffer is full
+  * @retval None
+  */
+void Fmt_Char(Fmt_Buf_t *out, char c)
+{
+	if(out->len + 1U < out->size)
+	{
+		out->buf[out->len++] = c;
+		out->buf[out->len] = '\0';
+	}
+}
+
+/**
+  * @brief Append a NUL-terminated string
+  * @retval None
+  */
+void Fmt_Str(Fmt_Buf_t *out, const char *str)
+{
+	while(*str != '\0' && out->len + 1U < out->size)
+	{
+		out->buf[out->len++] = *str++;
+	}
+	if(out->size != 0U)
+	{
+		out->buf[out->len] = '\0';
+	}
+}
+
+/**
+  * @brief Append digits[] (least significant first), padded to width
+  * @retval None
+  */
+static void Fmt_Digits(Fmt_Buf_t *out, const char *digits, uint32_t count, uint32_t width, char pad)
+{
+	while(width > count)
+	{
+		Fmt_Char(out, pad);
+		width--;
+	}
+	while(count != 0U)
+	{
+		Fmt_Char(out, digits[--count]);
+	}
+}
+
+/**
+  * @brief Append an unsigned decimal number
+  * @param width: minimum field width, 0 = none
+  * @param pad: '0' or ' '
+  * @retval None
+  */
+void Fmt_Dec(Fmt_Buf_t *out, uint32_t value, uint32_t width, char pad)
+{
+	char digits[FMT_DIGITS_MAX];
+	uint32_t count = 0;
+
+	do
+	{
+		digits[count++] = (char)('0' + (value % 10U));
+		value /= 10U;
+	} while(value != 0U);
+
+	Fmt_Digits(out, digits, count, width, pad);
+}
+
+/**
+  * @brief Append a hexadecimal number without prefix
+  * @param width: minimum field width, 0 = none
+  * @param pad: '0' or ' '
+  * @param upper: TRUE for A..F
+  * @retval None
+  */
+void Fmt_Hex(Fmt_Buf_t *out, uint32_t value, uint32_t width, char pad, uint8_t upper)
+{
+	const char *hex = (upper != FALSE) ? fmt_hex_upper : fmt_hex_lower;
+	char digits[FMT_DIGITS_MAX];
+	uint32_t count = 0;
+
+	do
+	{
+		digits[count++] = hex[value & 0xFU];
+		value >>= 4;
+	} while(value != 0U);
+
+	Fmt_Digits(out, digits, count, width, pad);
+}
+
+/**
+  * @brief Append a LOG_xxx() format with its two arguments
+  * Conversions take arg0, then arg1, then 0. An unsupported conversion
+  * is copied as written so it shows up in the log instead of misprinting.
+  * @retval None
+  */
+void Fmt_Format(Fmt_Buf_t *out, const char *fmt, uint32_t arg0, uint32_t arg1)
+{
+	const uint32_t args[2] = { arg0, arg1 };
+	const char *spec;
+	uint32_t next = 0;
+	uint32_t width;
+	uint32_t value;
+	char pad;
+
+	while(*fmt != '\0')
+	{
+		if(*fmt != '%')
+		{
+			Fmt_Char(out, *fmt++);
+			continue;
+		}
+
+		spec = fmt++;
+		pad = ' ';
+		width = 0;
+		if(*fmt == '0')
+		{
+			pad = '0';
+			fmt++;
+		}
+		while(*fmt >= '0' && *fmt <= '9')
+		{
+			width = (width * 10U) + (uint32_t)(*fmt++ - '0');
+		}
+		if(*fmt == 'l')
+		{
+			fmt++;
+		}
+
+		value = (next < 2U) ? args[next] : 0U;
+		switch(*fmt)
+		{
+		case 'u':
+			Fmt_Dec(out, value, width, pad);
+			next++;
+			break;
+		case 'd':
+		case 'i':
+			if((int32_t)value < 0)
+			{
+				Fmt_Char(out, '-');
+				value = 0U - value;
+				width = (width != 0U) ? width - 1U : 0U;
+			}
+			Fmt_Dec(out, value, width, pad);
+			next++;
+			break;
+		case 'X':
+		case 'x':
+			Fmt_Hex(out, value, width, pad, (*fmt == 'X') ? TRUE : FALSE);
+			next++;
+			break;
+		case 'c':
+			Fmt_Char(out, (char)value);
+			next++;
+			break;
+		case '%':
+			Fmt_Char(out, '%');
+			break;
+		default:
+			while(spec != fmt && *spec != '\0')
+			{
+				Fmt_Char(out, *spec++);	// unsupported: copy "%..." as written
+			}
+			if(*fmt == '\0')
+			{
+				return;
+			}
+			Fmt_Char(out, *fmt);
+			break;
+		}
+		fmt++;
+	}
+}
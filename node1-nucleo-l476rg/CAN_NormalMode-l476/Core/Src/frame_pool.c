@@ -0,0 +1,132 @@
+/*
+ * frame_pool.c
+ *
+ * Static CAN frame pool and SPSC frame ring
+ * - Allocation/release are short Irq_Lock() critical sections (callable from ISRs)
+ * - The ring is lock-free: one producer (RX ISR), one consumer (main loop)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "frame_pool.h"
+
+volatile Frame_Pool_Stats_t frame_pool_stats;
+
+static CAN_Frame_t frame_pool[FRAME_POOL_SIZE] __CAN_BUFFER;
+static uint8_t     free_list[FRAME_POOL_SIZE] __CAN_BUFFER;   // stack of free slot indices
+static uint32_t    free_count = 0;
+
+/**
+  * @brief Put every frame on the free list
+  * @retval None
+  */
+void Frame_Pool_Init(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < FRAME_POOL_SIZE; i++)
+	{
+		frame_pool[i].refs = 0;
+		frame_pool[i].index = (uint8_t)i;
+		free_list[i] = (uint8_t)i;
+	}
+	free_count = FRAME_POOL_SIZE;
+}
+
+/**
+  * @brief Take a frame from the pool with one reference held by the caller
+  * @retval frame, or NULL when the pool is exhausted (counted in alloc_fail)
+  */
+__CAN_ISR CAN_Frame_t *Frame_Pool_Alloc(void)
+{
+	CAN_Frame_t *frame = NULL;
+	uint32_t basepri = Irq_Lock();
+
+	if(free_count != 0U)
+	{
+		frame = &frame_pool[free_list[--free_count]];
+		frame->refs = 1;
+		if(++frame_pool_stats.in_use > frame_pool_stats.high_water)
+		{
+			frame_pool_stats.high_water = frame_pool_stats.in_use;
+		}
+	}
+	else
+	{
+		frame_pool_stats.alloc_fail++;
+	}
+	Irq_Unlock(basepri);
+
+	return frame;
+}
+
+/**
+  * @brief Take an additional reference (e.g. a handler keeping a frame for retransmit)
+  * @retval None
+  */
+__CAN_ISR void Frame_Pool_Ref(CAN_Frame_t *frame)
+{
+	uint32_t basepri = Irq_Lock();
+
+	frame->refs++;
+	Irq_Unlock(basepri);
+}
+
+/**
+  * @brief Drop one reference; the frame returns to the pool on the last one
+  * @retval None
+  */
+__CAN_ISR void Frame_Pool_Release(CAN_Frame_t *frame)
+{
+	uint32_t basepri = Irq_Lock();
+
+	if(frame->refs != 0U && --frame->refs == 0U)
+	{
+		free_list[free_count++] = frame->index;
+		frame_pool_stats.in_use--;
+	}
+	Irq_Unlock(basepri);
+}
+
+/**
+  * @brief Producer side: enqueue a frame pointer (ownership moves to the ring)
+  * @retval TRUE on success, FALSE if the ring is full (counted in ring_full)
+  */
+__CAN_ISR uint8_t Frame_Ring_Push(Frame_Ring_t *ring, CAN_Frame_t *frame)
+{
+	uint32_t head = ring->head;
+
+	if((head - ring->tail) == FRAME_RING_SIZE)
+	{
+		frame_pool_stats.ring_full++;
+		return FALSE;
+	}
+
+	ring->slot[head & (FRAME_RING_SIZE - 1U)] = frame;
+	__DMB();	// slot must be visible before the new head
+	ring->head = head + 1U;
+
+	return TRUE;
+}
+
+/**
+  * @brief Consumer side: dequeue the oldest frame pointer
+  * @retval frame, or NULL if the ring is empty
+  */
+CAN_Frame_t *Frame_Ring_Pop(Frame_Ring_t *ring)
+{
+	CAN_Frame_t *frame;
+	uint32_t tail = ring->tail;
+
+	if(tail == ring->head)
+	{
+		return NULL;
+	}
+
+	frame = ring->slot[tail & (FRAME_RING_SIZE - 1U)];
+	__DMB();	// read the slot before releasing it to the producer
+	ring->tail = tail + 1U;
+
+	return frame;
+}
@@ -0,0 +1,169 @@
+/*
+ * link_codec.c
+ *
+ * Debug link packet codec
+ * Packet: [type][payload...][CRC-16 LE over type+payload]
+ * Wire:   COBS(packet) 0x00
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "link_codec.h"
+#include <string.h>
+
+/**
+  * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), nibble table
+  */
+uint16_t Link_Crc16(const uint8_t *data, uint32_t len)
+{
+	static const uint16_t table[16] =
+	{
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+		0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+	};
+	uint16_t crc = 0xFFFFU;
+
+	while(len--)
+	{
+		crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (*data >> 4)]);
+		crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (*data & 0x0FU)]);
+		data++;
+	}
+	return crc;
+}
+
+/**
+  * @brief COBS encode src into dst and append the 0x00 delimiter
+  * @retval bytes written to dst
+  */
+uint32_t Link_Cobs_Encode(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	uint32_t code_at = 0;
+	uint32_t out = 1;
+	uint8_t code = 1;
+	uint32_t i;
+
+	for(i = 0; i < len; i++)
+	{
+		if(src[i] != 0U)
+		{
+			dst[out++] = src[i];
+			code++;
+		}
+		if(src[i] == 0U || code == 0xFFU)
+		{
+			dst[code_at] = code;
+			code_at = out++;
+			code = 1;
+		}
+	}
+	dst[code_at] = code;
+	dst[out++] = 0x00;
+
+	return out;
+}
+
+/**
+  * @brief Build the wire form of one packet
+  * @param wire: at least LINK_WIRE_MAX bytes
+  * @retval bytes written, 0 if the payload is too long
+  */
+uint32_t Link_Encode(uint8_t *wire, uint8_t type, const uint8_t *payload, uint32_t len)
+{
+	uint8_t packet[LINK_PACKET_MAX];
+	uint16_t crc;
+
+	if(len > LINK_PAYLOAD_MAX)
+	{
+		return 0;
+	}
+
+	packet[0] = type;
+	memcpy(&packet[1], payload, len);
+	crc = Link_Crc16(packet, len + 1U);
+	packet[len + 1U] = (uint8_t)(crc & 0xFFU);
+	packet[len + 2U] = (uint8_t)(crc >> 8);
+
+	return Link_Cobs_Encode(wire, packet, len + 3U);
+}
+
+/**
+  * @brief Drop any partial packet
+  * @retval None
+  */
+void Link_Rx_Reset(Link_Rx_t *rx)
+{
+	rx->wire_len = 0;
+	rx->overflow = 0;
+	rx->len = 0;
+}
+
+/**
+  * @brief Feed one received byte
+  * @retval LINK_RX_PACKET when a valid packet ends here (rx->packet, rx->len),
+  *         LINK_RX_BAD on a corrupt one, LINK_RX_NONE otherwise
+  */
+uint8_t Link_Rx_Feed(Link_Rx_t *rx, uint8_t byte)
+{
+	uint32_t in = 0;
+	uint32_t out = 0;
+	uint8_t code;
+	uint8_t valid;
+	uint8_t status = LINK_RX_BAD;
+
+	if(byte != 0x00U)
+	{
+		if(rx->wire_len < LINK_WIRE_MAX)
+		{
+			rx->wire[rx->wire_len++] = byte;
+		}
+		else
+		{
+			rx->overflow = 1;
+		}
+		return LINK_RX_NONE;
+	}
+
+	if(rx->wire_len == 0U)
+	{
+		return LINK_RX_NONE;	// back-to-back delimiters
+	}
+
+	valid = (rx->overflow == 0U);
+	if(valid)
+	{
+		while(in < rx->wire_len)
+		{
+			code = rx->wire[in++];
+			if(in + code - 1U > rx->wire_len || out + code - 1U > LINK_PACKET_MAX)
+			{
+				valid = 0;
+				break;
+			}
+			memcpy(&rx->packet[out], &rx->wire[in], code - 1U);
+			out += code - 1U;
+			in += code - 1U;
+			if(code != 0xFFU && in < rx->wire_len)
+			{
+				if(out == LINK_PACKET_MAX)
+				{
+					valid = 0;
+					break;
+				}
+				rx->packet[out++] = 0x00;
+			}
+		}
+
+		if(valid && out >= 3U &&
+		   Link_Crc16(rx->packet, out - 2U) == (uint16_t)(rx->packet[out - 2U] | (rx->packet[out - 1U] << 8)))
+		{
+			rx->len = out - 2U;
+			status = LINK_RX_PACKET;
+		}
+	}
+
+	rx->wire_len = 0;
+	rx->overflow = 0;
+	return status;
+}
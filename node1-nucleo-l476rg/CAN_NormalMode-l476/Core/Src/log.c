@@ -0,0 +1,161 @@
+/*
+ * log.c
+ *
+ * Deferred, rate-limited logging
+ * Log_Emit() may run in any context and only copies a record into the
+ * queue; Log_Process() formats it in the main loop and hands the text to
+ * the debug link.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "log.h"
+#include "trace.h"
+#if LOG_FMT_PRINTF
+#include <stdio.h>
+#else
+#include "fmt.h"
+#endif
+
+typedef struct
+{
+	Log_Site_t *site;
+	uint32_t tick;
+	uint32_t arg[2];
+	uint32_t suppressed;   // calls dropped at this site since its last record
+} Log_Record_t;
+
+volatile uint8_t log_mask[LOG_MOD_COUNT] =
+{
+	LOG_MASK_DEFAULT, LOG_MASK_DEFAULT, LOG_MASK_DEFAULT, LOG_MASK_DEFAULT
+};
+volatile Log_Stats_t log_stats;
+
+static Log_Record_t log_queue[LOG_QUEUE_SIZE];
+static volatile uint32_t log_head = 0;
+static volatile uint32_t log_tail = 0;
+
+static const char *const log_module_name[LOG_MOD_COUNT] = { "app", "can", "diag", "link" };
+static const char log_level_tag[] = { '?', 'E', 'W', 'I', 'D' };
+
+/**
+  * @brief Queue one admitted message (any context)
+  * @retval None
+  */
+__CAN_ISR void Log_Emit(Log_Site_t *site, uint32_t arg0, uint32_t arg1)
+{
+	Log_Record_t *rec;
+	uint32_t basepri = Irq_Lock();
+
+	if((log_head - log_tail) == LOG_QUEUE_SIZE)
+	{
+		log_stats.dropped++;
+		Irq_Unlock(basepri);
+		return;
+	}
+
+	rec = &log_queue[log_head & (LOG_QUEUE_SIZE - 1U)];
+	rec->site = site;
+	rec->tick = uwTick;
+	rec->arg[0] = arg0;
+	rec->arg[1] = arg1;
+	rec->suppressed = site->suppressed;
+	log_stats.suppressed += site->suppressed;
+	site->suppressed = 0;
+	log_head++;
+	log_stats.queued++;
+	Irq_Unlock(basepri);
+}
+
+/**
+  * @brief Records waiting for Log_Process()
+  * @retval TRUE if the queue is not empty
+  */
+uint8_t Log_Pending(void)
+{
+	return (log_tail != log_head) ? TRUE : FALSE;
+}
+
+/**
+  * @brief Enable ERROR .. level for one module (0 disables it), 0xFF = all modules
+  * @retval None
+  */
+void Log_Set_Level(uint8_t module, uint8_t level)
+{
+	uint8_t mask = (level == 0U) ? 0U : LOG_MASK_UPTO(level);
+	uint32_t i;
+
+	for(i = 0; i < LOG_MOD_COUNT; i++)
+	{
+		if(module == 0xFFU || module == i)
+		{
+			log_mask[i] = mask;
+		}
+	}
+}
+
+/**
+  * @brief Format and send every queued record (main loop context)
+  * @retval None
+  */
+void Log_Process(void)
+{
+	char line[96];
+	const uint32_t room = sizeof(line) - 2U;	// keep space for "\r\n"
+	Log_Record_t rec;
+	uint32_t start;
+	uint32_t len;
+#if !LOG_FMT_PRINTF
+	Fmt_Buf_t out;
+#endif
+
+	while(log_tail != log_head)
+	{
+		rec = log_queue[log_tail & (LOG_QUEUE_SIZE - 1U)];
+		__DMB();	// copy the record before handing the slot back
+		log_tail++;
+
+		start = Cycles_Now();
+#if LOG_FMT_PRINTF
+		len = (uint32_t)snprintf(line, room, "%lu %c %s: ", (unsigned long)rec.tick,
+				log_level_tag[rec.site->level], log_module_name[rec.site->module]);
+		if(len < room)
+		{
+			len += (uint32_t)snprintf(&line[len], room - len, rec.site->fmt,
+					(unsigned long)rec.arg[0], (unsigned long)rec.arg[1]);
+		}
+		if(len < room && rec.suppressed != 0U)
+		{
+			len += (uint32_t)snprintf(&line[len], room - len, " (suppressed %lu)",
+					(unsigned long)rec.suppressed);
+		}
+		if(len > room - 1U)
+		{
+			len = room - 1U;	// truncated
+		}
+#else
+		Fmt_Init(&out, line, room);
+		Fmt_Dec(&out, rec.tick, 0, ' ');
+		Fmt_Char(&out, ' ');
+		Fmt_Char(&out, log_level_tag[rec.site->level]);
+		Fmt_Char(&out, ' ');
+		Fmt_Str(&out, log_module_name[rec.site->module]);
+		Fmt_Str(&out, ": ");
+		Fmt_Format(&out, rec.site->fmt, rec.arg[0], rec.arg[1]);
+		if(rec.suppressed != 0U)
+		{
+			Fmt_Str(&out, " (suppressed ");
+			Fmt_Dec(&out, rec.suppressed, 0, ' ');
+			Fmt_Char(&out, ')');
+		}
+		len = out.len;		// at most room - 1, truncated
+#endif
+		line[len++] = '\r';
+		line[len++] = '\n';
+		line[len] = '\0';
+		Cycle_Stats_Add(&log_stats.format, start);
+
+		Trace_Text(line);
+	}
+}
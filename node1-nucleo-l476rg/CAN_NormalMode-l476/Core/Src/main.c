@@ -4,8 +4,10 @@
  * STM32 CAN Communication (Node1 - NUCLEO-L476RG)
  *
  * Role of Node1:
- *   - Send LED command (Data Frame, ID=0x65D, 1 byte payload) every 1 second
- *   - Send Remote Frame (ID=0x651) every 4 seconds requesting 2 bytes of data
+ *   - Send LED command (Data Frame, CAN_ID_LED_CMD, 1 byte payload) on change,
+ *     at most every 50 ms and at least every 5 s (publish.h)
+ *   - Poll slaves 1..NODE_SLAVES for CAN_SENSOR_DATA with remote frames (poll.h)
+ *   - IDs, DLCs and byte layouts come from can_catalog.h (tools/can_catalog)
  *   - Blink onboard LED on each transmission
  *   - Print debug info via UART2
  *
@@ -14,17 +16,30 @@
  */
 
 #include "main.h"
-#include <stdio.h>
-#include <string.h>
+#include "can_diag.h"
+#include "can_if.h"
+#include "can_catalog.h"
+#include "cycles.h"
+#include "uart_link.h"
+#include "trace.h"
+#include "console.h"
+#include "log.h"
+#include "publish.h"
+#include "node_id.h"
+#include "power.h"
+#include "clock_scale.h"
+#include "poll.h"
 
 /* --- Peripheral handles --- */
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef  hdma_usart2_tx;
+DMA_HandleTypeDef  hdma_usart2_rx;
 TIM_HandleTypeDef  htimer6;
 CAN_HandleTypeDef  hcan1;
 
 /* --- Global vars --- */
-uint8_t req_counter = 0;  // counts 1s ticks, sends remote frame every 4s
 uint8_t led_no = 0;       // rotates LED number 1-4
+uint32_t led_cmd_dropped = 0;	// LED commands without a free TX mailbox (PUBLISH_ENABLE 0)
 
 /* --- Function prototypes --- */
 void SystemClock_Config(void);
@@ -35,7 +50,6 @@ void CAN1_Init(void);
 void CAN_Filter_Config(void);
 void Error_Handler(void);
 void CAN1_Tx(void);
-void CAN1_Request(void);
 
 
 /**
@@ -45,16 +59,22 @@ void CAN1_Request(void);
 int main()
 {
 	HAL_Init();              // Reset peripherals, init HAL library
+	Cycles_Init();           // DWT cycle counter for ISR timing
 	SystemClock_Config();    // Configure system clock (HSE + PLL)
+	Node_Id_Init();          // master: NODE_ID_MASTER
 	GPIO_Init();             // Init LED + push button
 	UART2_Init();            // UART for debug prints
 	TIMER6_Init();           // 1 Hz periodic timer
 	CAN1_Init();             // Init CAN peripheral
-	CAN_Filter_Config();     // Accept all messages
+	CAN_Filter_Config();     // Accept catalogue RX list only
+	CAN_IF_Init();           // Frame pool + RX ring
+	Publish_Init();          // send-on-change signals (LED command)
 
-	/* Enable CAN interrupts (TX complete, RX pending, Bus-Off detection) */
+	/* Enable CAN interrupts (TX complete, RX pending, error/status for diagnostics) */
 	if(HAL_CAN_ActivateNotification(&hcan1,
-			CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_BUSOFF) != HAL_OK)
+			CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_BUSOFF |
+			CAN_IT_ERROR_WARNING | CAN_IT_ERROR_PASSIVE | CAN_IT_LAST_ERROR_CODE |
+			CAN_IT_ERROR | CAN_IT_RX_FIFO0_OVERRUN) != HAL_OK)
 	{
 		Error_Handler();
 	}
@@ -64,9 +84,23 @@ int main()
 	{
 		Error_Handler();
 	}
+	Power_Init(&hcan1);			// wake sources for POWER_LEVEL
+	Clock_Scale_Init();			// starts at the SystemClock_Config() point
 
-	/* Main loop (all work handled in ISRs & callbacks) */
-	while(1);
+	/* Main loop (ISRs only queue frames, handling happens here) */
+	while(1)
+	{
+		CAN_IF_Poll(&hcan1);		// dispatch received frames
+#if PUBLISH_ENABLE
+		Publish_Process();			// send-on-change signals: changes, refreshes
+#endif
+		Poll_Process();				// slave requests: timeouts, retries, refill the window
+		CAN_Diag_Process(&hcan1);	// publish error counters on the diagnostics ID
+		Console_Poll();				// execute host commands received on UART2
+		Clock_Scale_Process();		// follow the frame rate with SYSCLK and regulator range
+		Log_Process();				// format deferred log records
+		Power_Idle();				// sleep until the next interrupt if nothing is queued
+	}
 
 	return 0;
 }
@@ -146,14 +180,14 @@ void GPIO_Init(void)
 }
 
 /**
-  * @brief Configure UART2 (115200 baud, 8N1)
-  * Used for debug messages printed to serial terminal
+  * @brief Configure UART2 (UART_LINK_BAUD, 8N1) with TX and RX DMA
+  * Carries the framed debug link (uart_link.h)
   * @retval None
   */
 void UART2_Init(void)
 {
 	huart2.Instance = USART2;
-	huart2.Init.BaudRate = 115200;
+	huart2.Init.BaudRate = UART_LINK_BAUD;
 	huart2.Init.WordLength = UART_WORDLENGTH_8B;
 	huart2.Init.StopBits = UART_STOPBITS_1;
 	huart2.Init.Parity = UART_PARITY_NONE;
@@ -163,6 +197,7 @@ void UART2_Init(void)
 //		There is a problem
 		Error_Handler();
 	}
+	UART_Link_Init(&huart2);		// also starts the command receiver
 }
 
 /**
@@ -191,8 +226,12 @@ void CAN1_Init(void)
 	hcan1.Instance = CAN1;
 	hcan1.Init.Mode = CAN_MODE_NORMAL;
 	hcan1.Init.AutoBusOff = ENABLE;
+#if CAN_IF_TX_ONESHOT
+	hcan1.Init.AutoRetransmission = DISABLE;	// NART: a lost attempt ends the request (can_if.h)
+#else
 	hcan1.Init.AutoRetransmission = ENABLE;
-	hcan1.Init.AutoWakeUp = DISABLE;
+#endif
+	hcan1.Init.AutoWakeUp = ENABLE;		// bus activity ends bxCAN sleep (power.c)
 	hcan1.Init.ReceiveFifoLocked = DISABLE;
 	hcan1.Init.TimeTriggeredMode = DISABLE;
 	hcan1.Init.TransmitFifoPriority = DISABLE;
@@ -210,27 +249,15 @@ void CAN1_Init(void)
 
 /**
   * @brief Configure CAN filters
-  * - Accept all IDs (mask = 0x0000)
+  * - Exact-match list of the IDs node1 receives (CAN_NODE1_RX_FILTERS)
   * - Route to FIFO0
   * @retval None
   */
 void CAN_Filter_Config(void)
 {
-	CAN_FilterTypeDef can1_filter_init;
-	can1_filter_init.FilterActivation = CAN_FILTER_ENABLE;
-	can1_filter_init.FilterBank = 0;
-	can1_filter_init.FilterFIFOAssignment = CAN_FILTER_FIFO0;
-	can1_filter_init.FilterIdHigh = 0x0000;
-	can1_filter_init.FilterIdLow = 0x0000;
-	can1_filter_init.FilterMaskIdHigh = 0x0000;
-	can1_filter_init.FilterMaskIdLow = 0x0000;
-	can1_filter_init.FilterMode = CAN_FILTERMODE_IDMASK;
-	can1_filter_init.FilterScale = CAN_FILTERSCALE_32BIT;
-
-	if(HAL_CAN_ConfigFilter(&hcan1, &can1_filter_init) != HAL_OK)
-	{
-		Error_Handler();
-	}
+	static const uint16_t rx_filters[CAN_NODE1_RX_COUNT] = CAN_NODE1_RX_FILTERS;
+
+	CAN_IF_Config_List_Filters(&hcan1, rx_filters, CAN_NODE1_RX_COUNT);
 }
 
 /* ---------------- CAN FUNCTIONS ---------------- */
@@ -238,156 +265,227 @@ void CAN_Filter_Config(void)
 /**
   * @brief Transmit LED command
   *
-  * CAN ID: 0x65D
+  * CAN ID: CAN_ID_LED_CMD (0x65D)
   * DLC: 1
-  * Payload: LED number (0–3)
+  * Payload: LED number (1–4)
   *
   * Node2 will blink corresponding LED upon reception
+  * With PUBLISH_ENABLE the value only goes to the publisher (TIM6 context),
+  * which sends it from the main loop.
   * @retval None
   */
 void CAN1_Tx(void)
 {
-	CAN_TxHeaderTypeDef TxHeader;
-	uint32_t TxMailbox;
-
-	uint8_t message;
-
-	TxHeader.DLC = 1;
-	TxHeader.StdId = 0x65D;
-	TxHeader.IDE = CAN_ID_STD;
-	TxHeader.RTR = CAN_RTR_DATA;
-
-	message = ++led_no;
+	uint8_t next = ++led_no;
+#if !PUBLISH_ENABLE
+	CAN_Frame_t *frame;
+#endif
 
 	if(led_no == 4)
 	{
 		led_no = 0;	 // wrap around
 	}
 
-	HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);  // blink onboard LED for debug
+	HAL_GPIO_TogglePin(GPIOA,GPIO_PIN_5);  // blink onboard LED for debug
 
-	if(HAL_CAN_AddTxMessage(&hcan1, &TxHeader, &message, &TxMailbox) != HAL_OK)
+#if PUBLISH_ENABLE
+	Publish_Set(PUBLISH_SIGNAL_LED_CMD, next);	// the main loop decides whether it goes on the bus
+#else
+	frame = Frame_Pool_Alloc();
+	if(frame == NULL)
 	{
-		Error_Handler();
+		return;	 // pool exhausted, counted in frame_pool_stats
 	}
 
+	(void)Publish_Fill_Callback(PUBLISH_SIGNAL_LED_CMD, next, frame);
+
+	if(CAN_IF_Send(&hcan1, frame) != HAL_OK)
+	{
+		led_cmd_dropped++;	// mailboxes busy (or only the reserved one free): the next tick sends the next one
+	}
+
+	Frame_Pool_Release(frame);
+#endif
 }
 
 /**
-  * @brief Send Remote Frame to request 2 bytes from Node2
-  *
-  * CAN ID: 0x651
-  * DLC: 2 (requesting 2 bytes)
-  * RTR: Remote
-  * @retval None
+  * @brief Build the frame of a published signal (publish.h)
+  * @retval FALSE for an unknown signal
   */
-void CAN1_Request(void)
+uint8_t Publish_Fill_Callback(uint32_t signal, int32_t value, CAN_Frame_t *frame)
 {
-	CAN_TxHeaderTypeDef TxHeader;
-	uint32_t TxMailbox;
-
-//	no meaning for remote frame
-	uint8_t message = 0;
+	CAN_LED_CMD_t cmd;
 
-//  node1 demanding 2 bybtes of reply
-	TxHeader.DLC = 2;
-	TxHeader.StdId = 0x651;
-	TxHeader.IDE = CAN_ID_STD;
-	TxHeader.RTR = CAN_RTR_REMOTE;
-
-	if(HAL_CAN_AddTxMessage(&hcan1, &TxHeader, &message, &TxMailbox) != HAL_OK)
+	switch(signal)
 	{
-		Error_Handler();
+	case PUBLISH_SIGNAL_LED_CMD:
+		CAN_IF_Frame_Std(frame, CAN_ID_LED_CMD, CAN_RTR_DATA, CAN_DLC_LED_CMD);
+		cmd.led_no = (uint8_t)value;
+		CAN_LED_CMD_Pack(frame->data, &cmd);
+		return TRUE;
+	default:
+		return FALSE;
 	}
-
-
 }
 
 /* ---------------- CALLBACKS ---------------- */
 
 /**
-  * @brief UART debug print on TX complete via Mailbox0
+  * @brief Mailbox0 sent its frame (completion event, can_if.c)
   */
 void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "Message Transmitted from Mailbox0\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
-	// NOTE: Currently using blocking UART transmit for simplicity.
-	// In production, HAL_UART_Transmit_IT() (non-blocking) would be preferred.
+	CAN_IF_Tx_Isr(hcan, 0, CAN_IF_TX_SENT);
 }
 
 /**
-  * @brief UART debug print on TX complete via Mailbox1
+  * @brief Mailbox1 sent its frame (completion event, can_if.c)
   */
 void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "Message Transmitted from Mailbox1\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+	CAN_IF_Tx_Isr(hcan, 1, CAN_IF_TX_SENT);
 }
 
 /**
-  * @brief UART debug print on TX complete via Mailbox2
+  * @brief Mailbox2 sent its frame (completion event, can_if.c)
   */
 void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "Message Transmitted from Mailbox2\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+	CAN_IF_Tx_Isr(hcan, 2, CAN_IF_TX_SENT);
+}
+
+/**
+  * @brief Mailbox0 aborted at its deadline (completion event, can_if.c)
+  */
+void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_Tx_Isr(hcan, 0, CAN_IF_TX_ABORTED);
+}
+
+/**
+  * @brief Mailbox1 aborted at its deadline (completion event, can_if.c)
+  */
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_Tx_Isr(hcan, 1, CAN_IF_TX_ABORTED);
+}
+
+/**
+  * @brief Mailbox2 aborted at its deadline (completion event, can_if.c)
+  */
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_Tx_Isr(hcan, 2, CAN_IF_TX_ABORTED);
+}
+
+/**
+  * @brief UART2 TX DMA transfer finished → start the next one
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	UART_Link_TxCplt(huart);
+}
+
+/**
+  * @brief UART2 RX idle line / DMA wrap → hand the new bytes to the link
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	UART_Link_RxEvent(huart, Size);
+}
+
+/**
+  * @brief UART2 error → restart the command receiver
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	UART_Link_RxError(huart);
 }
 
 /**
   * @brief Callback when a CAN frame is received in FIFO0
+  * Only moves the frame into the RX ring; decoding runs in the main loop.
+  */
+__CAN_ISR void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_RxIsr(hcan, CAN_RX_FIFO0);
+}
+
+/**
+  * @brief FIFO0 full, only armed while CAN_IF_Poll() polls FIFO0 (ISR context)
+  */
+__CAN_ISR void HAL_CAN_RxFifo0FullCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_Rx_Full_Isr(hcan);
+}
+
+/**
+  * @brief Handle a received CAN frame (main loop context)
   *
-  * - If Data Frame with ID 0x65D → extract LED command and update LEDs.
-  * - If Remote Frame with ID 0x651 → send a 2-byte response back.
-  * - If Data Frame with ID 0x651 → treat as reply (for debugging).
-  * - Debug messages are printed via UART2.
+  * - If Data Frame with ID CAN_ID_SENSOR_DATA_NODE(n) → reply from slave n.
+  * - If Data Frame with ID CAN_ID_SENSOR_SUMMARY_NODE(n) → window summary from slave n.
+  * - Debug messages go through the deferred log (log.h).
   */
-void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
+void CAN_IF_RxCallback(CAN_Frame_t *frame)
 {
-	CAN_RxHeaderTypeDef RxHeader;
-	uint8_t rcvd_message[5];
-	char msg[50];
+	CAN_SENSOR_DATA_t reply;
+	CAN_SENSOR_SUMMARY_t summary;
+	uint32_t node = frame->header.StdId - CAN_ID_SENSOR_DATA;
+	uint32_t summary_node = frame->header.StdId - CAN_ID_SENSOR_SUMMARY;
 
-	if(HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &RxHeader, rcvd_message) != HAL_OK)
+	if(frame->header.RTR != CAN_RTR_DATA)
 	{
-		Error_Handler();
+		return;
 	}
 
-	if(RxHeader.StdId == 0x651 && RxHeader.RTR == CAN_RTR_DATA)
+	if(node >= 1U && node <= NODE_ID_MAX)
+	{
+		CAN_SENSOR_DATA_Unpack(&reply, frame->data);
+		Poll_Reply(frame->header.StdId);
+		LOG_DEBUG(LOG_MOD_APP, "Reply from node %lu: 0X%lX", node, reply.value);
+	}
+	else if(summary_node >= 1U && summary_node <= CAN_SENSOR_SUMMARY_NODES)
 	{
-		sprintf(msg, "Reply Received: 0X%X\r\n", rcvd_message[0] << 8 | rcvd_message[1]);
+		CAN_SENSOR_SUMMARY_Unpack(&summary, frame->data);
+		LOG_DEBUG(LOG_MOD_APP, "Summary from node %lu: mean 0X%lX", summary_node, summary.mean);
 	}
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+}
 
+/**
+  * @brief Completion of a frame sent with CAN_IF_Send_Tracked() (main loop context)
+  * Only the poll engine tracks its requests.
+  */
+void CAN_IF_TxCallback(const CAN_IF_Tx_Event_t *event)
+{
+	Poll_Tx_Done(event);
 }
 
 /**
   * @brief TIM6 periodic interrupt callback
   *
   * Every tick (1 second):
-  *   - Send LED command
-  * Every 4th tick:
-  *   - Send Remote Frame request
+  *   - Next LED command (broadcast, every slave accepts CAN_ID_LED_CMD),
+  *     sent from the main loop by Publish_Process()
+  * Sensor requests are scheduled by Poll_Process() in the main loop.
   */
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
 	CAN1_Tx();
-
-	if(++req_counter == 4)
-	{
-		CAN1_Request();
-		req_counter = 0;
-	}
 }
 
-void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
+/**
+  * @brief CAN error callback
+  *
+  * With CAN_ISR_LEAN 1 the per-vector handlers in it.c have decoded their
+  * own flags (TSR on TX, RFxR on RX0/RX1, ESR on SCE) into hcan->ErrorCode;
+  * with CAN_ISR_LEAN 0 HAL_CAN_IRQHandler does the same for all of them.
+  * Only the counters are updated here; they are published from the main loop.
+  */
+__CAN_ISR void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "CAN Error Detected\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+	CAN_Diag_Record(HAL_CAN_GetError(hcan));
+	CAN_IF_Tx_Error_Isr(hcan, HAL_CAN_GetError(hcan));	// mailboxes that ended unsent
+	HAL_CAN_ResetError(hcan);
 }
 
 /**
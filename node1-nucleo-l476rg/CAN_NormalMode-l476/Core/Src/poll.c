@@ -0,0 +1,389 @@
+/*
+ * poll.c
+ *
+ * Slave polling engine (node1, master)
+ * - Poll_Process(): main loop, expires timeouts and fills the request window
+ * - Poll_Reply():   called from CAN_IF_RxCallback for every slave reply
+ * - Poll_Tx_Done():  called from CAN_IF_TxCallback when a request left its
+ *                    mailbox: the reply timeout runs from then, a request
+ *                    that never went out is retried at once
+ * Both run in main loop context, so the in-flight table needs no locking.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "poll.h"
+#include "can_if.h"
+#include "trace.h"
+#include "log.h"
+
+#define POLL_REPORT_MS    1000U      // sweep time log period
+
+/* TX deadline of a request still waiting for the bus */
+#if POLL_MODE == POLL_MODE_PIPELINED
+#define POLL_REQUEST_DEADLINE_MS  (POLL_TIMEOUT_US / 1000U + 1U)   // a retry replaces it
+#else
+#define POLL_REQUEST_DEADLINE_MS  POLL_PERIOD_MS                   // the next broadcast replaces it
+#endif
+
+extern CAN_HandleTypeDef hcan1;
+
+volatile Poll_Stats_t poll_stats;
+
+static uint32_t period_tick = 0;     // start of the current sweep / broadcast
+static uint8_t  started = FALSE;
+
+#if POLL_MODE == POLL_MODE_PIPELINED
+/* In-flight requests, open addressing on the reply ID (0 = empty slot).
+ * Slave IDs are consecutive, so the low bits alone spread them evenly. */
+typedef struct
+{
+	uint16_t id;
+	uint8_t  retries;
+	uint32_t sent_us;                    // queued, then on the bus (Poll_Tx_Done)
+	uint32_t token;                      // CAN_IF_Send_Tracked(), 0 once completed
+} Poll_Entry_t;
+
+static Poll_Entry_t table[POLL_TABLE_SIZE];
+static uint32_t outstanding = 0;
+static uint32_t next_node = NODE_SLAVES + 1U;   // > NODE_SLAVES: no more requests this sweep
+static uint32_t cycle_start_us = 0;
+static uint8_t  sweeping = FALSE;                // sweep started, cycle time not yet taken
+static uint32_t report_tick = 0;
+#else
+#define POLL_ALL_SLAVES   ((0xFFFFFFFFUL >> (32U - NODE_SLAVES)) << 1)   // bit n = node n
+static uint32_t seen = 0;            // slaves that answered the last broadcast
+#endif
+
+/**
+  * @brief Send one remote request for CAN_SENSOR_DATA
+  * @param token: NULL, or receives the request's TX completion token
+  * @retval HAL_OK, or the CAN_IF_Send_Tracked() status if the TX path is busy
+  */
+static HAL_StatusTypeDef Poll_Request(uint32_t StdId, uint32_t *token)
+{
+	CAN_Frame_t *frame = Frame_Pool_Alloc();
+	HAL_StatusTypeDef status;
+
+	if(frame == NULL)
+	{
+		return HAL_BUSY;
+	}
+
+	CAN_IF_Frame_Std(frame, StdId, CAN_RTR_REMOTE, CAN_DLC_SENSOR_DATA);
+	CAN_IF_Frame_Deadline(frame, POLL_REQUEST_DEADLINE_MS);
+
+	status = CAN_IF_Send_Tracked(&hcan1, frame, token);
+	if(status == HAL_OK)
+	{
+		poll_stats.requests++;
+	}
+	else
+	{
+		poll_stats.tx_busy++;
+	}
+
+	Frame_Pool_Release(frame);
+	return status;
+}
+
+#if POLL_MODE == POLL_MODE_PIPELINED
+/**
+  * @brief Find the table slot holding a reply ID
+  * @retval slot index, or POLL_TABLE_SIZE if the ID is not in flight
+  */
+static uint32_t Poll_Find(uint32_t id)
+{
+	uint32_t i = id & (POLL_TABLE_SIZE - 1U);
+
+	while(table[i].id != 0U)
+	{
+		if(table[i].id == id)
+		{
+			return i;
+		}
+		i = (i + 1U) & (POLL_TABLE_SIZE - 1U);
+	}
+	return POLL_TABLE_SIZE;
+}
+
+/**
+  * @brief Insert a reply ID (the table always has a free slot, size >= 2 * K)
+  */
+static void Poll_Insert(uint32_t id, uint32_t now_us, uint32_t token)
+{
+	uint32_t i = id & (POLL_TABLE_SIZE - 1U);
+
+	while(table[i].id != 0U)
+	{
+		i = (i + 1U) & (POLL_TABLE_SIZE - 1U);
+	}
+	table[i].id = (uint16_t)id;
+	table[i].retries = 0;
+	table[i].sent_us = now_us;
+	table[i].token = token;
+	outstanding++;
+}
+
+/**
+  * @brief Remove a slot, shifting back later entries of the same probe run
+  * (no tombstones, so lookups never degrade)
+  */
+static void Poll_Remove(uint32_t i)
+{
+	uint32_t j = i;
+	uint32_t home;
+
+	table[i].id = 0;
+	outstanding--;
+
+	while(1)
+	{
+		j = (j + 1U) & (POLL_TABLE_SIZE - 1U);
+		if(table[j].id == 0U)
+		{
+			return;
+		}
+		home = table[j].id & (POLL_TABLE_SIZE - 1U);
+		/* move j into the hole unless its home lies cyclically in (i, j] */
+		if(((j - home) & (POLL_TABLE_SIZE - 1U)) >= ((j - i) & (POLL_TABLE_SIZE - 1U)))
+		{
+			table[i] = table[j];
+			table[j].id = 0;
+			i = j;
+		}
+	}
+}
+
+/**
+  * @brief Retry or give up on requests older than POLL_TIMEOUT_US
+  */
+static void Poll_Expire(uint32_t now_us)
+{
+	uint32_t token;
+	uint32_t i;
+
+	for(i = 0; i < POLL_TABLE_SIZE; i++)
+	{
+		if(table[i].id == 0U || (now_us - table[i].sent_us) < POLL_TIMEOUT_US)
+		{
+			continue;
+		}
+
+		if(table[i].retries < POLL_RETRIES)
+		{
+			if(Poll_Request(table[i].id, &token) == HAL_OK)
+			{
+				table[i].retries++;
+				table[i].sent_us = now_us;
+				table[i].token = token;
+				poll_stats.retries++;
+			}
+		}
+		else
+		{
+			poll_stats.missed++;
+			LOG_WARN(LOG_MOD_APP, "node %lu silent after %lu retries",
+					table[i].id - CAN_ID_SENSOR_DATA, (uint32_t)POLL_RETRIES);
+			Poll_Remove(i);
+			i--;	// slot i may now hold a shifted entry
+		}
+	}
+}
+
+/**
+  * @brief Run the sweep: expire, refill the window, close the cycle
+  * @retval None
+  */
+void Poll_Process(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t now_us = Trace_Time_Us();
+	uint32_t elapsed;
+	uint32_t token;
+
+	Poll_Expire(now_us);
+
+	if(next_node > NODE_SLAVES && outstanding == 0U)
+	{
+		if(sweeping)
+		{
+			elapsed = now_us - cycle_start_us;
+			poll_stats.cycle_us = elapsed;
+			if(elapsed > poll_stats.cycle_us_max)
+			{
+				poll_stats.cycle_us_max = elapsed;
+			}
+			poll_stats.cycles++;
+			sweeping = FALSE;
+		}
+
+		if(started && (now - period_tick) < POLL_PERIOD_MS)
+		{
+			return;
+		}
+		started = TRUE;
+		period_tick = now;
+		next_node = 1;
+		cycle_start_us = now_us;
+		sweeping = TRUE;
+	}
+
+	while(outstanding < POLL_OUTSTANDING && next_node <= NODE_SLAVES)
+	{
+		if(Poll_Request(CAN_ID_SENSOR_DATA_NODE(next_node), &token) != HAL_OK)
+		{
+			break;	// mailboxes full, refill on the next pass
+		}
+		Poll_Insert(CAN_ID_SENSOR_DATA_NODE(next_node), now_us, token);
+		next_node++;
+	}
+
+	if((now - report_tick) >= POLL_REPORT_MS && poll_stats.cycles != 0U)
+	{
+		report_tick = now;
+		LOG_INFO(LOG_MOD_APP, "poll sweep %lu us (max %lu us)", poll_stats.cycle_us, poll_stats.cycle_us_max);
+	}
+}
+
+/**
+  * @brief Time until the next request, if no reply is outstanding
+  * @retval ms until the next sweep starts, 0 while a sweep is running
+  */
+uint32_t Poll_Quiet_Ms(void)
+{
+	uint32_t elapsed = HAL_GetTick() - period_tick;
+
+	if(!started || next_node <= NODE_SLAVES || outstanding != 0U || elapsed >= POLL_PERIOD_MS)
+	{
+		return 0U;
+	}
+	return POLL_PERIOD_MS - elapsed;
+}
+
+/**
+  * @brief Match a reply to its in-flight request
+  * @param StdId: CAN_ID_SENSOR_DATA_NODE(n)
+  * @retval None
+  */
+void Poll_Reply(uint32_t StdId)
+{
+	uint32_t i = Poll_Find(StdId);
+	uint32_t elapsed;
+
+	if(i == POLL_TABLE_SIZE)
+	{
+		poll_stats.unexpected++;
+		return;
+	}
+
+	elapsed = Trace_Time_Us() - table[i].sent_us;
+	if(elapsed > poll_stats.reply_us_max)
+	{
+		poll_stats.reply_us_max = elapsed;
+	}
+	poll_stats.replies++;
+	Poll_Remove(i);
+}
+
+/**
+  * @brief A request left its mailbox (CAN_IF_TxCallback, main loop context)
+  * Sent: the timeout restarts at the TX time, so time spent queued behind
+  * other frames is not taken from the slave. Aborted or failed: the slave
+  * never saw it, the entry is made due for Poll_Expire() at once.
+  * @retval None
+  */
+void Poll_Tx_Done(const CAN_IF_Tx_Event_t *event)
+{
+	uint32_t i;
+
+	for(i = 0; i < POLL_TABLE_SIZE; i++)
+	{
+		if(table[i].id == 0U || table[i].token != event->token)
+		{
+			continue;
+		}
+
+		table[i].token = 0;
+		if(event->result == CAN_IF_TX_SENT)
+		{
+			table[i].sent_us = event->time_us;
+		}
+		else
+		{
+			table[i].sent_us = event->time_us - POLL_TIMEOUT_US;
+			poll_stats.tx_lost++;
+		}
+		return;
+	}
+}
+
+#else /* POLL_MODE_BROADCAST */
+
+/**
+  * @brief One broadcast request per period; count slaves silent in the last one
+  * @retval None
+  */
+void Poll_Process(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t silent = POLL_ALL_SLAVES & ~seen;
+
+	if(started && (now - period_tick) < POLL_PERIOD_MS)
+	{
+		return;
+	}
+
+	if(started)
+	{
+		if(silent != 0U)
+		{
+			poll_stats.missed += (uint32_t)__builtin_popcount(silent);
+			LOG_WARN(LOG_MOD_APP, "no reply from nodes 0x%08lX (bit = node ID)", silent, 0);
+		}
+		poll_stats.cycle_us = (now - period_tick) * 1000U;
+		poll_stats.cycles++;
+	}
+
+	started = TRUE;
+	seen = 0;
+	period_tick = now;
+	Poll_Request(CAN_ID_SENSOR_DATA, NULL);	// slaves answer in their reply slot
+}
+
+/**
+  * @brief Mark a slave as answered in the current period
+  * @param StdId: CAN_ID_SENSOR_DATA_NODE(n)
+  * @retval None
+  */
+void Poll_Reply(uint32_t StdId)
+{
+	seen |= 1UL << (StdId - CAN_ID_SENSOR_DATA);
+	poll_stats.replies++;
+}
+
+/**
+  * @brief Broadcast requests are sent untracked, nothing to do
+  * @retval None
+  */
+void Poll_Tx_Done(const CAN_IF_Tx_Event_t *event)
+{
+	UNUSED(event);
+}
+
+/**
+  * @brief Time until the next broadcast, once the last reply slot has passed
+  * @retval ms until the next request, 0 while slaves may still answer
+  */
+uint32_t Poll_Quiet_Ms(void)
+{
+	uint32_t elapsed = HAL_GetTick() - period_tick;
+
+	if(!started || elapsed < (NODE_SLAVES + 1U) * NODE_REPLY_SLOT_MS || elapsed >= POLL_PERIOD_MS)
+	{
+		return 0U;
+	}
+	return POLL_PERIOD_MS - elapsed;
+}
+#endif
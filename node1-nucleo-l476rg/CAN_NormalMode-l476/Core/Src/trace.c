@@ -0,0 +1,104 @@
+/*
+ * trace.c
+ *
+ * CAN frame trace on the debug link
+ * Frames are sent as binary packets (uart_link.h), so a trace costs a
+ * few hundred cycles and never waits on the UART.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "trace.h"
+#include "uart_link.h"
+
+volatile uint8_t trace_level = TRACE_LEVEL_DEFAULT;
+
+/**
+  * @brief Microsecond timestamp from the HAL tick and the SysTick down-counter
+  * Wraps after ~71 minutes; the host unwraps it.
+  * @retval time in us
+  */
+uint32_t Trace_Time_Us(void)
+{
+	uint32_t tick;
+	uint32_t val;
+	uint32_t load = SysTick->LOAD + 1U;
+
+	do
+	{
+		tick = HAL_GetTick();
+		val = SysTick->VAL;
+	} while(tick != HAL_GetTick());
+
+	return (tick * 1000U) + (((load - val) * 1000U) / load);
+}
+
+/**
+  * @brief Queue a debug message as TEXT packets (TRACE_LEVEL_TEXT and up)
+  * @retval None
+  */
+void Trace_Text(const char *text)
+{
+	if(trace_level >= TRACE_LEVEL_TEXT)
+	{
+		UART_Link_Text(text);
+	}
+}
+
+/**
+  * @brief Queue one trace packet for a received or transmitted frame
+  *
+  * Payload: u32 time_us, u32 id | UART_LINK_CAN_xxx flags, u8 dlc, data[dlc]
+  * (little-endian)
+  * @param dir: TRACE_DIR_RX or TRACE_DIR_TX
+  * @retval None
+  */
+void Trace_CAN_Frame(char dir, const CAN_Frame_t *frame)
+{
+	uint8_t payload[9 + FRAME_DATA_MAX];
+	uint32_t time_us;
+	uint32_t id;
+	uint32_t len = 9;
+	uint32_t i;
+
+	if(trace_level < TRACE_LEVEL_FRAMES)
+	{
+		return;
+	}
+
+	time_us = Trace_Time_Us();
+	if(frame->header.IDE == CAN_ID_STD)
+	{
+		id = frame->header.StdId;
+	}
+	else
+	{
+		id = frame->header.ExtId | UART_LINK_CAN_EXT;
+	}
+	if(frame->header.RTR == CAN_RTR_REMOTE)
+	{
+		id |= UART_LINK_CAN_RTR;
+	}
+	if(dir == TRACE_DIR_TX)
+	{
+		id |= UART_LINK_CAN_TX;
+	}
+
+	for(i = 0; i < 4U; i++)
+	{
+		payload[i] = (uint8_t)(time_us >> (8U * i));
+		payload[4U + i] = (uint8_t)(id >> (8U * i));
+	}
+	payload[8] = (uint8_t)frame->header.DLC;
+
+	if(frame->header.RTR == CAN_RTR_DATA)
+	{
+		for(i = 0; i < frame->header.DLC && i < FRAME_DATA_MAX; i++)
+		{
+			payload[len++] = frame->data[i];
+		}
+	}
+
+	UART_Link_Send(UART_LINK_TYPE_CAN, payload, len);
+}
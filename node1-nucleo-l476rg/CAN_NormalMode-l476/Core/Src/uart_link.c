@@ -0,0 +1,276 @@
+/*
+ * uart_link.c
+ *
+ * Framed debug link on USART2
+ * - Producers (main loop and ISRs) COBS-encode a packet on their own stack,
+ *   then copy it into the TX ring inside a short Irq_Lock() critical section
+ * - One DMA transfer drains the contiguous part of the ring; its completion
+ *   callback starts the next one, so the CPU never waits on the UART
+ * - RX runs a circular receive-to-idle DMA; each RX event copies the new
+ *   bytes into a ring that UART_Link_Receive() decodes in the main loop
+ *
+ * The DMA buffers stay in SRAM1 (.bss). DMA1 could reach SRAM2 as well, but
+ * SRAM2 (__CAN_BUFFER) is kept for the CAN ISR data, a separate bus-matrix
+ * slave that the link's DMA traffic does not contend for.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "uart_link.h"
+#include <string.h>
+
+volatile UART_Link_Stats_t uart_link_stats;
+
+static UART_HandleTypeDef *link_uart = NULL;
+static uint8_t  tx_ring[UART_LINK_TX_SIZE];
+static uint32_t tx_head = 0;       // next byte written by producers
+static uint32_t tx_tail = 0;       // first byte not yet sent
+static uint32_t tx_dma_len = 0;    // bytes owned by the running DMA transfer
+
+static uint8_t  rx_dma[UART_LINK_RX_DMA_SIZE];
+static uint32_t rx_dma_pos = 0;    // next rx_dma byte not yet copied
+static uint8_t  rx_ring[UART_LINK_RX_SIZE];
+static volatile uint32_t rx_head = 0;
+static volatile uint32_t rx_tail = 0;
+static Link_Rx_t rx_decoder;
+
+/**
+  * @brief Start a DMA transfer for the contiguous part of the ring
+  * Caller holds the critical section (or runs in the DMA completion ISR).
+  */
+static void UART_Link_Kick(void)
+{
+	uint32_t start;
+	uint32_t len;
+
+	if(tx_dma_len != 0U || tx_head == tx_tail)
+	{
+		return;
+	}
+
+	start = tx_tail & (UART_LINK_TX_SIZE - 1U);
+	len = tx_head - tx_tail;
+	if(start + len > UART_LINK_TX_SIZE)
+	{
+		len = UART_LINK_TX_SIZE - start;	// wrap: the rest goes in the next transfer
+	}
+
+	if(HAL_UART_Transmit_DMA(link_uart, &tx_ring[start], (uint16_t)len) == HAL_OK)
+	{
+		tx_dma_len = len;
+	}
+}
+
+/**
+  * @brief Attach the link to an initialised UART with linked TX/RX DMA channels
+  * and start the circular receive
+  * @retval None
+  */
+void UART_Link_Init(UART_HandleTypeDef *huart)
+{
+	link_uart = huart;
+	tx_head = 0;
+	tx_tail = 0;
+	tx_dma_len = 0;
+
+	rx_dma_pos = 0;
+	rx_head = 0;
+	rx_tail = 0;
+	Link_Rx_Reset(&rx_decoder);
+	if(HAL_UARTEx_ReceiveToIdle_DMA(huart, rx_dma, UART_LINK_RX_DMA_SIZE) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	__HAL_DMA_DISABLE_IT(huart->hdmarx, DMA_IT_HT);	// idle + wrap events are enough
+}
+
+/**
+  * @brief Frame and queue one packet (any context)
+  * @retval TRUE if queued, FALSE if too long or the ring is full (counted in dropped)
+  */
+uint8_t UART_Link_Send(uint8_t type, const uint8_t *payload, uint32_t len)
+{
+	uint8_t wire[LINK_WIRE_MAX];
+	uint32_t wire_len;
+	uint32_t start;
+	uint32_t first;
+	uint32_t used;
+	uint32_t basepri;
+
+	wire_len = Link_Encode(wire, type, payload, len);
+	if(wire_len == 0U || link_uart == NULL)
+	{
+		uart_link_stats.dropped++;
+		return FALSE;
+	}
+
+	basepri = Irq_Lock();
+
+	used = tx_head - tx_tail;
+	if(used + wire_len > UART_LINK_TX_SIZE)
+	{
+		uart_link_stats.dropped++;
+		Irq_Unlock(basepri);
+		return FALSE;
+	}
+
+	start = tx_head & (UART_LINK_TX_SIZE - 1U);
+	first = UART_LINK_TX_SIZE - start;
+	if(first >= wire_len)
+	{
+		memcpy(&tx_ring[start], wire, wire_len);
+	}
+	else
+	{
+		memcpy(&tx_ring[start], wire, first);
+		memcpy(&tx_ring[0], &wire[first], wire_len - first);
+	}
+	tx_head += wire_len;
+
+	uart_link_stats.packets++;
+	if(used + wire_len > uart_link_stats.high_water)
+	{
+		uart_link_stats.high_water = used + wire_len;
+	}
+
+	UART_Link_Kick();
+	Irq_Unlock(basepri);
+
+	return TRUE;
+}
+
+/**
+  * @brief Queue a debug string as one or more TEXT packets
+  * @retval None
+  */
+void UART_Link_Text(const char *text)
+{
+	uint32_t len = strlen(text);
+	uint32_t chunk;
+
+	while(len != 0U)
+	{
+		chunk = (len > UART_LINK_PAYLOAD_MAX) ? UART_LINK_PAYLOAD_MAX : len;
+		UART_Link_Send(UART_LINK_TYPE_TEXT, (const uint8_t *)text, chunk);
+		text += chunk;
+		len -= chunk;
+	}
+}
+
+/**
+  * @brief TX DMA complete: release the sent bytes and start the next transfer
+  * Called from HAL_UART_TxCpltCallback.
+  */
+void UART_Link_TxCplt(UART_HandleTypeDef *huart)
+{
+	if(huart != link_uart)
+	{
+		return;
+	}
+
+	tx_tail += tx_dma_len;
+	tx_dma_len = 0;
+	UART_Link_Kick();
+}
+
+/**
+  * @brief Copy newly received DMA bytes into the RX ring
+  * Called from HAL_UARTEx_RxEventCallback (idle line or buffer wrap).
+  * @param Size: DMA write position in rx_dma
+  */
+void UART_Link_RxEvent(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	uint32_t head = rx_head;
+	uint32_t count;
+
+	if(huart != link_uart)
+	{
+		return;
+	}
+
+	/* Size == buffer size on wrap: everything from rx_dma_pos to the end is new */
+	count = (Size >= rx_dma_pos) ? (Size - rx_dma_pos) : (Size + UART_LINK_RX_DMA_SIZE - rx_dma_pos);
+
+	while(count--)
+	{
+		if((head - rx_tail) < UART_LINK_RX_SIZE)
+		{
+			rx_ring[head & (UART_LINK_RX_SIZE - 1U)] = rx_dma[rx_dma_pos];
+			head++;
+		}
+		else
+		{
+			uart_link_stats.rx_overrun++;
+		}
+		if(++rx_dma_pos == UART_LINK_RX_DMA_SIZE)
+		{
+			rx_dma_pos = 0;
+		}
+	}
+
+	__DMB();	// ring bytes visible before the new head
+	rx_head = head;
+}
+
+/**
+  * @brief UART error (noise, framing, overrun): HAL stopped the RX DMA, restart it
+  * Called from HAL_UART_ErrorCallback.
+  */
+void UART_Link_RxError(UART_HandleTypeDef *huart)
+{
+	if(huart != link_uart)
+	{
+		return;
+	}
+
+	uart_link_stats.rx_overrun++;
+	if(huart->RxState == HAL_UART_STATE_READY)
+	{
+		rx_dma_pos = 0;
+		if(HAL_UARTEx_ReceiveToIdle_DMA(huart, rx_dma, UART_LINK_RX_DMA_SIZE) == HAL_OK)
+		{
+			__HAL_DMA_DISABLE_IT(huart->hdmarx, DMA_IT_HT);
+		}
+	}
+}
+
+/**
+  * @brief Decode received bytes up to the next complete packet (main loop context)
+  * @param len: set to the packet length (type + payload)
+  * @retval packet (byte 0 = type), valid until the next call, or NULL
+  */
+const uint8_t *UART_Link_Receive(uint32_t *len)
+{
+	uint32_t tail = rx_tail;
+	uint8_t status;
+
+	while(tail != rx_head)
+	{
+		status = Link_Rx_Feed(&rx_decoder, rx_ring[tail & (UART_LINK_RX_SIZE - 1U)]);
+		tail++;
+		if(status == LINK_RX_BAD)
+		{
+			uart_link_stats.rx_bad++;
+		}
+		else if(status == LINK_RX_PACKET)
+		{
+			rx_tail = tail;
+			uart_link_stats.rx_packets++;
+			*len = rx_decoder.len;
+			return rx_decoder.packet;
+		}
+	}
+	rx_tail = tail;
+
+	return NULL;
+}
+
+/**
+  * @brief Bytes still waiting in the TX ring or owned by the running DMA transfer
+  * @retval TRUE until the last byte has been handed to the UART
+  */
+uint8_t UART_Link_Tx_Busy(void)
+{
+	return (tx_head != tx_tail) ? TRUE : FALSE;
+}
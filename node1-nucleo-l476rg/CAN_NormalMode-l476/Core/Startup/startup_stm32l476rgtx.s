@@ -95,6 +95,20 @@ LoopFillZerobss:
   cmp r2, r4
   bcc FillZerobss
 
+/* Zero fill the ram2bss segment (CAN buffers outside the main RAM bank). */
+  ldr r2, =_sram2bss
+  ldr r4, =_eram2bss
+  movs r3, #0
+  b LoopFillRam2bss
+
+FillRam2bss:
+  str  r3, [r2]
+  adds r2, r2, #4
+
+LoopFillRam2bss:
+  cmp r2, r4
+  bcc FillRam2bss
+
 /* Call static constructors */
     bl __libc_init_array
 /* Call the application's entry point.*/
@@ -0,0 +1,67 @@
+/*
+ * aggregate.h
+ *
+ * Windowed aggregation of slave signals (node2)
+ * Instead of every sample, one CAN_SENSOR_SUMMARY frame per signal and window:
+ *   - Aggregate_Add() folds a sample into the signal's running count, min,
+ *     max and 64-bit sum (main loop or a priority-15 handler such as the
+ *     sensor DMA; a few instructions under Irq_Lock(), which is BASEPRI and
+ *     does not hold off the priority-1 RX1 handler)
+ *   - Aggregate_Process() (main loop) closes every window that has run for
+ *     its window_ms: the accumulator is swapped out under Irq_Lock(), the mean
+ *     is rounded from the exact sum and the summary goes to
+ *     Aggregate_Publish_Callback(), the application's publish path
+ *   - a summary the callback cannot send yet (no free mailbox) is retried on
+ *     the next pass; if the next window closes first the older one is dropped
+ *   - windows without samples send nothing and are only counted
+ * Windows keep their cadence: the next one starts where the last one ended,
+ * unless the main loop fell more than a window behind.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_AGGREGATE_H_
+#define INC_AGGREGATE_H_
+
+#include "main.h"
+
+#define AGGREGATE_ENABLE        1U
+
+#define AGGREGATE_SIGNAL_SENSOR 0U       // sensor block mean (sensor.h)
+#define AGGREGATE_SIGNAL_COUNT  1U       // <= 16, SIGNAL is 4 bits in CAN_SENSOR_SUMMARY
+
+/* Window per signal in ms, 0 = off; Aggregate_Set_Window() changes it at runtime */
+#define AGGREGATE_WINDOWS_MS    { 1000U }
+
+typedef struct
+{
+	uint8_t  signal;
+	uint32_t count;                      // samples in the window
+	uint16_t min;
+	uint16_t max;
+	uint16_t mean;                       // sum / count, rounded
+} Aggregate_Summary_t;
+
+typedef struct
+{
+	uint32_t samples;
+	uint32_t windows;                    // windows closed
+	uint32_t empty;                      // windows without samples, nothing sent
+	uint32_t published;                  // summaries handed to the publish path
+	uint32_t deferred;                   // passes a summary waited for the publish path
+	uint32_t dropped;                    // summaries replaced by the next window before sending
+} Aggregate_Stats_t;
+
+extern volatile Aggregate_Stats_t aggregate_stats[AGGREGATE_SIGNAL_COUNT];
+
+void    Aggregate_Init(void);
+void    Aggregate_Add(uint32_t signal, uint16_t value);
+void    Aggregate_Set_Window(uint32_t signal, uint32_t window_ms);
+void    Aggregate_Process(void);
+void    Aggregate_Pack(uint8_t data[], const Aggregate_Summary_t *summary);
+
+/* Application publish path, TRUE if the summary was queued for transmission */
+uint8_t Aggregate_Publish_Callback(const Aggregate_Summary_t *summary);
+
+#endif /* INC_AGGREGATE_H_ */
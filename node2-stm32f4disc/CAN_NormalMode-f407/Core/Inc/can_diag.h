@@ -0,0 +1,83 @@
+/*
+ * can_diag.h
+ *
+ * CAN error diagnostics
+ * Accumulates the hcan->ErrorCode bits that the lean CAN vectors in it.c
+ * (HAL_CAN_IRQHandler with CAN_ISR_LEAN 0) pass to HAL_CAN_ErrorCallback into
+ * per-class counters (ISR side) and publishes them on a dedicated CAN ID
+ * (main loop side).
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_CAN_DIAG_H_
+#define INC_CAN_DIAG_H_
+
+#include "main.h"
+#include "node_id.h"
+
+/* --- Diagnostics frame --- */
+#define CAN_DIAG_ID_BASE          0x7E0U   // one diagnostics ID per node: base + node ID
+#define CAN_DIAG_ID               (CAN_DIAG_ID_BASE + node_id)
+#define CAN_DIAG_DLC              8U
+#define CAN_DIAG_PUBLISH_MS       1000U    // one page per period, round-robin
+
+/*
+ * Diagnostics frame layout (byte0 = page, counters are u16 MSB first, saturated)
+ *
+ * page 0 (status) : TEC, REC, flags (EWGF | EPVF<<1 | BOFF<<2 | LEC<<4), bus-off, FIFO overrun
+ * page 1 (LEC)    : stuff, form, ack
+ * page 2 (LEC)    : bit recessive, bit dominant, crc
+ * page 3 (TX)     : arbitration lost on mailbox 0, 1, 2
+ * page 4 (TX)     : transmit error on mailbox 0, 1, 2
+ * page 5 (pool)   : in use (byte1), high water, alloc failures, RX ring overflows
+ * page 6 (cycles) : CAN RX0 ISR cycles: CAN_ISR_IN_RAM | CAN_ISR_LEAN<<1 (byte1), min, max, mean
+ * page 7 (cycles) : CAN TX ISR cycles:  CAN_ISR_IN_RAM | CAN_ISR_LEAN<<1 (byte1), min, max, mean
+ * page 8 (cycles) : RTR request -> reply queued: CAN_IF_RTR_AUTOREPLY (byte1), min, max, mean
+ * page 9 (TX)     : CAN_IF_TX_ONESHOT (byte1), expired before a mailbox, aborted at the deadline,
+ *                   ended unsent (can_tx_stats)
+ */
+#define CAN_DIAG_PAGE_STATUS      0U
+#define CAN_DIAG_PAGE_LEC_A       1U
+#define CAN_DIAG_PAGE_LEC_B       2U
+#define CAN_DIAG_PAGE_TX_ALST     3U
+#define CAN_DIAG_PAGE_TX_TERR     4U
+#define CAN_DIAG_PAGE_POOL        5U
+#define CAN_DIAG_PAGE_ISR_RX0     6U
+#define CAN_DIAG_PAGE_ISR_TX      7U
+#define CAN_DIAG_PAGE_RTR         8U
+#define CAN_DIAG_PAGE_TX_DEADLINE 9U
+#define CAN_DIAG_PAGE_COUNT       10U
+
+/* --- Last error code values (CAN_ESR.LEC) --- */
+#define CAN_DIAG_LEC_NONE         0U
+#define CAN_DIAG_LEC_STUFF        1U
+#define CAN_DIAG_LEC_FORM         2U
+#define CAN_DIAG_LEC_ACK          3U
+#define CAN_DIAG_LEC_BIT_REC      4U
+#define CAN_DIAG_LEC_BIT_DOM      5U
+#define CAN_DIAG_LEC_CRC          6U
+#define CAN_DIAG_LEC_SOFTWARE     7U
+#define CAN_DIAG_LEC_COUNT        8U
+
+#define CAN_DIAG_TX_MAILBOXES     3U
+
+typedef struct
+{
+	uint32_t lec[CAN_DIAG_LEC_COUNT];         // histogram indexed by LEC value
+	uint32_t tx_alst[CAN_DIAG_TX_MAILBOXES];  // arbitration lost per mailbox
+	uint32_t tx_terr[CAN_DIAG_TX_MAILBOXES];  // transmit error per mailbox
+	uint32_t error_warning;                   // entries into error warning (EWGF 0 -> 1)
+	uint32_t error_passive;                   // entries into error passive (EPVF 0 -> 1)
+	uint32_t bus_off;                         // entries into bus-off (BOFF 0 -> 1)
+	uint32_t rx_overrun;
+	uint32_t tx_skipped;                      // diagnostics periods without a free mailbox
+} CAN_Diag_Counters_t;
+
+extern volatile CAN_Diag_Counters_t can_diag;
+
+void CAN_Diag_Record(uint32_t errorcode);
+void CAN_Diag_Process(CAN_HandleTypeDef *hcan);
+
+#endif /* INC_CAN_DIAG_H_ */
@@ -0,0 +1,133 @@
+/*
+ * can_if.h
+ *
+ * CAN interface layer
+ * RX: FIFO ISR -> frame pool -> ring -> CAN_IF_Poll() -> CAN_IF_RxCallback()
+ * Adaptive RX: above CAN_IF_RX_POLL_ENTER_FPS the per-frame FIFO0 interrupt
+ * is switched off and CAN_IF_Poll() drains FIFO0 itself; the FIFO-full
+ * interrupt stays armed in case the main loop falls behind. Below
+ * CAN_IF_RX_POLL_EXIT_FPS the interrupt comes back. RX CPU load per frame
+ * rate and mode is collected in can_rx_stats.load (console GET_RX_LOAD).
+ * TX: CAN_IF_Send() straight from a pool frame into a TX mailbox
+ * TX deadlines: a frame given one with CAN_IF_Frame_Deadline() is refused
+ * by CAN_IF_Send() once stale, and its mailbox is aborted by CAN_IF_Poll()
+ * if it is still pending then (can_tx_stats, diagnostics page 9)
+ * TX completion: CAN_IF_Send_Tracked() returns a token for the frame; when
+ * its mailbox finishes, the TX ISR queues an event (sent, aborted, failed,
+ * with the time) and CAN_IF_Poll() hands it to CAN_IF_TxCallback()
+ * RTR auto-reply: a remote request routed to FIFO1 only sets TXRQ on a
+ * TX mailbox that was preloaded with the reply (CAN_IF_RTR_Preload)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_CAN_IF_H_
+#define INC_CAN_IF_H_
+
+#include "main.h"
+#include "frame_pool.h"
+#include "cycles.h"
+
+/* --- RTR auto-reply --- */
+#define CAN_IF_RTR_AUTOREPLY    1U       // node2: answer CAN_ID_SENSOR_DATA requests from the RX1 ISR
+#define CAN_IF_RTR_MAILBOX      2U       // reserved; TSR.CODE hands out lower mailboxes first
+#define CAN_IF_RTR_FILTER_BANK  0U       // 32-bit list: wins over the 16-bit lists; filter_plan.c starts at bank 1
+
+/* --- TX deadlines --- */
+#define CAN_IF_TX_MAILBOXES     3U
+#define CAN_IF_TX_ONESHOT       0U       // 1: MCR.NART, one attempt per frame (controller wide)
+
+#define CAN_IF_TX_SENT          0U       // CAN_IF_Tx_Isr() results
+#define CAN_IF_TX_ABORTED       1U
+#define CAN_IF_TX_FAILED        2U       // arbitration lost or error, no retransmission
+#define CAN_IF_TX_EVENTS        8U       // completion event ring depth, must be a power of two
+
+/* --- Adaptive RX --- */
+#define CAN_IF_RX_ADAPTIVE         1U       // 0: always one FIFO0 interrupt per frame
+#define CAN_IF_RX_POLL_ENTER_FPS   2000U    // frames/s above which FIFO0 is polled
+#define CAN_IF_RX_POLL_EXIT_FPS    800U     // frames/s below which the interrupt returns
+#define CAN_IF_RX_WINDOW_MS        10U      // rate and load measurement window
+#define CAN_IF_RX_LOAD_BUCKET_FPS  500U     // load curve: frame rate per bucket
+#define CAN_IF_RX_LOAD_BUCKETS     12U      // last bucket takes everything above
+
+#define CAN_IF_RX_MODE_IRQ         0U
+#define CAN_IF_RX_MODE_POLL        1U
+#define CAN_IF_RX_MODES            2U
+
+typedef struct
+{
+	uint32_t windows;
+	uint32_t frames;
+	uint64_t rx_cycles;                  // FIFO0 ISR + polled drains (DWT cycles)
+	uint64_t span_cycles;                // length of the windows (CPU cycles)
+} CAN_IF_Rx_Load_t;
+
+typedef struct
+{
+	uint32_t mode;                       // CAN_IF_RX_MODE_xxx
+	uint32_t fps;                        // frame rate of the last window
+	uint32_t to_poll;
+	uint32_t to_irq;
+	uint32_t polled;                     // frames drained by CAN_IF_Poll()
+	uint32_t full_irqs;                  // polling fell behind, FIFO-full interrupt drained
+	CAN_IF_Rx_Load_t load[CAN_IF_RX_MODES][CAN_IF_RX_LOAD_BUCKETS];
+} CAN_IF_Rx_Stats_t;
+
+typedef struct
+{
+	uint32_t replies;                    // TXRQ set from the RX1 ISR
+	uint32_t pending;                    // request arrived while the reply was still queued
+	uint32_t preload_busy;               // preload deferred, reply in flight
+} CAN_IF_RTR_Stats_t;
+
+typedef struct
+{
+	uint32_t expired;                    // past the deadline before a mailbox took it
+	uint32_t abort_requested;            // ABRQ set at the deadline, the frame may still go out
+	uint32_t aborted;                    // mailbox ended aborted (abort took effect)
+	uint32_t failed;                     // mailbox ended unsent after arbitration loss or an error
+	uint32_t events_lost;                // completion event ring full
+} CAN_IF_Tx_Stats_t;
+
+typedef struct
+{
+	uint32_t token;                      // from CAN_IF_Send_Tracked()
+	uint32_t result;                     // CAN_IF_TX_SENT, CAN_IF_TX_ABORTED or CAN_IF_TX_FAILED
+	uint32_t time_us;                    // mailbox finished (Trace_Time_Us, the trace timebase)
+} CAN_IF_Tx_Event_t;
+
+extern volatile CAN_IF_RTR_Stats_t can_rtr_stats;
+extern volatile CAN_IF_Tx_Stats_t can_tx_stats;
+extern volatile uint32_t can_if_rx_frames;         // dispatched by CAN_IF_Poll()
+extern volatile CAN_IF_Rx_Stats_t can_rx_stats;
+extern volatile Cycle_Stats_t can_rtr_reply_cycles;   // request received -> reply queued
+
+void CAN_IF_Init(void);
+void CAN_IF_RxIsr(CAN_HandleTypeDef *hcan, uint32_t RxFifo);
+void CAN_IF_Poll(CAN_HandleTypeDef *hcan);
+void CAN_IF_Rx_Full_Isr(CAN_HandleTypeDef *hcan);
+uint8_t CAN_IF_Rx_Pending(void);
+void CAN_IF_Frame_Std(CAN_Frame_t *frame, uint32_t StdId, uint32_t RTR, uint32_t DLC);
+void CAN_IF_Frame_Deadline(CAN_Frame_t *frame, uint32_t ms);
+uint8_t CAN_IF_Expired(uint32_t deadline, uint32_t now);
+HAL_StatusTypeDef CAN_IF_Send(CAN_HandleTypeDef *hcan, const CAN_Frame_t *frame);
+HAL_StatusTypeDef CAN_IF_Send_Tracked(CAN_HandleTypeDef *hcan, const CAN_Frame_t *frame, uint32_t *token);
+void CAN_IF_Tx_Isr(CAN_HandleTypeDef *hcan, uint32_t mailbox, uint32_t result);
+void CAN_IF_Tx_Error_Isr(CAN_HandleTypeDef *hcan, uint32_t errorcode);
+void CAN_IF_Config_List_Filters(CAN_HandleTypeDef *hcan, const uint16_t entries[], uint32_t count);
+uint32_t CAN_IF_Tx_Free(CAN_HandleTypeDef *hcan);
+
+void CAN_IF_RTR_Config_Filter(CAN_HandleTypeDef *hcan, uint32_t StdId);
+HAL_StatusTypeDef CAN_IF_RTR_Preload(CAN_HandleTypeDef *hcan, const CAN_Frame_t *frame);
+void CAN_IF_RTR_Isr(CAN_TypeDef *can, uint32_t start);
+
+/* Application hook, called from CAN_IF_Poll() (main loop context).
+ * The frame is released after return; call Frame_Pool_Ref() to keep it. */
+void CAN_IF_RxCallback(CAN_Frame_t *frame);
+
+/* Application hook, called from CAN_IF_Poll() (main loop context) once per
+ * frame sent with CAN_IF_Send_Tracked(), before the RX frames are dispatched. */
+void CAN_IF_TxCallback(const CAN_IF_Tx_Event_t *event);
+
+#endif /* INC_CAN_IF_H_ */
@@ -0,0 +1,44 @@
+/*
+ * console.h
+ *
+ * Binary command console on the debug link
+ * Host sends UART_LINK_TYPE_CMD packets, the node answers each with one
+ * UART_LINK_TYPE_REPLY packet. Multi-byte fields are little-endian.
+ *
+ *   CMD   : [op][args...]
+ *   REPLY : [op][status][data...]
+ *
+ * Host side: tools/can_trace/can_console.py
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_CONSOLE_H_
+#define INC_CONSOLE_H_
+
+#include "main.h"
+
+/* --- Opcodes --- */
+#define CONSOLE_OP_PING           0x01U    // -> no data
+#define CONSOLE_OP_SET_TX_PERIOD  0x02U    // u16 period_ms (TIM6)
+#define CONSOLE_OP_SET_FILTERS    0x03U    // n x u16: bits 0..10 std ID, bit 15 RTR; n = 0 drops all
+#define CONSOLE_OP_SET_LOG        0x04U    // u8 TRACE_LEVEL_xxx, or u8 LOG_MOD_xxx (0xFF all), u8 LOG_LEVEL_xxx (0 off)
+#define CONSOLE_OP_SET_BITTIMING  0x05U    // u16 prescaler, u8 bs1, u8 bs2, u8 sjw (time quanta)
+#define CONSOLE_OP_GET_STATS      0x06U    // -> u8 TEC, u8 REC, 15 x u32 counters (see console.c)
+#define CONSOLE_OP_GET_RX_LOAD    0x07U    // -> u8 mode, u8 buckets, u16 bucket fps, u16 fps, load curve (see console.c)
+#define CONSOLE_OP_GET_ISR_CYCLES 0x08U    // -> u8 build flags, 4 x (u32 count, u16 min, u16 max, u16 mean) (see console.c)
+#define CONSOLE_OP_GET_PUBLISH    0x09U    // -> u8 signals, n x 5 x u32 send-on-change counters (see console.c)
+
+/* --- Reply status --- */
+#define CONSOLE_OK                0x00U
+#define CONSOLE_ERR_LENGTH        0x01U    // wrong argument length
+#define CONSOLE_ERR_ARG           0x02U    // argument out of range
+#define CONSOLE_ERR_OPCODE        0x03U    // unknown opcode
+#define CONSOLE_ERR_HAL           0x04U    // HAL call failed
+
+#define CONSOLE_FILTERS_MAX       16U      // 4 filter banks in 16-bit list mode
+
+void Console_Poll(void);
+
+#endif /* INC_CONSOLE_H_ */
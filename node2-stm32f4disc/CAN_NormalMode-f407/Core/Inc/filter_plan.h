@@ -0,0 +1,52 @@
+/*
+ * filter_plan.h
+ *
+ * Filter bank planner for the shared CAN1/CAN2 banks (node2, F407)
+ * The 28 banks are split at CAN_FMR.CAN2SB: CAN1 owns [0, split), CAN2
+ * [split, 28). Clients (receive list, gateway) subscribe exact (ID, RTR)
+ * entries per controller; Filter_Plan_Apply() turns the union into banks:
+ *   - 16-bit list banks (4 exact entries) while the budget allows
+ *   - otherwise entries are merged into 16-bit mask banks (2 id/mask
+ *     pairs), always the merge that admits the fewest unsubscribed IDs
+ * CAN1 banks grow up from FILTER_PLAN_FIRST_BANK, CAN2 banks down from 27,
+ * so the split only ever moves through unused banks. Reconfiguring one
+ * controller never writes the other's banks.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_FILTER_PLAN_H_
+#define INC_FILTER_PLAN_H_
+
+#include "main.h"
+
+#define FILTER_PLAN_CAN1            0U
+#define FILTER_PLAN_CAN2            1U
+#define FILTER_PLAN_CANS            2U
+
+#define FILTER_PLAN_CLIENT_APP      0U    // CAN_IF_Config_List_Filters(): receive list, console
+#define FILTER_PLAN_CLIENT_GATEWAY  1U    // gateway.c route sources
+#define FILTER_PLAN_CLIENTS         2U
+
+#define FILTER_PLAN_BANKS           28U
+#define FILTER_PLAN_FIRST_BANK      1U    // bank 0 is CAN_IF_RTR_FILTER_BANK (CAN1)
+#define FILTER_PLAN_SUB_MAX         32U   // entries per client and controller
+
+typedef struct
+{
+	uint8_t  split;                          // CAN2SB, first CAN2 bank
+	uint8_t  banks[FILTER_PLAN_CANS];        // banks in use per controller
+	uint8_t  mask_banks[FILTER_PLAN_CANS];   // of which in mask mode
+	uint16_t entries[FILTER_PLAN_CANS];      // subscribed (ID, RTR) pairs, duplicates removed
+	uint16_t false_accepts[FILTER_PLAN_CANS];// (ID, RTR) pairs accepted but not subscribed
+	uint32_t applies;
+	uint32_t finit_cycles_max;               // longest FMR.FINIT window (DWT cycles)
+} Filter_Plan_Stats_t;
+
+extern volatile Filter_Plan_Stats_t filter_plan_stats;
+
+void Filter_Plan_Subscribe(uint32_t can, uint32_t client, const uint16_t entries[], uint32_t count);
+void Filter_Plan_Apply(void);
+
+#endif /* INC_FILTER_PLAN_H_ */
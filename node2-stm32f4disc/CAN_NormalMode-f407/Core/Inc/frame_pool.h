@@ -0,0 +1,58 @@
+/*
+ * frame_pool.h
+ *
+ * Static CAN frame pool
+ * Fixed-size, reference-counted frame buffers shared by RX, TX and protocol code.
+ * A frame is filled once (by HAL_CAN_GetRxMessage or by the sender) and then
+ * handed around by pointer: ISR -> ring -> dispatch -> handler -> TX.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_FRAME_POOL_H_
+#define INC_FRAME_POOL_H_
+
+#include "main.h"
+
+#define FRAME_POOL_SIZE     16U    // number of frame buffers
+#define FRAME_RING_SIZE     16U    // RX ring depth, must be a power of two
+#define FRAME_DATA_MAX      8U     // classic CAN payload
+
+typedef struct
+{
+	CAN_RxHeaderTypeDef header;          // StdId/ExtId/IDE/RTR/DLC shared with TX
+	uint8_t  data[FRAME_DATA_MAX];
+	volatile uint8_t refs;               // 0 = free
+	uint8_t  index;                      // slot in the pool
+	uint32_t stamp;                      // DWT cycle count when received (RX only)
+	uint32_t deadline;                   // HAL tick after which a TX frame is stale, 0 = none
+} CAN_Frame_t;
+
+typedef struct
+{
+	uint32_t in_use;                     // frames currently allocated
+	uint32_t high_water;                 // max frames allocated at once
+	uint32_t alloc_fail;                 // pool exhausted
+	uint32_t ring_full;                  // RX ring overflowed (frame dropped)
+} Frame_Pool_Stats_t;
+
+/* Single producer (ISR) / single consumer (main loop) ring of frame pointers */
+typedef struct
+{
+	CAN_Frame_t *slot[FRAME_RING_SIZE];
+	volatile uint32_t head;              // written by producer only
+	volatile uint32_t tail;              // written by consumer only
+} Frame_Ring_t;
+
+extern volatile Frame_Pool_Stats_t frame_pool_stats;
+
+void         Frame_Pool_Init(void);
+CAN_Frame_t *Frame_Pool_Alloc(void);
+void         Frame_Pool_Ref(CAN_Frame_t *frame);
+void         Frame_Pool_Release(CAN_Frame_t *frame);
+
+uint8_t      Frame_Ring_Push(Frame_Ring_t *ring, CAN_Frame_t *frame);
+CAN_Frame_t *Frame_Ring_Pop(Frame_Ring_t *ring);
+
+#endif /* INC_FRAME_POOL_H_ */
@@ -0,0 +1,70 @@
+/*
+ * gateway.h
+ *
+ * CAN1 <-> CAN2 gateway (node2, F407)
+ * Bridges selected standard IDs between the two bxCAN controllers:
+ *   - one routing table per direction: source ID, translated ID on the
+ *     other bus, token bucket rate limit, optional local delivery
+ *   - fast path: the RX ISR copies the FIFO output mailbox registers
+ *     straight into a free TX mailbox of the other controller (no buffer)
+ *   - slow path: no mailbox free, the frame waits in a pool frame and is
+ *     sent from Gateway_Process(); later frames queue behind it, so a
+ *     route never reorders; a frame that waited GATEWAY_QUEUE_DEADLINE_MS
+ *     is dropped instead of sent late
+ *   - per-route counters and latency (RX ISR entry -> TXRQ, DWT cycles)
+ *
+ * CAN2 needs a second transceiver on PB12 (RX) / PB13 (TX).
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_GATEWAY_H_
+#define INC_GATEWAY_H_
+
+#include "main.h"
+#include "frame_pool.h"
+#include "cycles.h"
+
+#define GATEWAY_ENABLE            0U       // 1: bring up CAN2 and bridge the routes in gateway.c
+
+#define GATEWAY_DIR_1TO2          0U       // CAN1 (backbone) -> CAN2 (segment)
+#define GATEWAY_DIR_2TO1          1U
+#define GATEWAY_DIRS              2U
+
+#define GATEWAY_ROUTES_MAX        8U       // per direction
+#define GATEWAY_QUEUE_DEPTH       4U       // slow-path frames per direction, taken from the frame pool
+#define GATEWAY_QUEUE_DEADLINE_MS 10U      // slow-path frame lifetime, 0 = until sent
+#define GATEWAY_REPORT_MS         1000U    // per-route log period
+
+/* --- Route flags --- */
+#define GATEWAY_ROUTE_LOCAL       0x01U    // also deliver to CAN_IF_RxCallback
+#define GATEWAY_ROUTE_REMOTE      0x02U    // match remote frames of src_id, not data frames
+
+typedef struct
+{
+	uint16_t src_id;                     // standard ID on the receiving bus
+	uint16_t dst_id;                     // standard ID on the other bus
+	uint16_t burst;                      // frames admitted per period, 0 = no limit
+	uint16_t period_ms;
+	uint8_t  flags;
+} Gateway_Route_t;
+
+typedef struct
+{
+	uint32_t forwarded;                  // fast path: FIFO -> TX mailbox in the RX ISR
+	uint32_t queued;                     // slow path: sent later from Gateway_Process()
+	uint32_t rate_limited;               // over the route's token bucket
+	uint32_t dropped;                    // queue full or frame pool empty
+	uint32_t expired;                    // slow path: past GATEWAY_QUEUE_DEADLINE_MS, not sent
+	Cycle_Stats_t latency;               // RX ISR entry -> TXRQ set, both paths
+} Gateway_Route_Stats_t;
+
+extern volatile Gateway_Route_Stats_t gateway_stats[GATEWAY_DIRS][GATEWAY_ROUTES_MAX];
+extern volatile uint32_t gateway_can2_errors;
+
+void Gateway_Init(void);
+uint8_t Gateway_RxIsr(CAN_TypeDef *src, uint32_t start);
+void Gateway_Process(void);
+
+#endif /* INC_GATEWAY_H_ */
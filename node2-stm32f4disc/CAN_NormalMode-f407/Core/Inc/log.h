@@ -0,0 +1,119 @@
+/*
+ * log.h
+ *
+ * Deferred, rate-limited logging
+ * - LOG() sites above LOG_COMPILE_LEVEL are removed by the compiler
+ * - log_mask[module] enables levels per module at runtime (console SET_LOG)
+ * - each call site owns a token bucket: LOG_BURST messages, refilled every
+ *   LOG_REFILL_MS; calls beyond that are counted and reported as
+ *   "suppressed N" with the next message the site lets through
+ * - an admitted call only stores (site, tick, two args) in a queue;
+ *   formatting and UART output happen in Log_Process() (main loop)
+ * - lines are formatted by fmt.c, no printf; LOG_FMT_PRINTF 1 goes back to
+ *   snprintf as the size and cycle baseline
+ *
+ * Disabled call: one load, one test, one branch. Suppressed call: the
+ * above plus a tick compare and a counter increment, no function call.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_LOG_H_
+#define INC_LOG_H_
+
+#include "main.h"
+#include "cycles.h"
+
+/* --- Levels --- */
+#define LOG_LEVEL_ERROR           1U
+#define LOG_LEVEL_WARN            2U
+#define LOG_LEVEL_INFO            3U
+#define LOG_LEVEL_DEBUG           4U
+
+#define LOG_COMPILE_LEVEL         LOG_LEVEL_DEBUG   // sites above this level are not compiled in
+
+/* --- Modules, index into log_mask[] --- */
+#define LOG_MOD_APP               0U
+#define LOG_MOD_CAN               1U
+#define LOG_MOD_DIAG              2U
+#define LOG_MOD_LINK              3U
+#define LOG_MOD_COUNT             4U
+
+#define LOG_MASK(level)           ((uint8_t)(1U << (level)))
+#define LOG_MASK_UPTO(level)      ((uint8_t)((2U << (level)) - 2U))    // ERROR .. level
+#define LOG_MASK_DEFAULT          LOG_MASK_UPTO(LOG_LEVEL_INFO)
+
+/* --- Rate limit and queue --- */
+#define LOG_BURST                 4U       // messages per site per refill period
+#define LOG_REFILL_MS             1000U
+#define LOG_QUEUE_SIZE            32U      // deferred records, power of two
+
+#define LOG_FMT_PRINTF            0U       // 1: format with newlib snprintf (baseline for fmt.c)
+
+typedef struct
+{
+	const char *fmt;       // at most two %lu / %lX arguments, see fmt.h
+	uint8_t  module;
+	uint8_t  level;
+	uint8_t  tokens;
+	uint32_t refill_tick;
+	uint32_t suppressed;
+} Log_Site_t;
+
+typedef struct
+{
+	uint32_t queued;
+	uint32_t suppressed;   // all sites, calls dropped by the rate limit
+	uint32_t dropped;      // queue full
+	Cycle_Stats_t format;  // Log_Process(): cycles to format one line
+} Log_Stats_t;
+
+extern volatile uint8_t log_mask[LOG_MOD_COUNT];
+extern volatile Log_Stats_t log_stats;
+
+void Log_Emit(Log_Site_t *site, uint32_t arg0, uint32_t arg1);
+void Log_Set_Level(uint8_t module, uint8_t level);
+void Log_Process(void);
+uint8_t Log_Pending(void);
+
+/**
+  * @brief Token bucket check, inlined at every site
+  * @retval 1 if the message may be queued
+  */
+static inline uint8_t Log_Admit(Log_Site_t *site)
+{
+	if(site->tokens != 0U)
+	{
+		site->tokens--;
+		return 1U;
+	}
+	if((uwTick - site->refill_tick) >= LOG_REFILL_MS)
+	{
+		site->refill_tick = uwTick;
+		site->tokens = LOG_BURST - 1U;
+		return 1U;
+	}
+	site->suppressed++;
+	return 0U;
+}
+
+#define LOG(module, level, fmt, arg0, arg1)                                              \
+	do                                                                                   \
+	{                                                                                    \
+		if(((level) <= LOG_COMPILE_LEVEL) && ((log_mask[(module)] & LOG_MASK(level)) != 0U)) \
+		{                                                                                \
+			static Log_Site_t log_site_ = { (fmt), (module), (level), LOG_BURST, 0U, 0U }; \
+			if(Log_Admit(&log_site_) != 0U)                                              \
+			{                                                                            \
+				Log_Emit(&log_site_, (uint32_t)(arg0), (uint32_t)(arg1));                 \
+			}                                                                            \
+		}                                                                                \
+	} while(0)
+
+#define LOG_ERROR(module, fmt, arg0, arg1)  LOG((module), LOG_LEVEL_ERROR, (fmt), (arg0), (arg1))
+#define LOG_WARN(module, fmt, arg0, arg1)   LOG((module), LOG_LEVEL_WARN, (fmt), (arg0), (arg1))
+#define LOG_INFO(module, fmt, arg0, arg1)   LOG((module), LOG_LEVEL_INFO, (fmt), (arg0), (arg1))
+#define LOG_DEBUG(module, fmt, arg0, arg1)  LOG((module), LOG_LEVEL_DEBUG, (fmt), (arg0), (arg1))
+
+#endif /* INC_LOG_H_ */
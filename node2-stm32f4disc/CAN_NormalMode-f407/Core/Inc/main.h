@@ -11,9 +11,50 @@
 #ifndef INC_MAIN_H_
 #define INC_MAIN_H_
 
-#include "stm32l4xx_hal.h"
+#include "stm32f4xx_hal.h"
 
 #define TRUE  1
 #define FALSE 0
 
+/* --- Memory placement (see the _FLASH.ld linker script) --- */
+#define CAN_ISR_IN_RAM   1    // 1: CAN ISR path in .RamFunc, 0: in flash (cycle baseline)
+
+#if CAN_ISR_IN_RAM
+#define __CAN_ISR        __RAM_FUNC
+#else
+#define __CAN_ISR
+#endif
+
+#define __CAN_BUFFER     __attribute__((section(".ccmbss")))   // CCM-RAM, zeroed at startup
+
+/* --- Critical sections ---
+ * Data shared between the main loop and the priority-15 handlers (CAN, UART,
+ * DMA, TIM6) is locked with BASEPRI, which masks priority 15 only: SysTick and
+ * the priority-1 RTR auto-reply (CAN1_RX1) still preempt. Only data the
+ * priority-1 handler touches itself needs __disable_irq() (CAN_IF_RTR_Preload),
+ * and so does the FMR.FINIT window that stops reception (filter_plan.c). */
+#define IRQ_LOCK_PRIORITY  15U
+
+/**
+  * @brief Mask the priority-15 handlers, nestable
+  * @retval previous BASEPRI, for Irq_Unlock()
+  */
+__STATIC_FORCEINLINE uint32_t Irq_Lock(void)
+{
+	uint32_t basepri = __get_BASEPRI();
+
+	__set_BASEPRI_MAX(IRQ_LOCK_PRIORITY << (8U - __NVIC_PRIO_BITS));
+	return basepri;
+}
+
+/**
+  * @brief Restore the mask saved by Irq_Lock()
+  */
+__STATIC_FORCEINLINE void Irq_Unlock(uint32_t basepri)
+{
+	__set_BASEPRI(basepri);
+}
+
+void Error_Handler(void);
+
 #endif /* INC_MAIN_H_ */
@@ -0,0 +1,47 @@
+/*
+ * node_id.h
+ *
+ * Node identity
+ * One firmware image serves every slave on the bus: the node ID is read
+ * once at startup and every per-node CAN ID, filter entry and reply slot
+ * is derived from it (see CAN_ID_SENSOR_DATA_NODE() in can_catalog.h).
+ *
+ *   0           master (node1)
+ *   1..NODE_ID_MAX  slaves
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_NODE_ID_H_
+#define INC_NODE_ID_H_
+
+#include "main.h"
+#include "can_catalog.h"
+
+#define NODE_ID_MASTER          0U
+#define NODE_ID_MAX             CAN_SENSOR_DATA_NODES    // 31, bounded by the 0x680 + n range
+
+/* --- Where the ID comes from --- */
+#define NODE_ID_SOURCE_FLASH    0U    // node_id_config below, patch the image per node
+#define NODE_ID_SOURCE_OTP      1U    // first byte of the OTP area, 0xFF = not programmed
+#define NODE_ID_SOURCE_STRAP    2U    // 5 pull-up inputs, a jumper to GND reads as 1
+
+#define NODE_ID_SOURCE          NODE_ID_SOURCE_STRAP
+#define NODE_ID_DEFAULT         1U    // flash constant, also the fallback for an invalid OTP / strap value
+
+/* --- Board resources --- */
+#define NODE_ID_OTP_ADDR        0x1FFF7800UL    // F407 OTP block 0
+#define NODE_ID_STRAP_PORT      GPIOE           // PE7..PE11, free on header P2
+#define NODE_ID_STRAP_PIN0      7U
+#define NODE_ID_STRAP_BITS      5U
+#define NODE_ID_STRAP_CLK_ENABLE()  __HAL_RCC_GPIOE_CLK_ENABLE()
+
+/* --- Broadcast reply slots --- */
+#define NODE_REPLY_SLOT_MS      1U    // a broadcast request is answered node_id slots later
+
+extern uint8_t node_id;
+
+void Node_Id_Init(void);
+
+#endif /* INC_NODE_ID_H_ */
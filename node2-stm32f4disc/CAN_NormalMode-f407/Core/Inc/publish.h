@@ -0,0 +1,71 @@
+/*
+ * publish.h
+ *
+ * Send-on-change signal publisher
+ * Producers only set a signal's value (Publish_Set, any context); the main
+ * loop decides whether a frame goes on the bus (Publish_Process):
+ *   - a new value is a change only if it differs from the value last sent
+ *     by more than the signal's deadband, otherwise it is suppressed
+ *   - a change waits until min_interval_ms after the previous frame; a
+ *     further change meanwhile replaces it (coalesced)
+ *   - max_period_ms after the previous frame the current value is sent
+ *     again even without a change (refresh, 0 = never)
+ *   - a frame still queued deadline_ms after it was sent is aborted, so a
+ *     stale value never goes out behind a newer one (CAN_IF_Frame_Deadline)
+ * The frame itself is built by Publish_Fill_Callback() in main.c from the
+ * catalogue packers, and queued with CAN_IF_Send(); a full TX side is
+ * retried on the next pass. In POWER_LEVEL_STOP refreshes wait for the
+ * next wakeup.
+ *
+ * publish_stats[] per signal; updates against sent is the bus-load saving
+ * over sending every update. Read it with can_console.py publish.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_PUBLISH_H_
+#define INC_PUBLISH_H_
+
+#include "main.h"
+#include "frame_pool.h"
+
+#define PUBLISH_ENABLE            1U       // 0: every update is sent at once (old behaviour)
+
+#define PUBLISH_SIGNAL_LED_CMD    0U
+#define PUBLISH_SIGNAL_COUNT      1U
+
+typedef struct
+{
+	uint32_t deadband;                   // |value - last sent| must exceed this
+	uint32_t min_interval_ms;            // no two frames of the signal closer than this
+	uint32_t max_period_ms;              // refresh without change, 0 = never
+	uint32_t deadline_ms;                // TX lifetime of a frame, 0 = until sent
+} Publish_Config_t;
+
+/*  deadband  min_interval_ms  max_period_ms  deadline_ms */
+#define PUBLISH_SIGNALS                           \
+{                                                 \
+	{ 0U,   50U, 5000U, 1000U },    /* LED_CMD */ \
+}
+
+typedef struct
+{
+	uint32_t updates;                    // Publish_Set() calls
+	uint32_t sent;                       // frames queued, refreshes included
+	uint32_t refreshes;                  // frames sent for max_period_ms only
+	uint32_t suppressed;                 // updates within the deadband
+	uint32_t coalesced;                  // changes replaced before they were sent
+	uint32_t busy;                       // passes without a free frame or mailbox
+} Publish_Stats_t;
+
+extern volatile Publish_Stats_t publish_stats[PUBLISH_SIGNAL_COUNT];
+
+void    Publish_Init(void);
+void    Publish_Set(uint32_t signal, int32_t value);
+void    Publish_Process(void);
+
+/* Application: build the signal's frame for value, FALSE if the signal is unknown */
+uint8_t Publish_Fill_Callback(uint32_t signal, int32_t value, CAN_Frame_t *frame);
+
+#endif /* INC_PUBLISH_H_ */
@@ -0,0 +1,59 @@
+/*
+ * sensor.h
+ *
+ * Sampled sensor value served in CAN_ID_SENSOR_DATA (node2, F407)
+ *   - ADC1 converts SENSOR_ADC_CHANNEL continuously; DMA2 Stream0 writes the
+ *     results into a circular buffer of two SENSOR_BLOCK halves
+ *   - the half / full transfer interrupt averages the half the DMA just left
+ *     (decimation by SENSOR_BLOCK) and runs it through a first-order IIR
+ *   - the result goes into a seqlock snapshot: the writer makes the sequence
+ *     odd, updates the fields and makes it even again; Sensor_Read() copies
+ *     the fields and retries if the sequence was odd or moved meanwhile.
+ *     Readers never block the writer and a read takes a fixed number of
+ *     loads unless a block completes during it.
+ * Readers must run below the DMA2_Stream0 priority (main loop), a reader
+ * preempting the writer would spin.
+ *
+ * The default channel is the internal temperature sensor (ADC1_IN16), which
+ * needs no wiring on the Discovery board; an external channel also needs its
+ * pin in analog mode. Values are scaled to 16 bits (12-bit result << 4) as
+ * CAN_SENSOR_DATA_t.value expects. Stop mode (power.h) pauses sampling.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_SENSOR_H_
+#define INC_SENSOR_H_
+
+#include "main.h"
+
+#define SENSOR_ENABLE          1U       // 0: reply with the constant 0xABCD
+#define SENSOR_ADC_CHANNEL     16U      // ADC1_IN16, temperature sensor
+#define SENSOR_ADC_SMP         7U       // 480 cycles, >= 10 us for the temperature sensor
+#define SENSOR_BLOCK           128U     // samples per DMA half, ~3 ms at ADCCLK = 21 MHz
+#define SENSOR_IIR_SHIFT       3U       // y += (x - y) / 2^shift per block
+
+typedef struct
+{
+	uint16_t value;                      // filtered, 16-bit scale
+	uint16_t mean;                       // mean of the last block, 16-bit scale
+	uint32_t blocks;                     // blocks published
+	uint32_t tick;                       // HAL_GetTick() at publication
+} Sensor_Sample_t;
+
+typedef struct
+{
+	uint32_t overruns;                   // ADC OVR, conversions restarted
+	uint32_t dma_errors;
+	uint32_t read_retries;               // Sensor_Read() raced a publication
+} Sensor_Stats_t;
+
+extern volatile Sensor_Stats_t sensor_stats;
+
+void     Sensor_Init(void);
+uint32_t Sensor_Read(Sensor_Sample_t *sample);
+uint32_t Sensor_Seq(void);
+void     Sensor_Adc_Isr(void);
+
+#endif /* INC_SENSOR_H_ */
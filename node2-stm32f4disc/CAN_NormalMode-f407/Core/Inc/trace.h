@@ -0,0 +1,33 @@
+/*
+ * trace.h
+ *
+ * CAN frame trace on the debug link
+ * One UART_LINK_TYPE_CAN packet per frame sent or received by this node,
+ * host side parser: tools/can_trace/can_trace.py
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef INC_TRACE_H_
+#define INC_TRACE_H_
+
+#include "main.h"
+#include "frame_pool.h"
+
+/* --- Verbosity, runtime adjustable (console SET_LOG) --- */
+#define TRACE_LEVEL_OFF           0U       // nothing
+#define TRACE_LEVEL_TEXT          1U       // debug text only
+#define TRACE_LEVEL_FRAMES        2U       // debug text + one packet per CAN frame
+#define TRACE_LEVEL_DEFAULT       TRACE_LEVEL_FRAMES
+
+#define TRACE_DIR_RX              'R'
+#define TRACE_DIR_TX              'T'
+
+extern volatile uint8_t trace_level;
+
+uint32_t Trace_Time_Us(void);
+void Trace_Text(const char *text);
+void Trace_CAN_Frame(char dir, const CAN_Frame_t *frame);
+
+#endif /* INC_TRACE_H_ */
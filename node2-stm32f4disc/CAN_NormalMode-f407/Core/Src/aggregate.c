@@ -0,0 +1,206 @@
+/*
+ * aggregate.c
+ *
+ * Windowed min/max/mean/count per signal (see aggregate.h)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "aggregate.h"
+#include "can_catalog.h"
+
+typedef struct
+{
+	uint32_t count;
+	uint16_t min;
+	uint16_t max;
+	uint64_t sum;                        // exact, the mean is only rounded once
+} Aggregate_Acc_t;
+
+typedef struct
+{
+	Aggregate_Acc_t acc;                 // written by Aggregate_Add() under Irq_Lock()
+	uint32_t window_ms;                  // 0 = off
+	uint32_t start_tick;
+	uint8_t  pending;                    // summary waits for the publish path
+	Aggregate_Summary_t summary;
+} Aggregate_Signal_t;
+
+volatile Aggregate_Stats_t aggregate_stats[AGGREGATE_SIGNAL_COUNT];
+
+static Aggregate_Signal_t signals[AGGREGATE_SIGNAL_COUNT];
+static const uint32_t windows_ms[AGGREGATE_SIGNAL_COUNT] = AGGREGATE_WINDOWS_MS;
+
+/**
+  * @brief Empty accumulator: the first sample sets min and max
+  * @retval None
+  */
+static void Aggregate_Reset(Aggregate_Acc_t *acc)
+{
+	acc->count = 0;
+	acc->min = 0xFFFFU;
+	acc->max = 0;
+	acc->sum = 0;
+}
+
+/**
+  * @brief Start every signal's first window now
+  * @retval None
+  */
+void Aggregate_Init(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t i;
+
+	for(i = 0; i < AGGREGATE_SIGNAL_COUNT; i++)
+	{
+		Aggregate_Reset(&signals[i].acc);
+		signals[i].window_ms = windows_ms[i];
+		signals[i].start_tick = now;
+		signals[i].pending = FALSE;
+	}
+}
+
+/**
+  * @brief Fold one sample into the signal's current window
+  * Main loop or priority-15 handlers only: Irq_Lock() does not mask CAN1_RX1.
+  * @retval None
+  */
+void Aggregate_Add(uint32_t signal, uint16_t value)
+{
+	Aggregate_Acc_t *acc;
+	uint32_t basepri;
+
+	if(signal >= AGGREGATE_SIGNAL_COUNT)
+	{
+		return;
+	}
+	acc = &signals[signal].acc;
+
+	basepri = Irq_Lock();
+	acc->count++;
+	if(value < acc->min)
+	{
+		acc->min = value;
+	}
+	if(value > acc->max)
+	{
+		acc->max = value;
+	}
+	acc->sum += value;
+	aggregate_stats[signal].samples++;
+	Irq_Unlock(basepri);
+}
+
+/**
+  * @brief Change a signal's window and restart it (main loop context)
+  * @param window_ms: 0 stops the summaries of this signal
+  * @retval None
+  */
+void Aggregate_Set_Window(uint32_t signal, uint32_t window_ms)
+{
+	uint32_t basepri;
+
+	if(signal >= AGGREGATE_SIGNAL_COUNT)
+	{
+		return;
+	}
+
+	basepri = Irq_Lock();
+	Aggregate_Reset(&signals[signal].acc);
+	Irq_Unlock(basepri);
+
+	signals[signal].window_ms = window_ms;
+	signals[signal].start_tick = HAL_GetTick();
+}
+
+/**
+  * @brief End the window: take the accumulator and build its summary
+  * @retval None
+  */
+static void Aggregate_Close(uint32_t signal, uint32_t now)
+{
+	Aggregate_Signal_t *s = &signals[signal];
+	Aggregate_Acc_t acc;
+	uint32_t basepri;
+
+	basepri = Irq_Lock();
+	acc = s->acc;
+	Aggregate_Reset(&s->acc);
+	Irq_Unlock(basepri);
+
+	aggregate_stats[signal].windows++;
+	s->start_tick += s->window_ms;
+	if((now - s->start_tick) >= s->window_ms)
+	{
+		s->start_tick = now;				// more than a window behind: restart the cadence
+	}
+
+	if(acc.count == 0U)
+	{
+		aggregate_stats[signal].empty++;
+		return;
+	}
+	if(s->pending)
+	{
+		aggregate_stats[signal].dropped++;
+	}
+
+	s->summary.signal = (uint8_t)signal;
+	s->summary.count = acc.count;
+	s->summary.min = acc.min;
+	s->summary.max = acc.max;
+	s->summary.mean = (uint16_t)((acc.sum + acc.count / 2U) / acc.count);
+	s->pending = TRUE;
+}
+
+/**
+  * @brief Pack a summary into a CAN_SENSOR_SUMMARY payload
+  * COUNT is 12 bits on the wire and saturates at 0x0FFF.
+  * @retval None
+  */
+void Aggregate_Pack(uint8_t data[], const Aggregate_Summary_t *summary)
+{
+	CAN_SENSOR_SUMMARY_t msg;
+
+	msg.signal = summary->signal;
+	msg.count = (summary->count > 0x0FFFU) ? 0x0FFFU : (uint16_t)summary->count;
+	msg.min = summary->min;
+	msg.max = summary->max;
+	msg.mean = summary->mean;
+	CAN_SENSOR_SUMMARY_Pack(data, &msg);
+}
+
+/**
+  * @brief Close due windows and publish their summaries (main loop context)
+  * @retval None
+  */
+void Aggregate_Process(void)
+{
+	uint32_t now = HAL_GetTick();
+	Aggregate_Signal_t *s;
+	uint32_t i;
+
+	for(i = 0; i < AGGREGATE_SIGNAL_COUNT; i++)
+	{
+		s = &signals[i];
+		if(s->window_ms != 0U && (now - s->start_tick) >= s->window_ms)
+		{
+			Aggregate_Close(i, now);
+		}
+
+		if(s->pending)
+		{
+			if(Aggregate_Publish_Callback(&s->summary) != FALSE)
+			{
+				s->pending = FALSE;
+				aggregate_stats[i].published++;
+			}
+			else
+			{
+				aggregate_stats[i].deferred++;
+			}
+		}
+	}
+}
@@ -0,0 +1,215 @@
+/*
+ * can_diag.c
+ *
+ * CAN error diagnostics
+ * - CAN_Diag_Record(): called from HAL_CAN_ErrorCallback, only increments counters
+ * - CAN_Diag_Process(): called from the main loop, publishes one page per period
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "can_diag.h"
+#include "can_if.h"
+#include "it.h"
+#include "log.h"
+#include <string.h>
+
+/* ErrorCode bits decoded from ESR on an SCE interrupt */
+#define CAN_DIAG_ERR_STATE   (HAL_CAN_ERROR_EWG | HAL_CAN_ERROR_EPV | HAL_CAN_ERROR_BOF)
+#define CAN_DIAG_ERR_ESR     (CAN_DIAG_ERR_STATE | HAL_CAN_ERROR_STF | HAL_CAN_ERROR_FOR | HAL_CAN_ERROR_ACK | \
+                              HAL_CAN_ERROR_BR | HAL_CAN_ERROR_BD | HAL_CAN_ERROR_CRC)
+
+volatile CAN_Diag_Counters_t can_diag;
+
+static uint32_t diag_err_state;				// EWG/EPV/BOF of the last ESR seen, ISR only
+static uint8_t  diag_page = CAN_DIAG_PAGE_STATUS;
+static uint32_t diag_last_tick = 0;
+
+/**
+  * @brief Store a counter as saturated u16, MSB first
+  */
+static void CAN_Diag_Put_U16(uint8_t *dst, uint32_t value)
+{
+	if(value > 0xFFFFU)
+	{
+		value = 0xFFFFU;
+	}
+	dst[0] = (uint8_t)(value >> 8);
+	dst[1] = (uint8_t)(value & 0xFFU);
+}
+
+/**
+  * @brief Store an ISR cycle report: build flags, min, max, mean
+  */
+static void CAN_Diag_Put_Cycles(uint8_t *payload, const volatile Cycle_Stats_t *stats)
+{
+	payload[1] = (uint8_t)(CAN_ISR_IN_RAM | (CAN_ISR_LEAN << 1));
+	CAN_Diag_Put_U16(&payload[2], stats->min);
+	CAN_Diag_Put_U16(&payload[4], stats->max);
+	CAN_Diag_Put_U16(&payload[6], Cycle_Stats_Mean(stats));
+}
+
+/**
+  * @brief Accumulate a HAL error code into the per-class counters
+  * ISR context: no I/O, no HAL calls.
+  * EWGF/EPVF/BOFF stay set while the node is in that state and are reported
+  * again with every LEC interrupt, so the state counters count 0 -> 1 edges
+  * against the previous ESR report. A TX or RX error code carries no ESR bits
+  * and leaves the previous state alone. The LEC interrupt is enabled, so the
+  * errors that bring a recovered node back into a state are seen with the
+  * flag still clear.
+  * @param errorcode: HAL_CAN_ERROR_xxx bit field (hcan->ErrorCode)
+  */
+__CAN_ISR void CAN_Diag_Record(uint32_t errorcode)
+{
+	uint32_t entered = 0;
+
+	if(errorcode & CAN_DIAG_ERR_ESR)
+	{
+		entered = errorcode & CAN_DIAG_ERR_STATE & ~diag_err_state;
+		diag_err_state = errorcode & CAN_DIAG_ERR_STATE;
+	}
+
+	if(entered & HAL_CAN_ERROR_EWG)        { can_diag.error_warning++; }
+	if(entered & HAL_CAN_ERROR_EPV)        { can_diag.error_passive++; }
+	if(entered & HAL_CAN_ERROR_BOF)        { can_diag.bus_off++; }
+
+	if(entered & (HAL_CAN_ERROR_EPV | HAL_CAN_ERROR_BOF))
+	{
+		LOG_ERROR(LOG_MOD_DIAG, "error state: ESR code 0x%lX, bus-off count %lu", errorcode, can_diag.bus_off);
+	}
+
+	if(errorcode & HAL_CAN_ERROR_STF)      { can_diag.lec[CAN_DIAG_LEC_STUFF]++; }
+	if(errorcode & HAL_CAN_ERROR_FOR)      { can_diag.lec[CAN_DIAG_LEC_FORM]++; }
+	if(errorcode & HAL_CAN_ERROR_ACK)      { can_diag.lec[CAN_DIAG_LEC_ACK]++; }
+	if(errorcode & HAL_CAN_ERROR_BR)       { can_diag.lec[CAN_DIAG_LEC_BIT_REC]++; }
+	if(errorcode & HAL_CAN_ERROR_BD)       { can_diag.lec[CAN_DIAG_LEC_BIT_DOM]++; }
+	if(errorcode & HAL_CAN_ERROR_CRC)      { can_diag.lec[CAN_DIAG_LEC_CRC]++; }
+
+	if(errorcode & (HAL_CAN_ERROR_RX_FOV0 | HAL_CAN_ERROR_RX_FOV1))
+	{
+		can_diag.rx_overrun++;
+	}
+
+	if(errorcode & HAL_CAN_ERROR_TX_ALST0) { can_diag.tx_alst[0]++; }
+	if(errorcode & HAL_CAN_ERROR_TX_TERR0) { can_diag.tx_terr[0]++; }
+	if(errorcode & HAL_CAN_ERROR_TX_ALST1) { can_diag.tx_alst[1]++; }
+	if(errorcode & HAL_CAN_ERROR_TX_TERR1) { can_diag.tx_terr[1]++; }
+	if(errorcode & HAL_CAN_ERROR_TX_ALST2) { can_diag.tx_alst[2]++; }
+	if(errorcode & HAL_CAN_ERROR_TX_TERR2) { can_diag.tx_terr[2]++; }
+}
+
+/**
+  * @brief Publish the next diagnostics page when the period has elapsed
+  *
+  * CAN ID: CAN_DIAG_ID
+  * DLC: 8
+  * Payload: see page layout in can_diag.h
+  *
+  * Skips the period if no TX mailbox is free; the same page is retried next pass.
+  * The mailbox check is only a shortcut: an ISR sender (TIM6 CAN1_Tx, the
+  * gateway) may take the last mailbox before CAN_IF_Send(), which then fails
+  * the same way. Diagnostics are best effort and never stop the node.
+  * A page still queued when the next one is due is aborted (TX deadline).
+  * @retval None
+  */
+void CAN_Diag_Process(CAN_HandleTypeDef *hcan)
+{
+	CAN_Frame_t *frame;
+	uint8_t *payload;
+	uint32_t esr;
+
+	if((HAL_GetTick() - diag_last_tick) < CAN_DIAG_PUBLISH_MS)
+	{
+		return;
+	}
+
+	if(CAN_IF_Tx_Free(hcan) == 0U)
+	{
+		return;
+	}
+
+	frame = Frame_Pool_Alloc();
+	if(frame == NULL)
+	{
+		return;
+	}
+
+	diag_last_tick = HAL_GetTick();
+
+	CAN_IF_Frame_Std(frame, CAN_DIAG_ID, CAN_RTR_DATA, CAN_DIAG_DLC);
+	CAN_IF_Frame_Deadline(frame, CAN_DIAG_PUBLISH_MS);
+	payload = frame->data;
+	memset(payload, 0, CAN_DIAG_DLC);
+	payload[0] = diag_page;
+
+	switch(diag_page)
+	{
+	case CAN_DIAG_PAGE_STATUS:
+		esr = hcan->Instance->ESR;
+		payload[1] = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+		payload[2] = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+		payload[3] = (uint8_t)(esr & (CAN_ESR_EWGF | CAN_ESR_EPVF | CAN_ESR_BOFF | CAN_ESR_LEC));
+		CAN_Diag_Put_U16(&payload[4], can_diag.bus_off);
+		CAN_Diag_Put_U16(&payload[6], can_diag.rx_overrun);
+		break;
+	case CAN_DIAG_PAGE_LEC_A:
+		CAN_Diag_Put_U16(&payload[2], can_diag.lec[CAN_DIAG_LEC_STUFF]);
+		CAN_Diag_Put_U16(&payload[4], can_diag.lec[CAN_DIAG_LEC_FORM]);
+		CAN_Diag_Put_U16(&payload[6], can_diag.lec[CAN_DIAG_LEC_ACK]);
+		break;
+	case CAN_DIAG_PAGE_LEC_B:
+		CAN_Diag_Put_U16(&payload[2], can_diag.lec[CAN_DIAG_LEC_BIT_REC]);
+		CAN_Diag_Put_U16(&payload[4], can_diag.lec[CAN_DIAG_LEC_BIT_DOM]);
+		CAN_Diag_Put_U16(&payload[6], can_diag.lec[CAN_DIAG_LEC_CRC]);
+		break;
+	case CAN_DIAG_PAGE_TX_ALST:
+		CAN_Diag_Put_U16(&payload[2], can_diag.tx_alst[0]);
+		CAN_Diag_Put_U16(&payload[4], can_diag.tx_alst[1]);
+		CAN_Diag_Put_U16(&payload[6], can_diag.tx_alst[2]);
+		break;
+	case CAN_DIAG_PAGE_TX_TERR:
+		CAN_Diag_Put_U16(&payload[2], can_diag.tx_terr[0]);
+		CAN_Diag_Put_U16(&payload[4], can_diag.tx_terr[1]);
+		CAN_Diag_Put_U16(&payload[6], can_diag.tx_terr[2]);
+		break;
+	case CAN_DIAG_PAGE_POOL:
+		payload[1] = (uint8_t)frame_pool_stats.in_use;
+		CAN_Diag_Put_U16(&payload[2], frame_pool_stats.high_water);
+		CAN_Diag_Put_U16(&payload[4], frame_pool_stats.alloc_fail);
+		CAN_Diag_Put_U16(&payload[6], frame_pool_stats.ring_full);
+		break;
+	case CAN_DIAG_PAGE_ISR_RX0:
+		CAN_Diag_Put_Cycles(payload, &can_isr_cycles[CAN_ISR_RX0]);
+		break;
+	case CAN_DIAG_PAGE_ISR_TX:
+		CAN_Diag_Put_Cycles(payload, &can_isr_cycles[CAN_ISR_TX]);
+		break;
+	case CAN_DIAG_PAGE_RTR:
+		CAN_Diag_Put_Cycles(payload, &can_rtr_reply_cycles);
+		payload[1] = CAN_IF_RTR_AUTOREPLY;
+		break;
+	case CAN_DIAG_PAGE_TX_DEADLINE:
+		payload[1] = CAN_IF_TX_ONESHOT;
+		CAN_Diag_Put_U16(&payload[2], can_tx_stats.expired);
+		CAN_Diag_Put_U16(&payload[4], can_tx_stats.aborted);
+		CAN_Diag_Put_U16(&payload[6], can_tx_stats.failed);
+		break;
+	default:
+		break;
+	}
+
+	if(CAN_IF_Send(hcan, frame) != HAL_OK)
+	{
+		Frame_Pool_Release(frame);
+		can_diag.tx_skipped++;
+		return;							// period skipped, same page next time
+	}
+	Frame_Pool_Release(frame);
+
+	if(++diag_page == CAN_DIAG_PAGE_COUNT)
+	{
+		diag_page = CAN_DIAG_PAGE_STATUS;	// wrap around
+	}
+}
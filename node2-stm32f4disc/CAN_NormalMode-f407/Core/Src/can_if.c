@@ -0,0 +1,660 @@
+/*
+ * can_if.c
+ *
+ * CAN interface layer
+ * - RX ISR only moves the FIFO output mailbox into a pool frame and queues it
+ * - Decoding, UART logging and replies run in the main loop (CAN_IF_Poll)
+ * - Optional RTR auto-reply: FIFO1 ISR sets TXRQ on a preloaded mailbox
+ * - TX slots: deadline and token per CAN1 mailbox, set by CAN_IF_Send(),
+ *   cleared by the TX ISR when the mailbox finishes, expired by CAN_IF_Poll()
+ * - TX completion events: TX/error ISRs -> event ring -> CAN_IF_TxCallback()
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "can_if.h"
+#include "trace.h"
+#include "log.h"
+#include "power.h"
+#include "it.h"
+#include "can_catalog.h"
+#include "filter_plan.h"
+
+volatile CAN_IF_RTR_Stats_t can_rtr_stats;
+volatile uint32_t can_if_rx_frames;
+volatile CAN_IF_Rx_Stats_t can_rx_stats;
+volatile Cycle_Stats_t can_rtr_reply_cycles;
+volatile CAN_IF_Tx_Stats_t can_tx_stats;
+
+static Frame_Ring_t rx_ring __CAN_BUFFER;
+
+static uint32_t rx_window_tick;
+static uint32_t rx_window_frames;
+static uint64_t rx_window_isr;          // can_isr_cycles[CAN_ISR_RX0].total at the window start
+static uint32_t rx_poll_cycles;         // drain cycles in the current window
+
+typedef struct
+{
+	uint32_t deadline;                   // 0 = none
+	uint32_t token;                      // 0 = untracked
+} CAN_IF_Tx_Slot_t;
+
+static CAN_IF_Tx_Slot_t tx_slot[CAN_IF_TX_MAILBOXES];	// frame in each CAN1 mailbox
+static uint32_t tx_token = 0;           // last token handed out
+static CAN_IF_Tx_Event_t tx_events[CAN_IF_TX_EVENTS];
+static volatile uint32_t tx_event_head; // CAN ISRs, under Irq_Lock()
+static volatile uint32_t tx_event_tail; // CAN_IF_Poll()
+
+/**
+  * @brief Reset the frame pool, the RX ring and the TX completion events
+  * @retval None
+  */
+void CAN_IF_Init(void)
+{
+	Frame_Pool_Init();
+	rx_ring.head = 0;
+	rx_ring.tail = 0;
+	tx_event_head = 0;
+	tx_event_tail = 0;
+}
+
+/**
+  * @brief Move one frame from an RX FIFO into the RX ring (ISR context)
+  *
+  * If no frame buffer is available the FIFO output mailbox is still released,
+  * otherwise the pending interrupt would re-trigger forever.
+  * @param RxFifo: CAN_RX_FIFO0 or CAN_RX_FIFO1
+  * @retval None
+  */
+__CAN_ISR void CAN_IF_RxIsr(CAN_HandleTypeDef *hcan, uint32_t RxFifo)
+{
+	uint32_t stamp = Cycles_Now();
+	CAN_Frame_t *frame = Frame_Pool_Alloc();
+
+	if(frame == NULL)
+	{
+		LOG_WARN(LOG_MOD_CAN, "RX frame dropped, pool empty (fifo %lu)", RxFifo, 0);
+		if(RxFifo == CAN_RX_FIFO0)
+		{
+			SET_BIT(hcan->Instance->RF0R, CAN_RF0R_RFOM0);
+		}
+		else
+		{
+			SET_BIT(hcan->Instance->RF1R, CAN_RF1R_RFOM1);
+		}
+		return;
+	}
+
+	if(HAL_CAN_GetRxMessage(hcan, RxFifo, &frame->header, frame->data) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	frame->stamp = stamp;
+
+	if(Frame_Ring_Push(&rx_ring, frame) == FALSE)
+	{
+		Frame_Pool_Release(frame);
+	}
+}
+
+/**
+  * @brief Move every frame waiting in FIFO0 to the RX ring (polling mode)
+  * Takes the same path as the FIFO0 interrupt (HAL_CAN_RxFifo0MsgPendingCallback),
+  * one frame per critical section so that the FIFO-full interrupt never
+  * reads the output mailbox at the same time.
+  * @retval None
+  */
+static void CAN_IF_Rx_Drain(CAN_HandleTypeDef *hcan)
+{
+	uint32_t start = Cycles_Now();
+	uint32_t count = 0;
+	uint32_t basepri;
+
+	while((hcan->Instance->RF0R & CAN_RF0R_FMP0) != 0U)
+	{
+		basepri = Irq_Lock();
+		if((hcan->Instance->RF0R & CAN_RF0R_FMP0) != 0U)
+		{
+			HAL_CAN_RxFifo0MsgPendingCallback(hcan);
+			count++;
+		}
+		Irq_Unlock(basepri);
+	}
+
+	if(count != 0U)
+	{
+		can_rx_stats.polled += count;
+		rx_poll_cycles += Cycles_Now() - start;
+	}
+}
+
+/**
+  * @brief Switch FIFO0 between one interrupt per frame and main loop polling
+  * Polling keeps the FIFO-full interrupt as a backstop; going back, a frame
+  * already waiting raises the message-pending interrupt at once.
+  * @retval None
+  */
+static void CAN_IF_Rx_Set_Mode(CAN_HandleTypeDef *hcan, uint32_t mode)
+{
+	uint32_t basepri = Irq_Lock();
+
+	if(mode == CAN_IF_RX_MODE_POLL)
+	{
+		__HAL_CAN_ENABLE_IT(hcan, CAN_IT_RX_FIFO0_FULL);
+		__HAL_CAN_DISABLE_IT(hcan, CAN_IT_RX_FIFO0_MSG_PENDING);
+		can_rx_stats.to_poll++;
+	}
+	else
+	{
+		__HAL_CAN_ENABLE_IT(hcan, CAN_IT_RX_FIFO0_MSG_PENDING);
+		__HAL_CAN_DISABLE_IT(hcan, CAN_IT_RX_FIFO0_FULL);
+		can_rx_stats.to_irq++;
+	}
+	can_rx_stats.mode = mode;
+	Irq_Unlock(basepri);
+}
+
+/**
+  * @brief Close a measurement window: frame rate, RX load curve, RX mode
+  * @retval None
+  */
+static void CAN_IF_Rx_Window(CAN_HandleTypeDef *hcan)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t elapsed = now - rx_window_tick;
+	uint32_t frames = can_if_rx_frames - rx_window_frames;
+	volatile CAN_IF_Rx_Load_t *load;
+	uint64_t isr;
+	uint32_t bucket;
+	uint32_t basepri;
+
+	if(elapsed < CAN_IF_RX_WINDOW_MS)
+	{
+		return;
+	}
+
+	basepri = Irq_Lock();
+	isr = can_isr_cycles[CAN_ISR_RX0].total;	// 64-bit, updated by the ISR
+	Irq_Unlock(basepri);
+
+	can_rx_stats.fps = (frames * 1000U) / elapsed;
+	bucket = can_rx_stats.fps / CAN_IF_RX_LOAD_BUCKET_FPS;
+	if(bucket >= CAN_IF_RX_LOAD_BUCKETS)
+	{
+		bucket = CAN_IF_RX_LOAD_BUCKETS - 1U;
+	}
+	load = &can_rx_stats.load[can_rx_stats.mode][bucket];
+	load->windows++;
+	load->frames += frames;
+	load->rx_cycles += (isr - rx_window_isr) + rx_poll_cycles;
+	load->span_cycles += (uint64_t)elapsed * (SystemCoreClock / 1000U);
+
+	rx_window_tick = now;
+	rx_window_frames = can_if_rx_frames;
+	rx_window_isr = isr;
+	rx_poll_cycles = 0;
+
+#if CAN_IF_RX_ADAPTIVE
+	if(can_rx_stats.mode == CAN_IF_RX_MODE_IRQ && can_rx_stats.fps > CAN_IF_RX_POLL_ENTER_FPS)
+	{
+		CAN_IF_Rx_Set_Mode(hcan, CAN_IF_RX_MODE_POLL);
+		LOG_INFO(LOG_MOD_CAN, "rx polling at %lu frames/s", can_rx_stats.fps, 0);
+	}
+	else if(can_rx_stats.mode == CAN_IF_RX_MODE_POLL && can_rx_stats.fps < CAN_IF_RX_POLL_EXIT_FPS)
+	{
+		CAN_IF_Rx_Set_Mode(hcan, CAN_IF_RX_MODE_IRQ);
+		LOG_INFO(LOG_MOD_CAN, "rx interrupts at %lu frames/s", can_rx_stats.fps, 0);
+	}
+#endif
+}
+
+/**
+  * @brief FIFO0 full while polling: the main loop fell behind (ISR context)
+  * Called from HAL_CAN_RxFifo0FullCallback.
+  * @retval None
+  */
+__CAN_ISR void CAN_IF_Rx_Full_Isr(CAN_HandleTypeDef *hcan)
+{
+	can_rx_stats.full_irqs++;
+	while((hcan->Instance->RF0R & CAN_RF0R_FMP0) != 0U)
+	{
+		HAL_CAN_RxFifo0MsgPendingCallback(hcan);
+	}
+}
+
+/**
+  * @brief Deadline check, wrap-safe
+  * @retval TRUE if the deadline is set and has passed
+  */
+uint8_t CAN_IF_Expired(uint32_t deadline, uint32_t now)
+{
+	return (deadline != 0U && (int32_t)(now - deadline) >= 0) ? TRUE : FALSE;
+}
+
+/**
+  * @brief Abort the mailboxes still holding a frame past its deadline
+  *
+  * ABRQ is set with a plain TSR write rather than HAL_CAN_AbortTxRequest():
+  * its read-modify-write would also write back RQCPx bits that are set and
+  * clear a completion the TX ISR has not seen yet. A frame already on the
+  * bus finishes; the TX ISR then reports it sent, otherwise aborted, and
+  * only the latter counts in can_tx_stats.aborted.
+  * @retval None
+  */
+static void CAN_IF_Tx_Expire(CAN_HandleTypeDef *hcan)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t basepri;
+	uint32_t mb;
+
+	for(mb = 0; mb < CAN_IF_TX_MAILBOXES; mb++)
+	{
+		basepri = Irq_Lock();
+		if(CAN_IF_Expired(tx_slot[mb].deadline, now))
+		{
+			tx_slot[mb].deadline = 0;		// the token stays for the abort event
+			if((hcan->Instance->TSR & (CAN_TSR_TME0 << mb)) == 0U)
+			{
+				hcan->Instance->TSR = CAN_TSR_ABRQ0 << (8U * mb);	// rc_w1 bits written as 0: untouched
+				can_tx_stats.abort_requested++;
+			}
+		}
+		Irq_Unlock(basepri);
+	}
+}
+
+/**
+  * @brief Dispatch every queued RX frame and TX completion (main loop context)
+  * In polling mode FIFO0 is drained first; completions go before the RX
+  * frames, so a reply is never seen before its request was sent. Stale TX
+  * mailboxes are aborted last.
+  * @param hcan: controller whose FIFO0 follows the adaptive RX mode
+  * @retval None
+  */
+void CAN_IF_Poll(CAN_HandleTypeDef *hcan)
+{
+	CAN_Frame_t *frame;
+
+	if(can_rx_stats.mode == CAN_IF_RX_MODE_POLL)
+	{
+		CAN_IF_Rx_Drain(hcan);
+	}
+
+	while(tx_event_tail != tx_event_head)
+	{
+		CAN_IF_TxCallback(&tx_events[tx_event_tail & (CAN_IF_TX_EVENTS - 1U)]);
+		tx_event_tail++;
+	}
+
+	while((frame = Frame_Ring_Pop(&rx_ring)) != NULL)
+	{
+		Trace_CAN_Frame(TRACE_DIR_RX, frame);
+		CAN_IF_RxCallback(frame);
+		Frame_Pool_Release(frame);
+		Power_Rx_Handled();
+		can_if_rx_frames++;
+	}
+
+	CAN_IF_Rx_Window(hcan);
+	CAN_IF_Tx_Expire(hcan);
+}
+
+/**
+  * @brief Frames queued by the RX ISR and not yet dispatched, or FIFO0 polled
+  * @retval TRUE if the RX ring is not empty or the main loop polls FIFO0
+  */
+uint8_t CAN_IF_Rx_Pending(void)
+{
+	return (rx_ring.head != rx_ring.tail || can_rx_stats.mode == CAN_IF_RX_MODE_POLL) ? TRUE : FALSE;
+}
+
+/**
+  * @brief Fill the header of a TX frame (standard ID)
+  * @retval None
+  */
+void CAN_IF_Frame_Std(CAN_Frame_t *frame, uint32_t StdId, uint32_t RTR, uint32_t DLC)
+{
+	frame->header.StdId = StdId;
+	frame->header.ExtId = 0;
+	frame->header.IDE = CAN_ID_STD;
+	frame->header.RTR = RTR;
+	frame->header.DLC = DLC;
+	frame->deadline = 0;
+}
+
+/**
+  * @brief Give a TX frame a deadline (after CAN_IF_Frame_Std)
+  * @param ms: lifetime from now; 0 = none, the frame waits until it is sent
+  * @retval None
+  */
+void CAN_IF_Frame_Deadline(CAN_Frame_t *frame, uint32_t ms)
+{
+	frame->deadline = 0;
+	if(ms != 0U)
+	{
+		frame->deadline = HAL_GetTick() + ms;
+		if(frame->deadline == 0U)
+		{
+			frame->deadline = 1U;		// 0 means none
+		}
+	}
+}
+
+/**
+  * @brief Write a pool frame's identifier and payload into a TX mailbox
+  * Straight from frame->header and frame->data, without TXRQ: the caller
+  * requests transmission (or leaves it to the RTR ISR).
+  * @retval None
+  */
+static inline void CAN_IF_Mailbox_Write(CAN_TxMailBox_TypeDef *mailbox, const CAN_Frame_t *frame)
+{
+	if(frame->header.IDE == CAN_ID_STD)
+	{
+		mailbox->TIR = (frame->header.StdId << CAN_TI0R_STID_Pos) | frame->header.RTR;
+	}
+	else
+	{
+		mailbox->TIR = (frame->header.ExtId << CAN_TI0R_EXID_Pos) | CAN_ID_EXT | frame->header.RTR;
+	}
+	mailbox->TDTR = frame->header.DLC;
+	mailbox->TDLR = ((uint32_t)frame->data[3] << 24) | ((uint32_t)frame->data[2] << 16) |
+	                ((uint32_t)frame->data[1] << 8)  |  (uint32_t)frame->data[0];
+	mailbox->TDHR = ((uint32_t)frame->data[7] << 24) | ((uint32_t)frame->data[6] << 16) |
+	                ((uint32_t)frame->data[5] << 8)  |  (uint32_t)frame->data[4];
+}
+
+/**
+  * @brief Queue a pool frame for transmission, without a completion event
+  * @retval see CAN_IF_Send_Tracked()
+  */
+HAL_StatusTypeDef CAN_IF_Send(CAN_HandleTypeDef *hcan, const CAN_Frame_t *frame)
+{
+	return CAN_IF_Send_Tracked(hcan, frame, NULL);
+}
+
+/**
+  * @brief Queue a pool frame for transmission
+  * Header and payload go from the pool frame straight into the registers of
+  * the mailbox named by TSR.CODE, the one HAL_CAN_AddTxMessage() would take,
+  * without a CAN_TxHeaderTypeDef in between. With CAN_IF_RTR_AUTOREPLY the
+  * reserved mailbox is never handed out, so the check and the write must
+  * not be split by another sender (TIM6 ISR). The frame's deadline and
+  * token are recorded for its mailbox in the same critical section.
+  * @param token: NULL, or receives the frame's token (never 0) on HAL_OK;
+  *        CAN_IF_TxCallback() reports the frame under it exactly once
+  * @retval HAL_OK, HAL_BUSY if only the reserved mailbox is free,
+  *         HAL_TIMEOUT if the frame is past its deadline (not sent),
+  *         or HAL_ERROR if no TX mailbox is free
+  */
+HAL_StatusTypeDef CAN_IF_Send_Tracked(CAN_HandleTypeDef *hcan, const CAN_Frame_t *frame, uint32_t *token)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+	CAN_IF_Tx_Slot_t *slot;
+	uint32_t mailbox;
+	uint32_t basepri;
+
+	if(CAN_IF_Expired(frame->deadline, HAL_GetTick()))
+	{
+		can_tx_stats.expired++;
+		return HAL_TIMEOUT;
+	}
+
+	if(hcan->State != HAL_CAN_STATE_READY && hcan->State != HAL_CAN_STATE_LISTENING)
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;	// as HAL_CAN_AddTxMessage()
+		return HAL_ERROR;
+	}
+
+	basepri = Irq_Lock();
+	mailbox = (hcan->Instance->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+	if((hcan->Instance->TSR & (CAN_TSR_TME0 << mailbox)) == 0U)
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_PARAM;	// as HAL_CAN_AddTxMessage(): no free mailbox
+		status = HAL_ERROR;
+	}
+#if CAN_IF_RTR_AUTOREPLY
+	else if(mailbox == CAN_IF_RTR_MAILBOX)
+	{
+		status = HAL_BUSY;
+	}
+#endif
+	else
+	{
+		CAN_IF_Mailbox_Write(&hcan->Instance->sTxMailBox[mailbox], frame);
+		hcan->Instance->sTxMailBox[mailbox].TIR |= CAN_TI0R_TXRQ;
+	}
+	if(status == HAL_OK)
+	{
+		slot = &tx_slot[mailbox];
+		slot->deadline = frame->deadline;
+		slot->token = 0;
+		if(token != NULL)
+		{
+			if(++tx_token == 0U)
+			{
+				tx_token = 1U;				// 0 means untracked
+			}
+			slot->token = tx_token;
+			*token = tx_token;
+		}
+	}
+	Irq_Unlock(basepri);
+
+	if(status == HAL_OK)
+	{
+		Trace_CAN_Frame(TRACE_DIR_TX, frame);
+	}
+
+	return status;
+}
+
+/**
+  * @brief A CAN1 TX mailbox finished (ISR context)
+  * Called from the HAL_CAN_TxMailboxN{Complete,Abort}Callback hooks and,
+  * for mailboxes that ended on an error, from CAN_IF_Tx_Error_Isr(). A
+  * tracked frame gets its completion event; the RTR reply and gateway
+  * frames are untracked.
+  * @param result: CAN_IF_TX_SENT, CAN_IF_TX_ABORTED or CAN_IF_TX_FAILED
+  * @retval None
+  */
+__CAN_ISR void CAN_IF_Tx_Isr(CAN_HandleTypeDef *hcan, uint32_t mailbox, uint32_t result)
+{
+	CAN_IF_Tx_Event_t *event;
+	uint32_t time_us;
+	uint32_t token;
+	uint32_t basepri;
+
+	if(hcan->Instance != CAN1)
+	{
+		return;
+	}
+	time_us = Trace_Time_Us();			// outside the lock, it may wait for SysTick
+	if(result == CAN_IF_TX_FAILED)
+	{
+		can_tx_stats.failed++;
+	}
+	else if(result == CAN_IF_TX_ABORTED)
+	{
+		can_tx_stats.aborted++;			// RQCP without TXOK: the abort took effect
+	}
+
+	basepri = Irq_Lock();
+	token = tx_slot[mailbox].token;
+	tx_slot[mailbox].deadline = 0;
+	tx_slot[mailbox].token = 0;
+	if(token != 0U)
+	{
+		if((tx_event_head - tx_event_tail) < CAN_IF_TX_EVENTS)
+		{
+			event = &tx_events[tx_event_head & (CAN_IF_TX_EVENTS - 1U)];
+			event->token = token;
+			event->result = result;
+			event->time_us = time_us;
+			tx_event_head++;
+		}
+		else
+		{
+			can_tx_stats.events_lost++;
+		}
+	}
+	Irq_Unlock(basepri);
+}
+
+/**
+  * @brief Mailboxes whose request completed unsent with ALST or TERR (ISR context)
+  *
+  * The HAL reports those as HAL_CAN_ERROR_TX_ALSTx/TERRx instead of a TX
+  * callback: a one-shot (CAN_IF_TX_ONESHOT) attempt that failed, or an abort
+  * after a failed attempt. Called from HAL_CAN_ErrorCallback.
+  * @param errorcode: HAL_CAN_ERROR_xxx bit field (hcan->ErrorCode)
+  * @retval None
+  */
+__CAN_ISR void CAN_IF_Tx_Error_Isr(CAN_HandleTypeDef *hcan, uint32_t errorcode)
+{
+	uint32_t mb;
+
+	for(mb = 0; mb < CAN_IF_TX_MAILBOXES; mb++)
+	{
+		if(errorcode & ((HAL_CAN_ERROR_TX_ALST0 | HAL_CAN_ERROR_TX_TERR0) << (2U * mb)))
+		{
+			CAN_IF_Tx_Isr(hcan, mb, CAN_IF_TX_FAILED);
+		}
+	}
+}
+
+/**
+  * @brief Replace the exact-match receive list of a controller
+  *
+  * The list is handed to the bank planner (filter_plan.h), which shares
+  * the 28 banks with CAN2 and the gateway routes. Only this controller's
+  * banks are rewritten, so the console can replace the list at runtime.
+  * @param entries: CAN_FILTER16() encoded entries (can_catalog.h)
+  * @retval None
+  */
+void CAN_IF_Config_List_Filters(CAN_HandleTypeDef *hcan, const uint16_t entries[], uint32_t count)
+{
+	Filter_Plan_Subscribe((hcan->Instance == CAN1) ? FILTER_PLAN_CAN1 : FILTER_PLAN_CAN2,
+			FILTER_PLAN_CLIENT_APP, entries, count);
+	Filter_Plan_Apply();
+}
+
+/**
+  * @brief Number of TX mailboxes CAN_IF_Send() may use
+  * @retval 0..3, the reserved RTR mailbox is not counted
+  */
+uint32_t CAN_IF_Tx_Free(CAN_HandleTypeDef *hcan)
+{
+	uint32_t free = HAL_CAN_GetTxMailboxesFreeLevel(hcan);
+
+#if CAN_IF_RTR_AUTOREPLY
+	if(hcan->Instance->TSR & (CAN_TSR_TME0 << CAN_IF_RTR_MAILBOX))
+	{
+		free--;
+	}
+#endif
+
+	return free;
+}
+
+/**
+  * @brief Route remote requests for one standard ID to FIFO1
+  *
+  * 32-bit list mode on CAN_IF_RTR_FILTER_BANK. A 32-bit filter takes priority
+  * over the 16-bit list banks, so the request never reaches FIFO0 even if the
+  * receive list (or the console) also names it; the data frame with the same
+  * ID is not matched. The planner's current CAN1/CAN2 split is kept.
+  * @retval None
+  */
+void CAN_IF_RTR_Config_Filter(CAN_HandleTypeDef *hcan, uint32_t StdId)
+{
+	CAN_FilterTypeDef filter;
+
+	filter.FilterActivation = CAN_FILTER_ENABLE;
+	filter.FilterBank = CAN_IF_RTR_FILTER_BANK;
+	filter.FilterFIFOAssignment = CAN_FILTER_FIFO1;
+	filter.FilterMode = CAN_FILTERMODE_IDLIST;
+	filter.FilterScale = CAN_FILTERSCALE_32BIT;
+	filter.FilterIdHigh = CAN_FILTER32_HIGH(StdId);
+	filter.FilterIdLow = CAN_RTR_REMOTE;		// IDE = 0, RTR = 1
+	filter.FilterMaskIdHigh = CAN_FILTER32_HIGH(StdId);
+	filter.FilterMaskIdLow = CAN_RTR_REMOTE;
+	filter.SlaveStartFilterBank = (CAN1->FMR & CAN_FMR_CAN2SB) >> CAN_FMR_CAN2SB_Pos;
+
+	if(HAL_CAN_ConfigFilter(hcan, &filter) != HAL_OK)
+	{
+		Error_Handler();
+	}
+}
+
+/**
+  * @brief Write the reply frame into the reserved mailbox without requesting it
+  *
+  * The mailbox registers keep their content after transmission, so one
+  * preload serves every request until the payload changes. Call again with
+  * the new payload; if the reply is in flight the update is deferred.
+  * PRIMASK, not Irq_Lock(): the priority-1 RX1 ISR sets TXRQ on this
+  * mailbox, and Irq_Lock() does not mask it. Five register writes long.
+  * @retval HAL_OK, or HAL_BUSY if the mailbox is still pending
+  */
+HAL_StatusTypeDef CAN_IF_RTR_Preload(CAN_HandleTypeDef *hcan, const CAN_Frame_t *frame)
+{
+	CAN_TxMailBox_TypeDef *mailbox = &hcan->Instance->sTxMailBox[CAN_IF_RTR_MAILBOX];
+	HAL_StatusTypeDef status = HAL_BUSY;
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if(hcan->Instance->TSR & (CAN_TSR_TME0 << CAN_IF_RTR_MAILBOX))
+	{
+		CAN_IF_Mailbox_Write(mailbox, frame);
+		status = HAL_OK;
+	}
+	else
+	{
+		can_rtr_stats.preload_busy++;
+	}
+	__set_PRIMASK(primask);
+
+	return status;
+}
+
+/**
+  * @brief CAN1_RX1 body in auto-reply mode: queue the reply, drop the request
+  *
+  * Replaces HAL_CAN_IRQHandler on this vector. Only FIFO1 message pending is
+  * enabled there, and only CAN_IF_RTR_FILTER_BANK routes to FIFO1, so the
+  * frame is not read. If the previous reply is still queued it also answers
+  * this request.
+  * @param start: Cycles_Now() at vector entry
+  * @retval None
+  */
+__CAN_ISR void CAN_IF_RTR_Isr(CAN_TypeDef *can, uint32_t start)
+{
+	if(can->TSR & (CAN_TSR_TME0 << CAN_IF_RTR_MAILBOX))
+	{
+		can->sTxMailBox[CAN_IF_RTR_MAILBOX].TIR |= CAN_TI0R_TXRQ;
+		Cycle_Stats_Add(&can_rtr_reply_cycles, start);
+		can_rtr_stats.replies++;
+	}
+	else
+	{
+		can_rtr_stats.pending++;
+	}
+	can->RF1R = CAN_RF1R_RFOM1;		// release; FULL1/FOVR1 are write-1-to-clear, left alone
+}
+
+/**
+  * @brief RX frame hook, to be implemented by the application
+  */
+__weak void CAN_IF_RxCallback(CAN_Frame_t *frame)
+{
+	UNUSED(frame);
+}
+
+/**
+  * @brief TX completion hook, to be implemented by the application
+  */
+__weak void CAN_IF_TxCallback(const CAN_IF_Tx_Event_t *event)
+{
+	UNUSED(event);
+}
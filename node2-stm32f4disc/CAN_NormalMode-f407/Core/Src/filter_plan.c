@@ -0,0 +1,489 @@
+/*
+ * filter_plan.c
+ *
+ * Filter bank planner for the shared CAN1/CAN2 banks (node2, F407)
+ * - Filter_Plan_Subscribe(): store a client's entry list, mark its controller
+ * - Filter_Plan_Apply():     plan the marked controllers and write their banks
+ * Both run in main loop context. Banks are written directly: HAL_CAN_ConfigFilter()
+ * toggles FMR.FINIT once per bank and resets CAN2SB on every call.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "filter_plan.h"
+#include "cycles.h"
+#include "log.h"
+
+/* Entries are planned as 12-bit keys: (StdId << 1) | RTR, i.e. CAN_FILTER16() >> 4 */
+#define FILTER_PLAN_KEY_BITS      12U
+#define FILTER_PLAN_KEY_FULL      0x0FFFU
+#define FILTER_PLAN_KEYS          (1UL << FILTER_PLAN_KEY_BITS)
+#define FILTER_PLAN_HALF(key)     ((uint32_t)(key) << 4)             // IDE = 0, EXID[17:15] = 0
+#define FILTER_PLAN_HALF_MASK(m)  (((uint32_t)(m) << 4) | 0x000FU)    // IDE and EXID must match
+#define FILTER_PLAN_GROUPS_MAX    (FILTER_PLAN_CLIENTS * FILTER_PLAN_SUB_MAX)
+#define FILTER_PLAN_AVAIL         (FILTER_PLAN_BANKS - FILTER_PLAN_FIRST_BANK)
+#define FILTER_PLAN_SPLIT_MAX     (FILTER_PLAN_BANKS - 1U)           // CAN2SB range ends at 27
+
+typedef struct
+{
+	uint16_t key;
+	uint16_t mask;                       // FILTER_PLAN_KEY_FULL: exact entry
+} Filter_Plan_Group_t;
+
+typedef struct
+{
+	uint8_t  mask_mode;
+	uint32_t fr1;
+	uint32_t fr2;
+} Filter_Plan_Bank_t;
+
+volatile Filter_Plan_Stats_t filter_plan_stats;
+
+static uint16_t subs[FILTER_PLAN_CANS][FILTER_PLAN_CLIENTS][FILTER_PLAN_SUB_MAX];   // CAN_FILTER16() entries
+static uint8_t  sub_count[FILTER_PLAN_CANS][FILTER_PLAN_CLIENTS];
+static uint8_t  dirty[FILTER_PLAN_CANS];
+static uint8_t  used[FILTER_PLAN_CANS];     // banks currently written per controller
+
+/**
+  * @brief Replace one client's entry list for a controller
+  * The banks are not touched until Filter_Plan_Apply().
+  * @param can: FILTER_PLAN_CAN1 or FILTER_PLAN_CAN2
+  * @param entries: CAN_FILTER16() encoded (ID, RTR) entries
+  * @retval None
+  */
+void Filter_Plan_Subscribe(uint32_t can, uint32_t client, const uint16_t entries[], uint32_t count)
+{
+	uint32_t i;
+
+	if(can >= FILTER_PLAN_CANS || client >= FILTER_PLAN_CLIENTS || count > FILTER_PLAN_SUB_MAX)
+	{
+		Error_Handler();
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		subs[can][client][i] = entries[i];
+	}
+	sub_count[can][client] = (uint8_t)count;
+	dirty[can] = TRUE;
+}
+
+/**
+  * @brief Union of every client's entries, sorted, duplicates removed
+  * @retval number of keys
+  */
+static uint32_t Filter_Plan_Collect(uint32_t can, uint16_t keys[])
+{
+	uint32_t n = 0;
+	uint32_t client;
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
+	uint16_t key;
+
+	for(client = 0; client < FILTER_PLAN_CLIENTS; client++)
+	{
+		for(i = 0; i < sub_count[can][client]; i++)
+		{
+			key = subs[can][client][i] >> 4;
+
+			j = 0;
+			while(j < n && keys[j] < key)
+			{
+				j++;
+			}
+			if(j < n && keys[j] == key)
+			{
+				continue;
+			}
+			for(k = n; k > j; k--)
+			{
+				keys[k] = keys[k - 1U];
+			}
+			keys[j] = key;
+			n++;
+		}
+	}
+	return n;
+}
+
+/**
+  * @brief Banks needed for a number of exact entries and mask groups
+  */
+static uint32_t Filter_Plan_Banks(uint32_t exact, uint32_t masked)
+{
+	return (exact + 3U) / 4U + (masked + 1U) / 2U;
+}
+
+/**
+  * @brief Number of keys a mask admits
+  */
+static uint32_t Filter_Plan_Cover(uint16_t mask)
+{
+	return 1UL << (FILTER_PLAN_KEY_BITS - (uint32_t)__builtin_popcount(mask));
+}
+
+/**
+  * @brief Merge groups until they fit in a bank budget
+  *
+  * Greedy: each step merges the pair whose common mask admits the fewest
+  * additional keys, preferring merges that free a bank. Two exact entries
+  * take the same space as one mask pair, so a merge may only pay off one
+  * step later; every step still removes a group, so the loop ends with a
+  * single group (one bank) at worst. Groups swallowed by the new mask are
+  * dropped.
+  * @retval number of groups
+  */
+static uint32_t Filter_Plan_Pack(Filter_Plan_Group_t g[], uint32_t n, uint32_t budget)
+{
+	uint32_t exact = n;
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
+	uint32_t best_i = 0;
+	uint32_t best_j = 0;
+	uint32_t best_cost;
+	int32_t  best_saved;
+	uint32_t cost;
+	int32_t  saved;
+	uint32_t e;
+	uint16_t mask;
+	uint16_t key;
+
+	while(n > 1U && Filter_Plan_Banks(exact, n - exact) > budget)
+	{
+		best_cost = 0xFFFFFFFFUL;
+		best_saved = -1;
+
+		for(i = 0; i < n; i++)
+		{
+			for(j = i + 1U; j < n; j++)
+			{
+				mask = g[i].mask & g[j].mask & (uint16_t)~(g[i].key ^ g[j].key) & FILTER_PLAN_KEY_FULL;
+				cost = Filter_Plan_Cover(mask) - Filter_Plan_Cover(g[i].mask) - Filter_Plan_Cover(g[j].mask);
+				e = exact - (g[i].mask == FILTER_PLAN_KEY_FULL) - (g[j].mask == FILTER_PLAN_KEY_FULL);
+				saved = (int32_t)Filter_Plan_Banks(exact, n - exact) - (int32_t)Filter_Plan_Banks(e, n - 1U - e);
+
+				if((saved > 0 && best_saved <= 0) ||
+				   ((saved > 0) == (best_saved > 0) && cost < best_cost))
+				{
+					best_i = i;
+					best_j = j;
+					best_cost = cost;
+					best_saved = saved;
+				}
+			}
+		}
+
+		mask = g[best_i].mask & g[best_j].mask & (uint16_t)~(g[best_i].key ^ g[best_j].key) & FILTER_PLAN_KEY_FULL;
+		key = g[best_i].key & mask;
+		g[best_i].key = key;
+		g[best_i].mask = mask;
+
+		for(k = 0, j = 0; k < n; k++)
+		{
+			if(k != best_i && (g[k].key & mask) == key && (g[k].mask & mask) == mask)
+			{
+				continue;	// inside the merged group (best_j among them)
+			}
+			g[j++] = g[k];
+		}
+		n = j;
+
+		for(exact = 0, k = 0; k < n; k++)
+		{
+			exact += (g[k].mask == FILTER_PLAN_KEY_FULL);
+		}
+	}
+	return n;
+}
+
+/**
+  * @brief Keys admitted by the groups that no client subscribed
+  */
+static uint32_t Filter_Plan_False_Accepts(const Filter_Plan_Group_t g[], uint32_t n,
+		const uint16_t keys[], uint32_t nkeys)
+{
+	uint32_t count = 0;
+	uint32_t next = 0;
+	uint32_t key;
+	uint32_t i;
+
+	if(n == nkeys)
+	{
+		return 0;	// nothing merged: exact entries only
+	}
+
+	for(key = 0; key < FILTER_PLAN_KEYS; key++)
+	{
+		if(next < nkeys && keys[next] == key)
+		{
+			next++;
+			continue;
+		}
+		for(i = 0; i < n; i++)
+		{
+			if((key & g[i].mask) == g[i].key)
+			{
+				count++;
+				break;
+			}
+		}
+	}
+	return count;
+}
+
+/**
+  * @brief Lay groups out as banks: 16-bit list banks, then 16-bit mask banks
+  * The last bank of each kind is padded by repeating its last entry.
+  * @retval number of banks
+  */
+static uint32_t Filter_Plan_Layout(const Filter_Plan_Group_t g[], uint32_t n, Filter_Plan_Bank_t banks[])
+{
+	uint32_t half[4];
+	uint32_t nb = 0;
+	uint32_t fill;
+	uint32_t mode;
+	uint32_t i;
+
+	for(mode = 0; mode < 2U; mode++)		// 0: exact entries, 1: mask groups
+	{
+		fill = 0;
+		for(i = 0; i <= n; i++)
+		{
+			if(i < n && (g[i].mask == FILTER_PLAN_KEY_FULL) == (mode == 0U))
+			{
+				if(mode == 0U)
+				{
+					half[fill++] = FILTER_PLAN_HALF(g[i].key);
+				}
+				else
+				{
+					half[fill++] = FILTER_PLAN_HALF(g[i].key);
+					half[fill++] = FILTER_PLAN_HALF_MASK(g[i].mask);
+				}
+			}
+			if(fill == 4U || (i == n && fill != 0U))
+			{
+				for(; fill < 4U; fill++)
+				{
+					half[fill] = half[fill - ((mode == 0U) ? 1U : 2U)];
+				}
+				/* list: FR1 = id1 | id0, FR2 = id3 | id2; mask: FRx = mask | id */
+				banks[nb].mask_mode = (uint8_t)mode;
+				banks[nb].fr1 = (half[1] << 16) | half[0];
+				banks[nb].fr2 = (half[3] << 16) | half[2];
+				nb++;
+				fill = 0;
+			}
+		}
+	}
+	return nb;
+}
+
+/**
+  * @brief Bank numbers of a controller's first n banks as an FA1R bit mask
+  * CAN1 grows up from FILTER_PLAN_FIRST_BANK, CAN2 down from bank 27.
+  */
+static uint32_t Filter_Plan_Bits(uint32_t can, uint32_t n)
+{
+	uint32_t bits = (n != 0U) ? (0xFFFFFFFFUL >> (32U - n)) : 0U;
+
+	return (can == FILTER_PLAN_CAN1) ? (bits << FILTER_PLAN_FIRST_BANK) : (bits << (FILTER_PLAN_BANKS - n));
+}
+
+/**
+  * @brief Plan one controller within a bank budget and write its banks
+  *
+  * Only this controller's old and new banks and, if it has to move, CAN2SB
+  * are written. FMR.FINIT suspends reception on both controllers, so it is
+  * held for the register writes only, under __disable_irq() rather than
+  * Irq_Lock(): SysTick and the priority-1 RTR handler must not stretch it.
+  * @retval None
+  */
+static void Filter_Plan_Apply_One(uint32_t can, uint32_t budget)
+{
+	uint16_t keys[FILTER_PLAN_GROUPS_MAX];
+	Filter_Plan_Group_t groups[FILTER_PLAN_GROUPS_MAX];
+	Filter_Plan_Bank_t banks[FILTER_PLAN_AVAIL];
+	uint32_t other = can ^ 1U;
+	uint32_t nkeys = Filter_Plan_Collect(can, keys);
+	uint32_t ngroups;
+	uint32_t nb;
+	uint32_t lo;
+	uint32_t hi;
+	uint32_t split = (CAN1->FMR & CAN_FMR_CAN2SB) >> CAN_FMR_CAN2SB_Pos;
+	uint32_t old_bits;
+	uint32_t new_bits;
+	uint32_t bank;
+	uint32_t bit;
+	uint32_t start;
+	uint32_t primask;
+	uint32_t i;
+
+	dirty[can] = FALSE;
+
+	if(can == FILTER_PLAN_CAN1 && budget > FILTER_PLAN_SPLIT_MAX - FILTER_PLAN_FIRST_BANK)
+	{
+		budget = FILTER_PLAN_SPLIT_MAX - FILTER_PLAN_FIRST_BANK;	// CAN2SB cannot pass bank 27
+	}
+
+	if(nkeys != 0U && budget == 0U)
+	{
+		LOG_ERROR(LOG_MOD_CAN, "filters: no bank left for CAN%lu (%lu entries)", can + 1U, nkeys);
+		return;
+	}
+
+	for(i = 0; i < nkeys; i++)
+	{
+		groups[i].key = keys[i];
+		groups[i].mask = FILTER_PLAN_KEY_FULL;
+	}
+	ngroups = Filter_Plan_Pack(groups, nkeys, budget);
+	nb = Filter_Plan_Layout(groups, ngroups, banks);
+
+	/* the split stays between both controllers' old and new banks */
+	if(can == FILTER_PLAN_CAN1)
+	{
+		lo = FILTER_PLAN_FIRST_BANK + ((nb > used[can]) ? nb : used[can]);
+		hi = FILTER_PLAN_BANKS - used[other];
+	}
+	else
+	{
+		lo = FILTER_PLAN_FIRST_BANK + used[other];
+		hi = FILTER_PLAN_BANKS - ((nb > used[can]) ? nb : used[can]);
+	}
+	if(hi > FILTER_PLAN_SPLIT_MAX)
+	{
+		hi = FILTER_PLAN_SPLIT_MAX;
+	}
+	if(split < lo || split > hi)
+	{
+		split = (lo + hi) / 2U;
+	}
+
+	old_bits = Filter_Plan_Bits(can, used[can]);
+	new_bits = Filter_Plan_Bits(can, nb);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	start = Cycles_Now();
+
+	SET_BIT(CAN1->FMR, CAN_FMR_FINIT);
+	CLEAR_BIT(CAN1->FA1R, old_bits | new_bits);
+	MODIFY_REG(CAN1->FMR, CAN_FMR_CAN2SB, split << CAN_FMR_CAN2SB_Pos);
+
+	for(i = 0; i < nb; i++)
+	{
+		bank = (can == FILTER_PLAN_CAN1) ? (FILTER_PLAN_FIRST_BANK + i) : (FILTER_PLAN_BANKS - 1U - i);
+		bit = 1UL << bank;
+
+		if(banks[i].mask_mode)
+		{
+			CLEAR_BIT(CAN1->FM1R, bit);
+		}
+		else
+		{
+			SET_BIT(CAN1->FM1R, bit);
+		}
+		CLEAR_BIT(CAN1->FS1R, bit);		// 16-bit scale
+		CLEAR_BIT(CAN1->FFA1R, bit);	// FIFO0
+		CAN1->sFilterRegister[bank].FR1 = banks[i].fr1;
+		CAN1->sFilterRegister[bank].FR2 = banks[i].fr2;
+	}
+
+	SET_BIT(CAN1->FA1R, new_bits);
+	CLEAR_BIT(CAN1->FMR, CAN_FMR_FINIT);
+
+	if((Cycles_Now() - start) > filter_plan_stats.finit_cycles_max)
+	{
+		filter_plan_stats.finit_cycles_max = Cycles_Now() - start;
+	}
+	__set_PRIMASK(primask);
+
+	used[can] = (uint8_t)nb;
+	filter_plan_stats.split = (uint8_t)split;
+	filter_plan_stats.banks[can] = (uint8_t)nb;
+	filter_plan_stats.mask_banks[can] = 0;
+	for(i = 0; i < nb; i++)
+	{
+		filter_plan_stats.mask_banks[can] += banks[i].mask_mode;
+	}
+	filter_plan_stats.entries[can] = (uint16_t)nkeys;
+	filter_plan_stats.false_accepts[can] = (uint16_t)Filter_Plan_False_Accepts(groups, ngroups, keys, nkeys);
+	filter_plan_stats.applies++;
+
+	LOG_INFO(LOG_MOD_CAN, "filters: CAN%lu %lu banks", can + 1U, nb);
+	if(filter_plan_stats.false_accepts[can] != 0U)
+	{
+		LOG_WARN(LOG_MOD_CAN, "filters: CAN%lu over-accepts %lu IDs", can + 1U,
+				filter_plan_stats.false_accepts[can]);
+	}
+}
+
+/**
+  * @brief Exact-match bank count of a controller's current subscriptions
+  */
+static uint32_t Filter_Plan_Need(uint32_t can)
+{
+	uint16_t keys[FILTER_PLAN_GROUPS_MAX];
+
+	return (Filter_Plan_Collect(can, keys) + 3U) / 4U;
+}
+
+/**
+  * @brief Re-plan every controller whose subscriptions changed
+  *
+  * One changed controller may use every bank the other does not. If both
+  * changed (startup), the banks are shared in proportion to their exact
+  * needs and the shrinking controller is written first, so the split can
+  * always move through free banks.
+  * @retval None
+  */
+void Filter_Plan_Apply(void)
+{
+	uint32_t budget[FILTER_PLAN_CANS];
+	uint32_t need1;
+	uint32_t need2;
+
+	if(dirty[FILTER_PLAN_CAN1] && dirty[FILTER_PLAN_CAN2])
+	{
+		need1 = Filter_Plan_Need(FILTER_PLAN_CAN1);
+		need2 = Filter_Plan_Need(FILTER_PLAN_CAN2);
+
+		if(need1 + need2 <= FILTER_PLAN_AVAIL)
+		{
+			budget[FILTER_PLAN_CAN1] = need1;
+			budget[FILTER_PLAN_CAN2] = need2;
+		}
+		else
+		{
+			budget[FILTER_PLAN_CAN1] = FILTER_PLAN_AVAIL * need1 / (need1 + need2);
+			if(budget[FILTER_PLAN_CAN1] == 0U)
+			{
+				budget[FILTER_PLAN_CAN1] = 1U;
+			}
+			if(budget[FILTER_PLAN_CAN1] == FILTER_PLAN_AVAIL)
+			{
+				budget[FILTER_PLAN_CAN1] = FILTER_PLAN_AVAIL - 1U;
+			}
+			budget[FILTER_PLAN_CAN2] = FILTER_PLAN_AVAIL - budget[FILTER_PLAN_CAN1];
+		}
+
+		if(budget[FILTER_PLAN_CAN2] < used[FILTER_PLAN_CAN2])
+		{
+			Filter_Plan_Apply_One(FILTER_PLAN_CAN2, budget[FILTER_PLAN_CAN2]);
+		}
+		Filter_Plan_Apply_One(FILTER_PLAN_CAN1, budget[FILTER_PLAN_CAN1]);
+	}
+	else if(dirty[FILTER_PLAN_CAN1])
+	{
+		Filter_Plan_Apply_One(FILTER_PLAN_CAN1, FILTER_PLAN_AVAIL - used[FILTER_PLAN_CAN2]);
+	}
+
+	if(dirty[FILTER_PLAN_CAN2])
+	{
+		Filter_Plan_Apply_One(FILTER_PLAN_CAN2, FILTER_PLAN_AVAIL - used[FILTER_PLAN_CAN1]);
+	}
+}
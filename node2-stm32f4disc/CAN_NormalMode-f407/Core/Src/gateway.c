@@ -0,0 +1,391 @@
+/*
+ * gateway.c
+ *
+ * CAN1 <-> CAN2 gateway (node2, F407)
+ * - Gateway_RxIsr():   FIFO0 ISR of either controller, routes and forwards
+ * - Gateway_Process(): main loop, drains the slow-path queues and reports
+ * A queue has one producer (the RX ISR of its source) and one consumer
+ * (the main loop); mailbox selection and write run under Irq_Lock() there.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "gateway.h"
+
+#if GATEWAY_ENABLE
+#include "can_if.h"
+#include "can_catalog.h"
+#include "filter_plan.h"
+#include "log.h"
+
+#define GATEWAY_NO_MAILBOX        3U
+
+/* --- Routing tables: segment slave n appears as node n + 16 on the backbone --- */
+
+/* CAN1 (backbone) -> CAN2 (segment) */
+static const Gateway_Route_t routes_1to2[] =
+{
+	{ CAN_ID_LED_CMD,                 CAN_ID_LED_CMD,               0U,    0U, GATEWAY_ROUTE_LOCAL },
+	{ CAN_ID_SENSOR_DATA_NODE(17U),   CAN_ID_SENSOR_DATA_NODE(1U),  0U,    0U, GATEWAY_ROUTE_REMOTE },
+	{ CAN_ID_SENSOR_DATA_NODE(18U),   CAN_ID_SENSOR_DATA_NODE(2U),  0U,    0U, GATEWAY_ROUTE_REMOTE },
+	{ CAN_ID_SENSOR_DATA_NODE(19U),   CAN_ID_SENSOR_DATA_NODE(3U),  0U,    0U, GATEWAY_ROUTE_REMOTE },
+	{ CAN_ID_SENSOR_DATA_NODE(20U),   CAN_ID_SENSOR_DATA_NODE(4U),  0U,    0U, GATEWAY_ROUTE_REMOTE },
+};
+
+/* CAN2 (segment) -> CAN1 (backbone): replies translated, a babbling slave is capped */
+static const Gateway_Route_t routes_2to1[] =
+{
+	{ CAN_ID_SENSOR_DATA_NODE(1U),    CAN_ID_SENSOR_DATA_NODE(17U), 5U,  100U, 0U },
+	{ CAN_ID_SENSOR_DATA_NODE(2U),    CAN_ID_SENSOR_DATA_NODE(18U), 5U,  100U, 0U },
+	{ CAN_ID_SENSOR_DATA_NODE(3U),    CAN_ID_SENSOR_DATA_NODE(19U), 5U,  100U, 0U },
+	{ CAN_ID_SENSOR_DATA_NODE(4U),    CAN_ID_SENSOR_DATA_NODE(20U), 5U,  100U, 0U },
+};
+
+typedef struct
+{
+	const Gateway_Route_t *routes;
+	uint32_t count;
+	CAN_TypeDef *dst;
+} Gateway_Table_t;
+
+static const Gateway_Table_t tables[GATEWAY_DIRS] =
+{
+	{ routes_1to2, sizeof(routes_1to2) / sizeof(routes_1to2[0]), CAN2 },
+	{ routes_2to1, sizeof(routes_2to1) / sizeof(routes_2to1[0]), CAN1 },
+};
+
+typedef struct
+{
+	uint16_t tokens;
+	uint32_t refill_tick;
+} Gateway_Bucket_t;
+
+extern CAN_HandleTypeDef hcan2;
+
+volatile Gateway_Route_Stats_t gateway_stats[GATEWAY_DIRS][GATEWAY_ROUTES_MAX];
+volatile uint32_t gateway_can2_errors;
+
+static Gateway_Bucket_t buckets[GATEWAY_DIRS][GATEWAY_ROUTES_MAX];
+static Frame_Ring_t queue[GATEWAY_DIRS] __CAN_BUFFER;
+static uint32_t last_mailbox[GATEWAY_DIRS];            // mailbox of the last frame forwarded
+static uint32_t reported[GATEWAY_DIRS][GATEWAY_ROUTES_MAX];   // dropped + rate_limited at the last report
+static uint32_t report_tick = 0;
+
+/**
+  * @brief Subscribe the source IDs of one table on its receiving controller
+  */
+static void Gateway_Subscribe(uint32_t can, const Gateway_Table_t *table)
+{
+	uint16_t entries[GATEWAY_ROUTES_MAX];
+	uint32_t i;
+
+	for(i = 0; i < table->count; i++)
+	{
+		entries[i] = CAN_FILTER16(table->routes[i].src_id,
+				(table->routes[i].flags & GATEWAY_ROUTE_REMOTE) ? 1U : 0U);
+	}
+	Filter_Plan_Subscribe(can, FILTER_PLAN_CLIENT_GATEWAY, entries, table->count);
+}
+
+/**
+  * @brief Program the filters and start CAN2 (CAN2_Init() done, CAN1 not started)
+  * @retval None
+  */
+void Gateway_Init(void)
+{
+	uint32_t dir;
+	uint32_t i;
+
+	for(dir = 0; dir < GATEWAY_DIRS; dir++)
+	{
+		if(tables[dir].count > GATEWAY_ROUTES_MAX)
+		{
+			Error_Handler();
+		}
+		for(i = 0; i < tables[dir].count; i++)
+		{
+			buckets[dir][i].tokens = tables[dir].routes[i].burst;
+		}
+		queue[dir].head = 0;
+		queue[dir].tail = 0;
+	}
+
+	Gateway_Subscribe(FILTER_PLAN_CAN1, &tables[GATEWAY_DIR_1TO2]);
+	Gateway_Subscribe(FILTER_PLAN_CAN2, &tables[GATEWAY_DIR_2TO1]);
+	Filter_Plan_Apply();
+
+	if(HAL_CAN_ActivateNotification(&hcan2,
+			CAN_IT_RX_FIFO0_MSG_PENDING |
+			CAN_IT_BUSOFF |
+			CAN_IT_ERROR_PASSIVE |
+			CAN_IT_ERROR) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	if(HAL_CAN_Start(&hcan2) != HAL_OK)
+	{
+		Error_Handler();
+	}
+}
+
+/**
+  * @brief Route lookup on the FIFO output mailbox identifier
+  * @retval route index, or GATEWAY_ROUTES_MAX if the frame is not routed
+  */
+static __CAN_ISR uint32_t Gateway_Find(const Gateway_Table_t *table, uint32_t rir)
+{
+	uint32_t id = rir >> CAN_RI0R_STID_Pos;
+	uint8_t remote = (rir & CAN_RI0R_RTR) ? GATEWAY_ROUTE_REMOTE : 0U;
+	uint32_t i;
+
+	if(rir & CAN_RI0R_IDE)
+	{
+		return GATEWAY_ROUTES_MAX;
+	}
+
+	for(i = 0; i < table->count; i++)
+	{
+		if(table->routes[i].src_id == id && (table->routes[i].flags & GATEWAY_ROUTE_REMOTE) == remote)
+		{
+			return i;
+		}
+	}
+	return GATEWAY_ROUTES_MAX;
+}
+
+/**
+  * @brief Token bucket of one route (same scheme as Log_Admit)
+  * @retval TRUE if the frame may be forwarded
+  */
+static __CAN_ISR uint8_t Gateway_Admit(Gateway_Bucket_t *bucket, const Gateway_Route_t *route)
+{
+	if(route->burst == 0U)
+	{
+		return TRUE;
+	}
+	if(bucket->tokens != 0U)
+	{
+		bucket->tokens--;
+		return TRUE;
+	}
+	if((uwTick - bucket->refill_tick) >= route->period_ms)
+	{
+		bucket->refill_tick = uwTick;
+		bucket->tokens = route->burst - 1U;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+  * @brief Pick the destination TX mailbox for the next forwarded frame
+  *
+  * TSR.CODE names the lowest empty mailbox. Without TX FIFO priority, equal
+  * IDs leave lowest mailbox first, so a mailbox below a still pending
+  * gateway frame is refused: the route would overtake itself. On CAN1 the
+  * RTR auto-reply mailbox is never taken (see CAN_IF_Send).
+  * @retval mailbox 0..2, or GATEWAY_NO_MAILBOX
+  */
+static __CAN_ISR uint32_t Gateway_Tx_Mailbox(uint32_t dir)
+{
+	CAN_TypeDef *dst = tables[dir].dst;
+	uint32_t tsr = dst->TSR;
+	uint32_t mailbox;
+
+	if((tsr & CAN_TSR_TME) == 0U)
+	{
+		return GATEWAY_NO_MAILBOX;
+	}
+	mailbox = (tsr & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+
+#if CAN_IF_RTR_AUTOREPLY
+	if(dst == CAN1 && mailbox == CAN_IF_RTR_MAILBOX)
+	{
+		return GATEWAY_NO_MAILBOX;
+	}
+#endif
+	if(mailbox < last_mailbox[dir] && (tsr & (CAN_TSR_TME0 << last_mailbox[dir])) == 0U)
+	{
+		return GATEWAY_NO_MAILBOX;
+	}
+	return mailbox;
+}
+
+/**
+  * @brief Write a frame into a TX mailbox and request it, TIR last
+  */
+static __CAN_ISR void Gateway_Tx_Write(uint32_t dir, uint32_t mailbox, uint32_t tir, uint32_t dlc,
+		uint32_t tdlr, uint32_t tdhr)
+{
+	CAN_TxMailBox_TypeDef *out = &tables[dir].dst->sTxMailBox[mailbox];
+
+	out->TDTR = dlc;
+	out->TDLR = tdlr;
+	out->TDHR = tdhr;
+	out->TIR = tir | CAN_TI0R_TXRQ;
+	last_mailbox[dir] = mailbox;
+}
+
+/**
+  * @brief Queue a frame for Gateway_Process() when no mailbox can take it
+  */
+static __CAN_ISR void Gateway_Queue(uint32_t dir, uint32_t route, uint32_t tir, uint32_t dlc,
+		uint32_t tdlr, uint32_t tdhr, uint32_t start)
+{
+	CAN_Frame_t *frame;
+
+	if((queue[dir].head - queue[dir].tail) >= GATEWAY_QUEUE_DEPTH || (frame = Frame_Pool_Alloc()) == NULL)
+	{
+		gateway_stats[dir][route].dropped++;
+		return;
+	}
+
+	CAN_IF_Frame_Std(frame, tir >> CAN_TI0R_STID_Pos, tir & CAN_TI0R_RTR, dlc);
+	CAN_IF_Frame_Deadline(frame, GATEWAY_QUEUE_DEADLINE_MS);
+	frame->header.FilterMatchIndex = route;		// reused: route index for the latency counter
+	frame->data[0] = (uint8_t)tdlr;
+	frame->data[1] = (uint8_t)(tdlr >> 8);
+	frame->data[2] = (uint8_t)(tdlr >> 16);
+	frame->data[3] = (uint8_t)(tdlr >> 24);
+	frame->data[4] = (uint8_t)tdhr;
+	frame->data[5] = (uint8_t)(tdhr >> 8);
+	frame->data[6] = (uint8_t)(tdhr >> 16);
+	frame->data[7] = (uint8_t)(tdhr >> 24);
+	frame->stamp = start;
+
+	if(Frame_Ring_Push(&queue[dir], frame) == FALSE)
+	{
+		Frame_Pool_Release(frame);
+		gateway_stats[dir][route].dropped++;
+		return;
+	}
+	gateway_stats[dir][route].queued++;
+}
+
+/**
+  * @brief Forward the frame at the FIFO0 output of a controller (ISR context)
+  *
+  * The identifier is translated and the payload registers are copied
+  * mailbox to mailbox. Routed frames are released from the FIFO unless the
+  * route has GATEWAY_ROUTE_LOCAL; unrouted and local frames are left for
+  * CAN_IF_RxIsr().
+  * @param src: CAN1 or CAN2
+  * @param start: Cycles_Now() at ISR entry
+  * @retval TRUE if the frame was consumed
+  */
+__CAN_ISR uint8_t Gateway_RxIsr(CAN_TypeDef *src, uint32_t start)
+{
+	uint32_t dir = (src == CAN1) ? GATEWAY_DIR_1TO2 : GATEWAY_DIR_2TO1;
+	CAN_FIFOMailBox_TypeDef *in = &src->sFIFOMailBox[CAN_RX_FIFO0];
+	uint32_t rir = in->RIR;
+	uint32_t route = Gateway_Find(&tables[dir], rir);
+	const Gateway_Route_t *entry;
+	uint32_t tir;
+	uint32_t mailbox;
+
+	if(route == GATEWAY_ROUTES_MAX)
+	{
+		return FALSE;
+	}
+	entry = &tables[dir].routes[route];
+
+	if(Gateway_Admit(&buckets[dir][route], entry) == FALSE)
+	{
+		gateway_stats[dir][route].rate_limited++;
+	}
+	else
+	{
+		tir = ((uint32_t)entry->dst_id << CAN_TI0R_STID_Pos) | (rir & CAN_RI0R_RTR);
+		mailbox = (queue[dir].head == queue[dir].tail) ? Gateway_Tx_Mailbox(dir) : GATEWAY_NO_MAILBOX;
+
+		if(mailbox != GATEWAY_NO_MAILBOX)
+		{
+			Gateway_Tx_Write(dir, mailbox, tir, in->RDTR & CAN_RDT0R_DLC, in->RDLR, in->RDHR);
+			Cycle_Stats_Add(&gateway_stats[dir][route].latency, start);
+			gateway_stats[dir][route].forwarded++;
+		}
+		else
+		{
+			Gateway_Queue(dir, route, tir, in->RDTR & CAN_RDT0R_DLC, in->RDLR, in->RDHR, start);
+		}
+	}
+
+	if(entry->flags & GATEWAY_ROUTE_LOCAL)
+	{
+		return FALSE;
+	}
+	src->RF0R = CAN_RF0R_RFOM0;
+	return TRUE;
+}
+
+/**
+  * @brief Send queued frames as mailboxes free up, report drops (main loop)
+  * A frame past its deadline is dropped when it reaches the mailbox, and
+  * the next one takes the mailbox.
+  * @retval None
+  */
+void Gateway_Process(void)
+{
+	CAN_Frame_t *frame;
+	uint32_t dir;
+	uint32_t i;
+	uint32_t mailbox;
+	uint32_t lost;
+	uint32_t basepri;
+
+	for(dir = 0; dir < GATEWAY_DIRS; dir++)
+	{
+		while(queue[dir].head != queue[dir].tail)
+		{
+			basepri = Irq_Lock();
+			mailbox = Gateway_Tx_Mailbox(dir);
+			if(mailbox == GATEWAY_NO_MAILBOX)
+			{
+				Irq_Unlock(basepri);
+				break;
+			}
+			frame = Frame_Ring_Pop(&queue[dir]);
+			if(CAN_IF_Expired(frame->deadline, HAL_GetTick()))
+			{
+				Irq_Unlock(basepri);
+				gateway_stats[dir][frame->header.FilterMatchIndex].expired++;
+				Frame_Pool_Release(frame);
+				continue;
+			}
+			Gateway_Tx_Write(dir, mailbox, (frame->header.StdId << CAN_TI0R_STID_Pos) | frame->header.RTR,
+					frame->header.DLC,
+					((uint32_t)frame->data[3] << 24) | ((uint32_t)frame->data[2] << 16) |
+					((uint32_t)frame->data[1] << 8)  |  (uint32_t)frame->data[0],
+					((uint32_t)frame->data[7] << 24) | ((uint32_t)frame->data[6] << 16) |
+					((uint32_t)frame->data[5] << 8)  |  (uint32_t)frame->data[4]);
+			Cycle_Stats_Add(&gateway_stats[dir][frame->header.FilterMatchIndex].latency, frame->stamp);
+			Irq_Unlock(basepri);
+
+			Frame_Pool_Release(frame);
+		}
+	}
+
+	if((HAL_GetTick() - report_tick) < GATEWAY_REPORT_MS)
+	{
+		return;
+	}
+	report_tick = HAL_GetTick();
+
+	for(dir = 0; dir < GATEWAY_DIRS; dir++)
+	{
+		for(i = 0; i < tables[dir].count; i++)
+		{
+			lost = gateway_stats[dir][i].dropped + gateway_stats[dir][i].rate_limited +
+					gateway_stats[dir][i].expired;
+			if(lost != reported[dir][i])
+			{
+				LOG_WARN(LOG_MOD_CAN, "gateway 0x%03lX: %lu frames not forwarded",
+						tables[dir].routes[i].src_id, lost - reported[dir][i]);
+				reported[dir][i] = lost;
+			}
+		}
+	}
+}
+#endif /* GATEWAY_ENABLE */
@@ -9,10 +9,199 @@
  */
 
 #include "main.h"
+#include "it.h"
+#include "can_if.h"
+#include "gateway.h"
+#include "power.h"
+#include "sensor.h"
 
 extern UART_HandleTypeDef huart2;
+extern DMA_HandleTypeDef  hdma_usart2_tx;
+extern DMA_HandleTypeDef  hdma_usart2_rx;
+extern DMA_HandleTypeDef  hdma_adc1;
 extern TIM_HandleTypeDef htimer6;
 extern CAN_HandleTypeDef hcan1;
+#if GATEWAY_ENABLE
+extern CAN_HandleTypeDef hcan2;
+#endif
+
+volatile Cycle_Stats_t can_isr_cycles[CAN_ISR_COUNT];
+
+#if CAN_ISR_LEAN
+#if USE_HAL_CAN_REGISTER_CALLBACKS
+#error "CAN_ISR_LEAN calls the HAL_CAN_xxxCallback functions directly"
+#endif
+
+/* One TX mailbox's TSR bits are the mailbox 0 bits shifted by 8 * n */
+#define CAN_TSR_MAILBOX_SHIFT  8U
+
+static void (* const can_tx_complete[3])(CAN_HandleTypeDef *hcan) =
+{
+	HAL_CAN_TxMailbox0CompleteCallback,
+	HAL_CAN_TxMailbox1CompleteCallback,
+	HAL_CAN_TxMailbox2CompleteCallback
+};
+
+static void (* const can_tx_abort[3])(CAN_HandleTypeDef *hcan) =
+{
+	HAL_CAN_TxMailbox0AbortCallback,
+	HAL_CAN_TxMailbox1AbortCallback,
+	HAL_CAN_TxMailbox2AbortCallback
+};
+
+/**
+  * @brief Hand the error bits collected by a vector to HAL_CAN_ErrorCallback
+  * Same contract as HAL_CAN_IRQHandler: accumulated in hcan->ErrorCode.
+  */
+static __CAN_ISR void CAN_Isr_Error(CAN_HandleTypeDef *hcan, uint32_t errorcode)
+{
+	if(errorcode != HAL_CAN_ERROR_NONE)
+	{
+		hcan->ErrorCode |= errorcode;
+		HAL_CAN_ErrorCallback(hcan);
+	}
+}
+
+/**
+  * @brief TX vector: only TSR, one read, request-complete flags of finished mailboxes
+  */
+static __CAN_ISR void CAN_Isr_Tx(CAN_HandleTypeDef *hcan)
+{
+	uint32_t tsr = hcan->Instance->TSR;
+	uint32_t errorcode = HAL_CAN_ERROR_NONE;
+	uint32_t bits;
+	uint32_t mb;
+
+	for(mb = 0; mb < 3U; mb++)
+	{
+		bits = tsr >> (CAN_TSR_MAILBOX_SHIFT * mb);
+		if((bits & CAN_TSR_RQCP0) == 0U)
+		{
+			continue;
+		}
+		hcan->Instance->TSR = CAN_TSR_RQCP0 << (CAN_TSR_MAILBOX_SHIFT * mb);	// w1c, also clears TXOK/ALST/TERR
+
+		if((bits & CAN_TSR_TXOK0) != 0U)
+		{
+			can_tx_complete[mb](hcan);
+		}
+		else if((bits & CAN_TSR_ALST0) != 0U)
+		{
+			errorcode |= HAL_CAN_ERROR_TX_ALST0 << (2U * mb);
+		}
+		else if((bits & CAN_TSR_TERR0) != 0U)
+		{
+			errorcode |= HAL_CAN_ERROR_TX_TERR0 << (2U * mb);
+		}
+		else
+		{
+			can_tx_abort[mb](hcan);
+		}
+	}
+	CAN_Isr_Error(hcan, errorcode);
+}
+
+/**
+  * @brief RX0 vector: only IER and RF0R
+  * The frame hook is the same one HAL_CAN_IRQHandler would call
+  * (HAL_CAN_RxFifo0MsgPendingCallback in main.c), one frame per entry like
+  * HAL so that can_isr_cycles stays comparable; the interrupt source
+  * switching of CAN_IF_Poll() keeps working through IER.
+  */
+static __CAN_ISR void CAN_Isr_Rx0(CAN_HandleTypeDef *hcan)
+{
+	CAN_TypeDef *can = hcan->Instance;
+	uint32_t ier = can->IER;
+	uint32_t rf0r = can->RF0R;
+
+	if((rf0r & CAN_RF0R_FOVR0) != 0U && (ier & CAN_IER_FOVIE0) != 0U)
+	{
+		can->RF0R = CAN_RF0R_FOVR0;
+		CAN_Isr_Error(hcan, HAL_CAN_ERROR_RX_FOV0);
+	}
+	if((rf0r & CAN_RF0R_FULL0) != 0U && (ier & CAN_IER_FFIE0) != 0U)
+	{
+		can->RF0R = CAN_RF0R_FULL0;
+		HAL_CAN_RxFifo0FullCallback(hcan);
+	}
+	else if((rf0r & CAN_RF0R_FMP0) != 0U && (ier & CAN_IER_FMPIE0) != 0U)
+	{
+		HAL_CAN_RxFifo0MsgPendingCallback(hcan);
+	}
+}
+
+#if !CAN_IF_RTR_AUTOREPLY
+/**
+  * @brief RX1 vector: only IER and RF1R
+  */
+static __CAN_ISR void CAN_Isr_Rx1(CAN_HandleTypeDef *hcan)
+{
+	CAN_TypeDef *can = hcan->Instance;
+	uint32_t ier = can->IER;
+	uint32_t rf1r = can->RF1R;
+
+	if((rf1r & CAN_RF1R_FOVR1) != 0U && (ier & CAN_IER_FOVIE1) != 0U)
+	{
+		can->RF1R = CAN_RF1R_FOVR1;
+		CAN_Isr_Error(hcan, HAL_CAN_ERROR_RX_FOV1);
+	}
+	if((rf1r & CAN_RF1R_FULL1) != 0U && (ier & CAN_IER_FFIE1) != 0U)
+	{
+		can->RF1R = CAN_RF1R_FULL1;
+		HAL_CAN_RxFifo1FullCallback(hcan);
+	}
+	if((rf1r & CAN_RF1R_FMP1) != 0U && (ier & CAN_IER_FMPIE1) != 0U)
+	{
+		HAL_CAN_RxFifo1MsgPendingCallback(hcan);
+	}
+}
+#endif
+
+/**
+  * @brief SCE vector: only IER, MSR and ESR
+  * Error classes are decoded as in HAL_CAN_IRQHandler; LEC 1..6 map to
+  * HAL_CAN_ERROR_STF..HAL_CAN_ERROR_CRC in order.
+  */
+static __CAN_ISR void CAN_Isr_Sce(CAN_HandleTypeDef *hcan)
+{
+	CAN_TypeDef *can = hcan->Instance;
+	uint32_t ier = can->IER;
+	uint32_t msr = can->MSR;
+	uint32_t esr;
+	uint32_t lec;
+	uint32_t errorcode = HAL_CAN_ERROR_NONE;
+
+	if((msr & CAN_MSR_SLAKI) != 0U && (ier & CAN_IER_SLKIE) != 0U)
+	{
+		can->MSR = CAN_MSR_SLAKI;
+		HAL_CAN_SleepCallback(hcan);
+	}
+	if((msr & CAN_MSR_WKUI) != 0U && (ier & CAN_IER_WKUIE) != 0U)
+	{
+		can->MSR = CAN_MSR_WKUI;
+		HAL_CAN_WakeUpFromRxMsgCallback(hcan);
+	}
+	if((msr & CAN_MSR_ERRI) != 0U && (ier & CAN_IER_ERRIE) != 0U)
+	{
+		esr = can->ESR;
+		if((esr & CAN_ESR_EWGF) != 0U && (ier & CAN_IER_EWGIE) != 0U) { errorcode |= HAL_CAN_ERROR_EWG; }
+		if((esr & CAN_ESR_EPVF) != 0U && (ier & CAN_IER_EPVIE) != 0U) { errorcode |= HAL_CAN_ERROR_EPV; }
+		if((esr & CAN_ESR_BOFF) != 0U && (ier & CAN_IER_BOFIE) != 0U) { errorcode |= HAL_CAN_ERROR_BOF; }
+
+		lec = (esr & CAN_ESR_LEC) >> CAN_ESR_LEC_Pos;
+		if(lec != 0U && (ier & CAN_IER_LECIE) != 0U)
+		{
+			if(lec < 7U)
+			{
+				errorcode |= HAL_CAN_ERROR_STF << (lec - 1U);
+			}
+			CLEAR_BIT(can->ESR, CAN_ESR_LEC);
+		}
+		can->MSR = CAN_MSR_ERRI;
+	}
+	CAN_Isr_Error(hcan, errorcode);
+}
+#endif
 
 /**
   * @brief Handles System tick interrupt for HAL timekeeping
@@ -32,38 +221,131 @@ void USART2_IRQHandler(void)
 	HAL_UART_IRQHandler(&huart2);
 }
 
+/**
+  * @brief Handles the USART2 RX DMA channel (command console)
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&hdma_usart2_rx);
+}
+
+/**
+  * @brief Handles the USART2 TX DMA channel (debug link)
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&hdma_usart2_tx);
+}
+
+/**
+  * @brief Handles the ADC1 DMA stream (sensor samples, half and full buffer)
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&hdma_adc1);
+}
+
+/**
+  * @brief Handles ADC1 interrupts (sensor overrun)
+  */
+void ADC_IRQHandler(void)
+{
+	Sensor_Adc_Isr();
+}
+
 /**
   * @brief Handles CAN1 Transmit interrupt
   */
-void CAN1_TX_IRQHandler(void)
+__CAN_ISR void CAN1_TX_IRQHandler(void)
 {
+	uint32_t start = Cycles_Now();
+
+#if CAN_ISR_LEAN
+	CAN_Isr_Tx(&hcan1);
+#else
 	HAL_CAN_IRQHandler(&hcan1);
+#endif
+	Cycle_Stats_Add(&can_isr_cycles[CAN_ISR_TX], start);
 }
 
 /**
   * @brief Handles CAN1 Receive FIFO0 interrupt
   */
-void CAN1_RX0_IRQHandler()
+__CAN_ISR void CAN1_RX0_IRQHandler(void)
 {
+	uint32_t start = Cycles_Now();
+
+#if CAN_ISR_LEAN
+	CAN_Isr_Rx0(&hcan1);
+#else
 	HAL_CAN_IRQHandler(&hcan1);
+#endif
+	Cycle_Stats_Add(&can_isr_cycles[CAN_ISR_RX0], start);
 }
 
 /**
   * @brief Handles CAN1 Receive FIFO1 interrupt
   */
-void CAN1_RX1_IRQHandler()
+__CAN_ISR void CAN1_RX1_IRQHandler(void)
 {
+	uint32_t start = Cycles_Now();
+
+#if CAN_IF_RTR_AUTOREPLY
+	CAN_IF_RTR_Isr(hcan1.Instance, start);	// FIFO1 carries only the remote request
+#elif CAN_ISR_LEAN
+	CAN_Isr_Rx1(&hcan1);
+#else
 	HAL_CAN_IRQHandler(&hcan1);
+#endif
+	Cycle_Stats_Add(&can_isr_cycles[CAN_ISR_RX1], start);
 }
 
 /**
   * @brief Handles CAN1 Status Change/Error interrupt
   */
-void CAN1_SCE_IRQHandler(void)
+__CAN_ISR void CAN1_SCE_IRQHandler(void)
 {
+	uint32_t start = Cycles_Now();
+
+#if CAN_ISR_LEAN
+	CAN_Isr_Sce(&hcan1);
+#else
 	HAL_CAN_IRQHandler(&hcan1);
+#endif
+	Cycle_Stats_Add(&can_isr_cycles[CAN_ISR_SCE], start);
+}
+
+#if GATEWAY_ENABLE
+/**
+  * @brief Handles CAN2 Receive FIFO0 interrupt (gateway segment)
+  * Every pending frame is forwarded to CAN1; local routes also go to the RX ring.
+  */
+__CAN_ISR void CAN2_RX0_IRQHandler(void)
+{
+	uint32_t start = Cycles_Now();
+
+	while(CAN2->RF0R & CAN_RF0R_FMP0)
+	{
+		if(Gateway_RxIsr(CAN2, start) == FALSE)
+		{
+			CAN_IF_RxIsr(&hcan2, CAN_RX_FIFO0);
+		}
+	}
 }
 
+/**
+  * @brief Handles CAN2 Status Change/Error interrupt
+  */
+__CAN_ISR void CAN2_SCE_IRQHandler(void)
+{
+#if CAN_ISR_LEAN
+	CAN_Isr_Sce(&hcan2);
+#else
+	HAL_CAN_IRQHandler(&hcan2);
+#endif
+}
+#endif
+
 /**
   * @brief Handles Timer 6 interrupt and DAC underrun interrupts (used as 1 Hz time base).
   */
@@ -82,6 +364,15 @@ void EXTI0_IRQHandler(void)
 	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
 }
 
+/**
+  * @brief Handles EXTI line[9:5] interrupts.
+  * In this project: CAN RX edge ending Stop mode (PB8).
+  */
+void EXTI9_5_IRQHandler(void)
+{
+	Power_Wake_Isr();
+}
+
 
 
 
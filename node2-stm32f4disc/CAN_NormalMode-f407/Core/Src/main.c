@@ -4,8 +4,16 @@
  * STM32 CAN Communication (Node2 - STM32F407G-DISC1)
  *
  * Role of Node2: CAN Slave
- *   - Receives LED commands from Node1 (Data Frame, ID: 0x65D)
- *   - Responds to Remote Frames (ID: 0x651) with 2-byte reply (0xAB, 0xCD)
+ *   - Receives LED commands from Node1 (Data Frame, CAN_ID_LED_CMD)
+ *   - Node ID from a strap, OTP or flash constant (node_id.h); any number of
+ *     slaves run this image, each on its own CAN_ID_SENSOR_DATA_NODE(node_id)
+ *   - Responds to Remote Frames (CAN_ID_SENSOR_DATA_NODE) with the latest filtered
+ *     ADC sample (sensor.h), from a preloaded TX mailbox when CAN_IF_RTR_AUTOREPLY
+ *     is set (can_if.h); the mailbox is reloaded whenever a new sample is published
+ *   - Answers the broadcast request (CAN_ID_SENSOR_DATA) in its reply slot
+ *   - Sends one min/max/mean/count summary per signal and window (aggregate.h)
+ *   - Optionally bridges CAN1 and a CAN2 segment (GATEWAY_ENABLE, gateway.h)
+ *   - IDs, DLCs and byte layouts come from can_catalog.h (tools/can_catalog)
  *   - Blinks onboard LEDs (PD12–PD15) depending on received command
  *   - Sends debug messages over UART2 (via ST-LINK VCP)
  *
@@ -14,16 +22,39 @@
  */
 
 #include "main.h"
-#include <stdio.h>
-#include <string.h>
+#include "can_diag.h"
+#include "can_if.h"
+#include "can_catalog.h"
+#include "cycles.h"
+#include "uart_link.h"
+#include "trace.h"
+#include "console.h"
+#include "log.h"
+#include "publish.h"
+#include "node_id.h"
+#include "power.h"
+#include "gateway.h"
+#include "sensor.h"
+#include "aggregate.h"
 
 /* --- Peripheral handles --- */
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef  hdma_usart2_tx;
+DMA_HandleTypeDef  hdma_usart2_rx;
+DMA_HandleTypeDef  hdma_adc1;
 TIM_HandleTypeDef  htimer6;
 CAN_HandleTypeDef  hcan1;
+#if GATEWAY_ENABLE
+CAN_HandleTypeDef  hcan2;
+#endif
 
 /* --- Global vars --- */
 uint8_t led_no = 0;
+uint32_t led_cmd_dropped = 0;	// LED commands without a free TX mailbox (PUBLISH_ENABLE 0)
+uint32_t reply_dropped = 0;		// sensor replies without a free TX mailbox
+uint8_t  slot_pending = FALSE;	// broadcast request received, reply in our slot
+uint32_t slot_due_tick = 0;
+uint32_t reply_seq = 0;			// sensor sample in the auto-reply mailbox
 
 /* --- Function prototypes --- */
 void SystemClock_Config(void);
@@ -32,11 +63,16 @@ void GPIO_Init(void);
 void UART2_Init(void);
 void TIMER6_Init(void);
 void CAN1_Init(void);
+void CAN2_Init(void);
 void CAN1_Tx(void);
 void CAN_Filter_Config(void);
 
 void LED_Manage_Output(uint8_t led_number);
 void Send_Response(uint32_t StdId);
+uint32_t Fill_Response(CAN_Frame_t *frame, uint32_t StdId);
+HAL_StatusTypeDef Preload_Response(uint32_t StdId);
+void Slot_Reply_Process(void);
+void Sensor_Reply_Process(void);
 
 
 /**
@@ -46,30 +82,87 @@ void Send_Response(uint32_t StdId);
 int main()
 {
 	HAL_Init();
+	Cycles_Init();
 	SystemClock_Config();
+	Node_Id_Init();
 	GPIO_Init();
 	UART2_Init();
 	TIMER6_Init();
 	CAN1_Init();
 	CAN_Filter_Config();
+	CAN_IF_Init();
+	Publish_Init();
+	Sensor_Init();				// ADC + DMA sampling for the sensor reply
+#if AGGREGATE_ENABLE
+	if(node_id <= CAN_SENSOR_SUMMARY_NODES)
+	{
+		Aggregate_Init();		// first windows start now; higher node IDs have no summary ID
+	}
+#endif
+#if GATEWAY_ENABLE
+	CAN2_Init();
+	Gateway_Init();				// CAN2 filters and start, routed CAN1 IDs
+#endif
+
+#if CAN_IF_RTR_AUTOREPLY
+	/* Remote requests go to FIFO1; CAN1_RX1 answers from the reserved mailbox */
+	CAN_IF_RTR_Config_Filter(&hcan1, CAN_ID_SENSOR_DATA_NODE(node_id));
+	if(HAL_CAN_ActivateNotification(&hcan1, CAN_IT_RX_FIFO1_MSG_PENDING) != HAL_OK)
+	{
+		Error_Handler();
+	}
+#endif
 
-	/* Enable CAN interrupts */
+	/* Enable CAN interrupts (TX complete, RX pending, error/status for diagnostics) */
 	if(HAL_CAN_ActivateNotification(&hcan1,
 			CAN_IT_TX_MAILBOX_EMPTY |
 			CAN_IT_RX_FIFO0_MSG_PENDING |
-			CAN_IT_BUSOFF) != HAL_OK)
+			CAN_IT_BUSOFF |
+			CAN_IT_ERROR_WARNING |
+			CAN_IT_ERROR_PASSIVE |
+			CAN_IT_LAST_ERROR_CODE |
+			CAN_IT_ERROR |
+			CAN_IT_RX_FIFO0_OVERRUN) != HAL_OK)
 	{
 		Error_Handler();
 	}
 
+#if CAN_IF_RTR_AUTOREPLY
+	if(Preload_Response(CAN_ID_SENSOR_DATA_NODE(node_id)) != HAL_OK)	// before Start: no request may find it empty
+	{
+		Error_Handler();	// mailbox cannot be pending before the first request
+	}
+#endif
+
 	/* Start CAN peripheral */
 	if(HAL_CAN_Start(&hcan1) != HAL_OK)
 	{
 		Error_Handler();
 	}
+	Power_Init(&hcan1);			// wake sources for POWER_LEVEL
 
-	/* Main loop (all work handled in ISRs & callbacks) */
-	while(1);
+	/* Main loop (ISRs only queue frames, handling happens here) */
+	while(1)
+	{
+		CAN_IF_Poll(&hcan1);		// dispatch received frames
+#if PUBLISH_ENABLE
+		Publish_Process();			// send-on-change signals: changes, refreshes
+#endif
+		Slot_Reply_Process();		// answer a broadcast request in our slot
+#if CAN_IF_RTR_AUTOREPLY
+		Sensor_Reply_Process();		// reload the reply mailbox with a new sample
+#endif
+#if AGGREGATE_ENABLE
+		Aggregate_Process();		// send the summaries of closed windows
+#endif
+#if GATEWAY_ENABLE
+		Gateway_Process();			// send queued gateway frames
+#endif
+		CAN_Diag_Process(&hcan1);	// publish error counters on the diagnostics ID
+		Console_Poll();				// execute host commands received on UART2
+		Log_Process();				// format deferred log records
+		Power_Idle();				// sleep until the next interrupt if nothing is queued
+	}
 
 	return 0;
 }
@@ -146,13 +239,14 @@ void GPIO_Init(void)
 }
 
 /**
-  * @brief UART2 Init (115200-8-N-1)
+  * @brief Configure UART2 (UART_LINK_BAUD, 8N1) with TX and RX DMA
+  * Carries the framed debug link (uart_link.h)
   * @retval None
   */
 void UART2_Init(void)
 {
 	huart2.Instance = USART2;
-	huart2.Init.BaudRate = 115200;
+	huart2.Init.BaudRate = UART_LINK_BAUD;
 	huart2.Init.WordLength = UART_WORDLENGTH_8B;
 	huart2.Init.StopBits = UART_STOPBITS_1;
 	huart2.Init.Parity = UART_PARITY_NONE;
@@ -162,6 +256,7 @@ void UART2_Init(void)
 //		There is a problem
 		Error_Handler();
 	}
+	UART_Link_Init(&huart2);		// also starts the command receiver
 }
 
 /**
@@ -187,8 +282,12 @@ void CAN1_Init(void)
 	hcan1.Instance = CAN1;
 	hcan1.Init.Mode = CAN_MODE_NORMAL;
 	hcan1.Init.AutoBusOff = ENABLE;
+#if CAN_IF_TX_ONESHOT
+	hcan1.Init.AutoRetransmission = DISABLE;	// NART: a lost attempt ends the request (can_if.h)
+#else
 	hcan1.Init.AutoRetransmission = ENABLE;
-	hcan1.Init.AutoWakeUp = DISABLE;
+#endif
+	hcan1.Init.AutoWakeUp = ENABLE;		// bus activity ends bxCAN sleep (power.c)
 	hcan1.Init.ReceiveFifoLocked = DISABLE;
 	hcan1.Init.TimeTriggeredMode = DISABLE;
 	hcan1.Init.TransmitFifoPriority = DISABLE;
@@ -205,27 +304,42 @@ void CAN1_Init(void)
 
 }
 
+#if GATEWAY_ENABLE
 /**
-  * @brief CAN Filter Init (accept all IDs)
+  * @brief CAN2 Init (Normal mode, ~500 kbps, gateway segment)
+  * TX FIFO priority: forwarded frames leave in the order they were received.
   */
-void CAN_Filter_Config(void)
+void CAN2_Init(void)
 {
-	CAN_FilterTypeDef can1_filter_init;
-	can1_filter_init.FilterActivation = CAN_FILTER_ENABLE;
-	can1_filter_init.FilterBank = 0;
-	can1_filter_init.FilterFIFOAssignment = CAN_FILTER_FIFO0;
-	can1_filter_init.FilterIdHigh = 0x0000;
-	can1_filter_init.FilterIdLow = 0x0000;
-	can1_filter_init.FilterMaskIdHigh = 0x0000;
-	can1_filter_init.FilterMaskIdLow = 0x0000;
-	can1_filter_init.FilterMode = CAN_FILTERMODE_IDMASK;
-	can1_filter_init.FilterScale = CAN_FILTERSCALE_32BIT;
-
-	if(HAL_CAN_ConfigFilter(&hcan1, &can1_filter_init) != HAL_OK)
+	hcan2.Instance = CAN2;
+	hcan2.Init.Mode = CAN_MODE_NORMAL;
+	hcan2.Init.AutoBusOff = ENABLE;
+	hcan2.Init.AutoRetransmission = ENABLE;
+	hcan2.Init.AutoWakeUp = DISABLE;
+	hcan2.Init.ReceiveFifoLocked = DISABLE;
+	hcan2.Init.TimeTriggeredMode = DISABLE;
+	hcan2.Init.TransmitFifoPriority = ENABLE;
+
+	hcan2.Init.Prescaler = 6;
+	hcan2.Init.SyncJumpWidth = CAN_SJW_1TQ;
+	hcan2.Init.TimeSeg1 = CAN_BS1_11TQ;
+	hcan2.Init.TimeSeg2 = CAN_BS2_2TQ;
+	if(HAL_CAN_Init(&hcan2) != HAL_OK)
 	{
 		Error_Handler();
 	}
+}
+#endif
+
+/**
+  * @brief CAN Filter Init
+  * Exact-match list of the IDs node2 receives (CAN_NODE2_RX_FILTERS)
+  */
+void CAN_Filter_Config(void)
+{
+	const uint16_t rx_filters[CAN_NODE2_RX_COUNT] = CAN_NODE2_RX_FILTERS(node_id);
 
+	CAN_IF_Config_List_Filters(&hcan1, rx_filters, CAN_NODE2_RX_COUNT);
 }
 
 /* ---------------- CAN FUNCTIONS ---------------- */
@@ -233,21 +347,15 @@ void CAN_Filter_Config(void)
 /**
   * @brief CAN TX: send 1-byte LED command (demo/debug)
   * for node2 this is not being called
+  * With PUBLISH_ENABLE the value only goes to the publisher (publish.h).
   * @retval None
   */
 void CAN1_Tx(void)
 {
-	CAN_TxHeaderTypeDef TxHeader;
-	uint32_t TxMailbox;
-
-	uint8_t message;
-
-	TxHeader.DLC = 1;
-	TxHeader.StdId = 0x65D;
-	TxHeader.IDE = CAN_ID_STD;
-	TxHeader.RTR = CAN_RTR_DATA;
-
-	message = ++led_no;
+	uint8_t next = ++led_no;
+#if !PUBLISH_ENABLE
+	CAN_Frame_t *frame;
+#endif
 
 	if(led_no == 4)
 	{
@@ -256,9 +364,43 @@ void CAN1_Tx(void)
 
 	HAL_GPIO_TogglePin(GPIOD,GPIO_PIN_13);
 
-	if(HAL_CAN_AddTxMessage(&hcan1, &TxHeader, &message, &TxMailbox) != HAL_OK)
+#if PUBLISH_ENABLE
+	Publish_Set(PUBLISH_SIGNAL_LED_CMD, next);	// the main loop decides whether it goes on the bus
+#else
+	frame = Frame_Pool_Alloc();
+	if(frame == NULL)
 	{
-		Error_Handler();
+		return;
+	}
+
+	(void)Publish_Fill_Callback(PUBLISH_SIGNAL_LED_CMD, next, frame);
+
+	if(CAN_IF_Send(&hcan1, frame) != HAL_OK)
+	{
+		led_cmd_dropped++;	// mailboxes busy (or only the reserved one free): the next tick sends the next one
+	}
+
+	Frame_Pool_Release(frame);
+#endif
+}
+
+/**
+  * @brief Build the frame of a published signal (publish.h)
+  * @retval FALSE for an unknown signal
+  */
+uint8_t Publish_Fill_Callback(uint32_t signal, int32_t value, CAN_Frame_t *frame)
+{
+	CAN_LED_CMD_t cmd;
+
+	switch(signal)
+	{
+	case PUBLISH_SIGNAL_LED_CMD:
+		CAN_IF_Frame_Std(frame, CAN_ID_LED_CMD, CAN_RTR_DATA, CAN_DLC_LED_CMD);
+		cmd.led_no = (uint8_t)value;
+		CAN_LED_CMD_Pack(frame->data, &cmd);
+		return TRUE;
+	default:
+		return FALSE;
 	}
 }
 
@@ -302,99 +444,262 @@ void LED_Manage_Output(uint8_t led_number)
 }
 
 /**
-  * @brief Respond to Remote Frame (0x651) with Data Frame (0xAB,0xCD)
+  * @brief Respond to Remote Frame (CAN_ID_SENSOR_DATA) with the latest sensor value
+  * The value comes from the seqlock snapshot (Sensor_Read) through
+  * Fill_Response(); with SENSOR_ENABLE 0 it is the fixed 0xABCD.
   * @retval None
   */
 void Send_Response(uint32_t StdId)
 {
-	CAN_TxHeaderTypeDef TxHeader;
-	uint32_t TxMailbox;
+	CAN_Frame_t *frame = Frame_Pool_Alloc();
 
-	uint8_t response[2] = {0xAB, 0xCD};
+	if(frame == NULL)
+	{
+		return;	// pool exhausted, counted in frame_pool_stats
+	}
 
-	TxHeader.DLC = 2;
-	TxHeader.StdId = StdId;
-	TxHeader.IDE = CAN_ID_STD;
-	TxHeader.RTR = CAN_RTR_DATA;
+	Fill_Response(frame, StdId);
 
-	if(HAL_CAN_AddTxMessage(&hcan1, &TxHeader, response, &TxMailbox) != HAL_OK)
+	if(CAN_IF_Send(&hcan1, frame) != HAL_OK)
 	{
-		Error_Handler();
+		reply_dropped++;	// TX side full: the master polls again next cycle
+	}
+
+	Frame_Pool_Release(frame);
+}
+
+/**
+  * @brief Publish a window summary on CAN_ID_SENSOR_SUMMARY_NODE(node_id)
+  * Same path as Send_Response(), but a full TX side is not an error: the
+  * aggregator keeps the summary and calls again on the next pass.
+  * @retval TRUE if queued, FALSE if no frame or TX mailbox was free
+  */
+uint8_t Aggregate_Publish_Callback(const Aggregate_Summary_t *summary)
+{
+	CAN_Frame_t *frame = Frame_Pool_Alloc();
+	HAL_StatusTypeDef status;
+
+	if(frame == NULL)
+	{
+		return FALSE;
+	}
+
+	CAN_IF_Frame_Std(frame, CAN_ID_SENSOR_SUMMARY_NODE(node_id), CAN_RTR_DATA, CAN_DLC_SENSOR_SUMMARY);
+	Aggregate_Pack(frame->data, summary);
+
+	status = CAN_IF_Send(&hcan1, frame);
+	Frame_Pool_Release(frame);
+
+	return (status == HAL_OK) ? TRUE : FALSE;
+}
+
+/**
+  * @brief Send the broadcast reply once our slot has started (main loop)
+  *
+  * Slots spread the NODE_ID_MAX replies over time instead of queueing them
+  * back to back behind one request, which keeps the master's 3-deep RX FIFO
+  * and the bus load of a broadcast bounded.
+  */
+void Slot_Reply_Process(void)
+{
+	if(slot_pending && (int32_t)(HAL_GetTick() - slot_due_tick) >= 0)
+	{
+		slot_pending = FALSE;
+		Send_Response(CAN_ID_SENSOR_DATA_NODE(node_id));
 	}
+}
 
+/**
+  * @brief Build the reply to a CAN_ID_SENSOR_DATA remote request
+  * Reads the sensor snapshot, a constant-time copy without locking.
+  * @retval sequence number of the sample in the reply
+  */
+uint32_t Fill_Response(CAN_Frame_t *frame, uint32_t StdId)
+{
+	CAN_SENSOR_DATA_t reply;
+	uint32_t seq = 0;
+#if SENSOR_ENABLE
+	Sensor_Sample_t sample;
+
+	seq = Sensor_Read(&sample);
+	reply.value = sample.value;
+#else
+	reply.value = 0xABCD;
+#endif
+
+	CAN_IF_Frame_Std(frame, StdId, CAN_RTR_DATA, CAN_DLC_SENSOR_DATA);
+	CAN_SENSOR_DATA_Pack(frame->data, &reply);
+	return seq;
+}
+
+/**
+  * @brief Load the reply into the reserved TX mailbox (auto-reply mode)
+  * Call again whenever the reply payload changes.
+  * @retval HAL_OK, HAL_BUSY if the reply is in flight or no frame is free
+  */
+HAL_StatusTypeDef Preload_Response(uint32_t StdId)
+{
+	CAN_Frame_t *frame = Frame_Pool_Alloc();
+	HAL_StatusTypeDef status;
+	uint32_t seq;
+
+	if(frame == NULL)
+	{
+		return HAL_BUSY;
+	}
+
+	seq = Fill_Response(frame, StdId);
+	status = CAN_IF_RTR_Preload(&hcan1, frame);
+	if(status == HAL_OK)
+	{
+		reply_seq = seq;
+	}
+
+	Frame_Pool_Release(frame);
+	return status;
+}
+
+/**
+  * @brief Reload the auto-reply mailbox once a new sample is published (main loop)
+  * A busy mailbox (reply in flight) is retried on the next pass.
+  */
+void Sensor_Reply_Process(void)
+{
+#if SENSOR_ENABLE
+	if(Sensor_Seq() != reply_seq)
+	{
+		(void)Preload_Response(CAN_ID_SENSOR_DATA_NODE(node_id));
+	}
+#endif
 }
 
 /* ---------------- CALLBACKS ---------------- */
 
 /**
-  * @brief UART debug print on TX complete via Mailbox0
+  * @brief Mailbox0 sent its frame (completion event, can_if.c)
   */
 void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "Message Transmitted from Mailbox0\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+	CAN_IF_Tx_Isr(hcan, 0, CAN_IF_TX_SENT);
 }
 
 /**
-  * @brief UART debug print on TX complete via Mailbox1
+  * @brief Mailbox1 sent its frame (completion event, can_if.c)
   */
 void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "Message Transmitted from Mailbox1\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+	CAN_IF_Tx_Isr(hcan, 1, CAN_IF_TX_SENT);
 }
 
 /**
-  * @brief UART debug print on TX complete via Mailbox2
+  * @brief Mailbox2 sent its frame (completion event, can_if.c)
   */
 void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "Message Transmitted from Mailbox2\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+	CAN_IF_Tx_Isr(hcan, 2, CAN_IF_TX_SENT);
 }
 
 /**
-  * @brief Callback when a CAN frame is received in FIFO0
-  *
-  * - If Data Frame with ID 0x65D → extract LED command and update LEDs.
-  * - If Remote Frame with ID 0x651 → send a 2-byte response back.
-  * - If Data Frame with ID 0x651 → treat as reply (for debugging).
-  * - Debug messages are printed via UART2.
+  * @brief Mailbox0 aborted at its deadline (completion event, can_if.c)
+  */
+void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_Tx_Isr(hcan, 0, CAN_IF_TX_ABORTED);
+}
+
+/**
+  * @brief Mailbox1 aborted at its deadline (completion event, can_if.c)
   */
-void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef *hcan)
 {
-	CAN_RxHeaderTypeDef RxHeader;
-	uint8_t rcvd_message[8];
-	char msg[50];
+	CAN_IF_Tx_Isr(hcan, 1, CAN_IF_TX_ABORTED);
+}
 
-	if(HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &RxHeader, rcvd_message) != HAL_OK)
+/**
+  * @brief Mailbox2 aborted at its deadline (completion event, can_if.c)
+  */
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_Tx_Isr(hcan, 2, CAN_IF_TX_ABORTED);
+}
+
+/**
+  * @brief UART2 TX DMA transfer finished → start the next one
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	UART_Link_TxCplt(huart);
+}
+
+/**
+  * @brief UART2 RX idle line / DMA wrap → hand the new bytes to the link
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	UART_Link_RxEvent(huart, Size);
+}
+
+/**
+  * @brief UART2 error → restart the command receiver
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	UART_Link_RxError(huart);
+}
+
+/**
+  * @brief Callback when a CAN frame is received in FIFO0
+  * Only moves the frame into the RX ring; decoding runs in the main loop.
+  */
+__CAN_ISR void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
+{
+#if GATEWAY_ENABLE
+	if(Gateway_RxIsr(hcan->Instance, Cycles_Now()))
 	{
-		Error_Handler();
+		return;	// forwarded to CAN2, not for this node
 	}
+#endif
+	CAN_IF_RxIsr(hcan, CAN_RX_FIFO0);
+}
 
-	if(RxHeader.StdId == 0x65D && RxHeader.RTR == CAN_RTR_DATA)
+/**
+  * @brief FIFO0 full, only armed while CAN_IF_Poll() polls FIFO0 (ISR context)
+  */
+__CAN_ISR void HAL_CAN_RxFifo0FullCallback(CAN_HandleTypeDef *hcan)
+{
+	CAN_IF_Rx_Full_Isr(hcan);
+}
+
+/**
+  * @brief Handle a received CAN frame (main loop context)
+  *
+  * - If Data Frame with ID CAN_ID_LED_CMD → extract LED command and update LEDs.
+  * - If Remote Frame with ID CAN_ID_SENSOR_DATA → send a 2-byte response back.
+  * - Debug messages go through the deferred log (log.h).
+  */
+void CAN_IF_RxCallback(CAN_Frame_t *frame)
+{
+	CAN_LED_CMD_t cmd;
+
+	if(frame->header.StdId == CAN_ID_LED_CMD && frame->header.RTR == CAN_RTR_DATA)
 	{
 //		This is DATA frame sent by node1 to node2
-		LED_Manage_Output(rcvd_message[0]);
-		sprintf(msg, "Message Received: #%X\r\n", rcvd_message[0]);
+		CAN_LED_CMD_Unpack(&cmd, frame->data);
+		LED_Manage_Output(cmd.led_no);
+		LOG_INFO(LOG_MOD_APP, "Message Received: #%lX", cmd.led_no, 0);
 	}
-	else if(RxHeader.StdId == 0x651 && RxHeader.RTR == CAN_RTR_REMOTE)
+	else if(frame->header.StdId == CAN_ID_SENSOR_DATA_NODE(node_id) && frame->header.RTR == CAN_RTR_REMOTE)
 	{
-//		This is REMOTE frame sent by node1 to node2
-		Send_Response(RxHeader.StdId);
-		return;
+//		This is REMOTE frame sent by node1 to this node (auto-reply disabled)
+		Send_Response(frame->header.StdId);
+		Cycle_Stats_Add(&can_rtr_reply_cycles, frame->stamp);
 	}
-	else if(RxHeader.StdId == 0x651 && RxHeader.RTR == CAN_RTR_DATA)
+	else if(frame->header.StdId == CAN_ID_SENSOR_DATA && frame->header.RTR == CAN_RTR_REMOTE)
 	{
-//		This is a REPLY (data frame) by node2 to node1
-		sprintf(msg, "Reply Received: #%X\r\n", rcvd_message[0] << 8 | rcvd_message[1]);
+//		Broadcast request: every slave answers, node_id slots later
+		slot_due_tick = HAL_GetTick() + node_id * NODE_REPLY_SLOT_MS;
+		slot_pending = TRUE;
 	}
-
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
-
 }
 
 /**
@@ -405,11 +710,27 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 	CAN1_Tx();
 }
 
-void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
+/**
+  * @brief CAN error callback
+  *
+  * With CAN_ISR_LEAN 1 the per-vector handlers in it.c have decoded their
+  * own flags (TSR on TX, RFxR on RX0/RX1, ESR on SCE) into hcan->ErrorCode;
+  * with CAN_ISR_LEAN 0 HAL_CAN_IRQHandler does the same for all of them.
+  * Only the counters are updated here; they are published from the main loop.
+  */
+__CAN_ISR void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
 {
-	char msg[50];
-	sprintf(msg, "CAN Error Detected\r\n");
-	HAL_UART_Transmit(&huart2, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
+#if GATEWAY_ENABLE
+	if(hcan->Instance == CAN2)
+	{
+		gateway_can2_errors++;	// the diagnostics pages describe CAN1 only
+		HAL_CAN_ResetError(hcan);
+		return;
+	}
+#endif
+	CAN_Diag_Record(HAL_CAN_GetError(hcan));
+	CAN_IF_Tx_Error_Isr(hcan, HAL_CAN_GetError(hcan));	// mailboxes that ended unsent
+	HAL_CAN_ResetError(hcan);
 }
 
 /**
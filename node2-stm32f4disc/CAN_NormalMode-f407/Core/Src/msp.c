@@ -11,6 +11,11 @@
  */
 
 #include "main.h"
+#include "can_if.h"
+#include "gateway.h"
+
+extern DMA_HandleTypeDef hdma_usart2_tx;
+extern DMA_HandleTypeDef hdma_usart2_rx;
 
 /**
   * @brief processor specific initialization
@@ -45,21 +50,83 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
 	gpio_uart.Pin = GPIO_PIN_2 | GPIO_PIN_3;
 	gpio_uart.Mode = GPIO_MODE_AF_PP;
 	gpio_uart.Pull = GPIO_PULLUP;
-	gpio_uart.Speed = GPIO_SPEED_FREQ_LOW;
+	gpio_uart.Speed = GPIO_SPEED_FREQ_HIGH;	// multi-Mbaud edges
 	gpio_uart.Alternate = GPIO_AF7_USART2;	// UART2_Tx, UART2_Rx
 	HAL_GPIO_Init(GPIOA, &gpio_uart);
-//	3. enable the IRQ and set up the priority (NVIC settings)
+//	3. TX DMA: memory -> USART2_TDR, byte wide, one transfer per ring chunk
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	hdma_usart2_tx.Instance = DMA1_Stream6;
+	hdma_usart2_tx.Init.Channel = DMA_CHANNEL_4;
+	hdma_usart2_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+	hdma_usart2_tx.Init.Priority = DMA_PRIORITY_LOW;
+	if(HAL_DMA_Init(&hdma_usart2_tx) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	__HAL_LINKDMA(huart, hdmatx, hdma_usart2_tx);
+//	4. RX DMA: USART2_RDR -> circular buffer, drained on idle line (command console)
+	hdma_usart2_rx.Instance = DMA1_Stream5;
+	hdma_usart2_rx.Init.Channel = DMA_CHANNEL_4;
+	hdma_usart2_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdma_usart2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
+	hdma_usart2_rx.Init.Priority = DMA_PRIORITY_LOW;
+	if(HAL_DMA_Init(&hdma_usart2_rx) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	__HAL_LINKDMA(huart, hdmarx, hdma_usart2_rx);
+//	5. enable the IRQs and set up the priority (NVIC settings)
+	HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 15, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+	HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 15, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
 	HAL_NVIC_EnableIRQ(USART2_IRQn);
 	HAL_NVIC_SetPriority(USART2_IRQn, 15, 0);
 }
 
 /**
-  * @brief peripheral specific initialization: CAN1
+  * @brief peripheral specific initialization: CAN1, CAN2 (gateway)
   */
 void HAL_CAN_MspInit(CAN_HandleTypeDef *hcan)
 {
 	GPIO_InitTypeDef gpio_can;
 
+#if GATEWAY_ENABLE
+	if(hcan->Instance == CAN2)
+	{
+		__HAL_RCC_CAN1_CLK_ENABLE();	// CAN2 reaches the filter banks through CAN1
+		__HAL_RCC_CAN2_CLK_ENABLE();
+		__HAL_RCC_GPIOB_CLK_ENABLE();
+
+//		CAN2 GPIO Configuration
+//		PB12	---> CAN2_RX
+//		PB13	---> CAN2_TX
+		gpio_can.Pin = GPIO_PIN_12 | GPIO_PIN_13;
+		gpio_can.Mode = GPIO_MODE_AF_PP;
+		gpio_can.Pull = GPIO_NOPULL;
+		gpio_can.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+		gpio_can.Alternate = GPIO_AF9_CAN2;
+		HAL_GPIO_Init(GPIOB, &gpio_can);
+
+		HAL_NVIC_SetPriority(CAN2_RX0_IRQn, 15, 0);
+		HAL_NVIC_SetPriority(CAN2_SCE_IRQn, 15, 0);
+		HAL_NVIC_EnableIRQ(CAN2_RX0_IRQn);
+		HAL_NVIC_EnableIRQ(CAN2_SCE_IRQn);
+		return;
+	}
+#endif
+
 	__HAL_RCC_CAN1_CLK_ENABLE();
 	__HAL_RCC_GPIOB_CLK_ENABLE();
 
@@ -76,7 +143,11 @@ void HAL_CAN_MspInit(CAN_HandleTypeDef *hcan)
 
 	HAL_NVIC_SetPriority(CAN1_TX_IRQn, 15, 0);
 	HAL_NVIC_SetPriority(CAN1_RX0_IRQn, 15, 0);
+#if CAN_IF_RTR_AUTOREPLY
+	HAL_NVIC_SetPriority(CAN1_RX1_IRQn, 1, 0);	// RTR auto-reply preempts every other handler
+#else
 	HAL_NVIC_SetPriority(CAN1_RX1_IRQn, 15, 0);
+#endif
 	HAL_NVIC_SetPriority(CAN1_SCE_IRQn, 15, 0);
 
 	HAL_NVIC_EnableIRQ(CAN1_TX_IRQn);
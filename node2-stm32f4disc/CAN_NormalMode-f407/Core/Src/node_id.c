@@ -0,0 +1,69 @@
+/*
+ * node_id.c
+ *
+ * Node identity
+ * - Node_Id_Init(): called once before the CAN filters are configured
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "node_id.h"
+
+uint8_t node_id = NODE_ID_DEFAULT;
+
+/* Kept in the image so a production script can patch it per node */
+__attribute__((used)) const volatile uint8_t node_id_config = NODE_ID_DEFAULT;
+
+#if NODE_ID_SOURCE == NODE_ID_SOURCE_STRAP
+/**
+  * @brief Read the strap inputs (jumper to GND = 1)
+  * @retval strap value, 0 if no jumper is fitted
+  */
+static uint32_t Node_Id_Read_Strap(void)
+{
+	GPIO_InitTypeDef gpio = {0};
+	uint32_t value;
+
+	NODE_ID_STRAP_CLK_ENABLE();
+	gpio.Pin = ((1UL << NODE_ID_STRAP_BITS) - 1U) << NODE_ID_STRAP_PIN0;
+	gpio.Mode = GPIO_MODE_INPUT;
+	gpio.Pull = GPIO_PULLUP;
+	HAL_GPIO_Init(NODE_ID_STRAP_PORT, &gpio);
+
+	HAL_Delay(1);	// let the internal pull-ups charge the header
+
+	value = (~NODE_ID_STRAP_PORT->IDR >> NODE_ID_STRAP_PIN0) & ((1UL << NODE_ID_STRAP_BITS) - 1U);
+
+	HAL_GPIO_DeInit(NODE_ID_STRAP_PORT, gpio.Pin);
+	return value;
+}
+#endif
+
+/**
+  * @brief Select the node ID from NODE_ID_SOURCE
+  *
+  * A value outside 1..NODE_ID_MAX (unprogrammed OTP, no jumper) on a slave
+  * image falls back to node_id_config, so a board never joins the bus
+  * with the master's ID by accident.
+  * @retval None
+  */
+void Node_Id_Init(void)
+{
+	uint32_t value;
+
+#if NODE_ID_SOURCE == NODE_ID_SOURCE_STRAP
+	value = Node_Id_Read_Strap();
+#elif NODE_ID_SOURCE == NODE_ID_SOURCE_OTP
+	value = *(const volatile uint8_t *)NODE_ID_OTP_ADDR;
+#else
+	value = node_id_config;
+#endif
+
+	if(NODE_ID_DEFAULT != NODE_ID_MASTER && (value == NODE_ID_MASTER || value > NODE_ID_MAX))
+	{
+		value = node_id_config;
+	}
+
+	node_id = (uint8_t)value;
+}
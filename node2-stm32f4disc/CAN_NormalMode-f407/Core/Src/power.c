@@ -0,0 +1,364 @@
+/*
+ * power.c
+ *
+ * Low-power listen mode (see power.h)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "power.h"
+#include "can_if.h"
+#include "log.h"
+#include "uart_link.h"
+#include "trace.h"
+#include "gateway.h"
+
+#if (POWER_LEVEL == POWER_LEVEL_STOP) && GATEWAY_ENABLE
+#error "POWER_LEVEL_STOP does not wake on CAN2, disable the gateway or use POWER_LEVEL_SLEEP"
+#endif
+
+#define POWER_RTC_PREDIV_A        1U       // ck_apre = LSI / 2, ~61 us per subsecond step
+#define POWER_RTC_PREDIV_S        0x3FFFU  // ck_spre ~1 Hz
+#define POWER_RTC_DAY             (86400U * (POWER_RTC_PREDIV_S + 1U))
+
+volatile Power_Stats_t power_stats;
+
+static CAN_HandleTypeDef *power_can = NULL;
+static uint32_t wake_stamp;              // DWT cycles at the last CAN wakeup
+static uint8_t  wake_pending = FALSE;    // no frame handled since that wakeup
+static uint32_t last_rx_tick;
+static uint32_t report_tick;
+static uint32_t report_us;
+static uint64_t report_asleep_us;
+
+#if POWER_LEVEL != POWER_LEVEL_RUN
+/**
+  * @brief Record a wakeup caused by CAN traffic (IRQs disabled, before the ISR runs)
+  * @retval None
+  */
+static void Power_Can_Woke(void)
+{
+	wake_stamp = Cycles_Now();
+	wake_pending = TRUE;
+	power_stats.can_wakes++;
+}
+#endif
+
+#if POWER_LEVEL == POWER_LEVEL_STOP
+static uint32_t stop_rem_us;             // Stop time not yet added to uwTick
+
+/**
+  * @brief Run the RTC from LSI as a free-running counter
+  * Only SSR and TR are used; calendar and alarms stay unconfigured.
+  * @retval None
+  */
+static void Power_Rtc_Init(void)
+{
+	__HAL_RCC_PWR_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+
+	__HAL_RCC_LSI_ENABLE();
+	while(__HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY) == 0U)
+	{
+	}
+
+	if((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_RTCCLKSOURCE_LSI)
+	{
+		/* RTCSEL is write-once until the next backup domain reset */
+		__HAL_RCC_BACKUPRESET_FORCE();
+		__HAL_RCC_BACKUPRESET_RELEASE();
+		__HAL_RCC_RTC_CONFIG(RCC_RTCCLKSOURCE_LSI);
+	}
+	__HAL_RCC_RTC_ENABLE();
+
+	RTC->WPR = 0xCAU;
+	RTC->WPR = 0x53U;
+	SET_BIT(RTC->ISR, RTC_ISR_INIT);
+	while(READ_BIT(RTC->ISR, RTC_ISR_INITF) == 0U)
+	{
+	}
+	RTC->PRER = POWER_RTC_PREDIV_S;		// two separate writes, PREDIV_S first
+	RTC->PRER |= POWER_RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos;
+	RTC->TR = 0U;
+	SET_BIT(RTC->CR, RTC_CR_BYPSHAD);	// read the counters directly, no RSF wait after Stop
+	CLEAR_BIT(RTC->ISR, RTC_ISR_INIT);
+	RTC->WPR = 0xFFU;
+}
+
+/**
+  * @brief Subsecond steps since midnight (RTC time, wraps at POWER_RTC_DAY)
+  * @retval steps of 1 / power_stats.rtc_hz s
+  */
+static uint32_t Power_Rtc_Now(void)
+{
+	uint32_t ssr;
+	uint32_t tr;
+	uint32_t secs;
+
+	/* Shadow registers are bypassed: re-read until SSR and TR agree */
+	do
+	{
+		ssr = RTC->SSR;
+		tr = RTC->TR;
+	} while(ssr != RTC->SSR || tr != RTC->TR);
+
+	/* TR is BCD: HT HU : MNT MNU : ST SU */
+	secs = ((((tr >> 20) & 0x3U) * 10U) + ((tr >> 16) & 0xFU)) * 3600U
+	     + ((((tr >> 12) & 0x7U) * 10U) + ((tr >> 8) & 0xFU)) * 60U
+	     + (((tr >> 4) & 0x7U) * 10U) + (tr & 0xFU);
+
+	return (secs * (POWER_RTC_PREDIV_S + 1U)) + (POWER_RTC_PREDIV_S - ssr);
+}
+
+static uint32_t Power_Rtc_Elapsed(uint32_t from)
+{
+	uint32_t now = Power_Rtc_Now();
+
+	return (now >= from) ? (now - from) : (now + POWER_RTC_DAY - from);
+}
+
+/**
+  * @brief Measure the RTC step rate against SysTick (LSI is only +-50% accurate)
+  * @retval None
+  */
+static void Power_Rtc_Calibrate(void)
+{
+	uint32_t tick = HAL_GetTick();
+	uint32_t start;
+
+	while(HAL_GetTick() == tick)
+	{
+	}
+	tick = HAL_GetTick();
+	start = Power_Rtc_Now();
+	while((HAL_GetTick() - tick) < POWER_LSI_CAL_MS)
+	{
+	}
+	power_stats.rtc_hz = (Power_Rtc_Elapsed(start) * 1000U) / POWER_LSI_CAL_MS;
+}
+
+/**
+  * @brief Bring HSE, PLL and SYSCLK back after Stop
+  * The PLL configuration, bus prescalers and flash latency survive Stop, only
+  * the oscillators are off and SYSCLK runs from HSI. Much faster than
+  * SystemClock_Config(): no HAL_GetTick() timeouts, no reconfiguration.
+  * @retval None
+  */
+static void Power_Clock_Restore(void)
+{
+	__HAL_RCC_HSE_CONFIG(POWER_HSE_STATE);
+	while(__HAL_RCC_GET_FLAG(RCC_FLAG_HSERDY) == 0U)
+	{
+	}
+	__HAL_RCC_PLL_ENABLE();
+	while(__HAL_RCC_GET_FLAG(RCC_FLAG_PLLRDY) == 0U)
+	{
+	}
+	__HAL_RCC_SYSCLK_CONFIG(RCC_SYSCLKSOURCE_PLLCLK);
+	while(__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_PLLCLK)
+	{
+	}
+}
+
+/**
+  * @brief Stop needs everything Stop would freeze to be idle
+  * Called with IRQs disabled.
+  * @retval TRUE if the node may enter Stop
+  */
+static uint8_t Power_Stop_Allowed(void)
+{
+	const uint32_t tme = CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2;
+
+	return ((HAL_GetTick() - last_rx_tick) >= POWER_STOP_IDLE_MS)
+	    && ((power_can->Instance->TSR & tme) == tme)
+	    && (UART_Link_Tx_Busy() == FALSE)
+	    && (READ_BIT(TIM6->CR1, TIM_CR1_CEN) == 0U);
+}
+
+/**
+  * @brief bxCAN sleep, Stop mode until a CAN RX edge (or any enabled IRQ)
+  * @retval None
+  */
+static void Power_Stop(void)
+{
+	uint32_t primask;
+	uint32_t start;
+	uint32_t stop_us;
+
+	if(HAL_CAN_RequestSleep(power_can) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	start = HAL_GetTick();
+	while(HAL_CAN_IsSleepActive(power_can) == 0U)
+	{
+		if((HAL_GetTick() - start) > POWER_SLEEP_ACK_MS)
+		{
+			power_stats.stop_aborted++;
+			break;
+		}
+	}
+
+	/* The SOF of the next frame is a falling edge on CAN RX */
+	SET_BIT(POWER_EXTI_FTSR, POWER_WAKE_PIN);
+	__HAL_GPIO_EXTI_CLEAR_IT(POWER_WAKE_PIN);
+	SET_BIT(POWER_EXTI_IMR, POWER_WAKE_PIN);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(HAL_CAN_IsSleepActive(power_can) != 0U && CAN_IF_Rx_Pending() == FALSE && Log_Pending() == FALSE)
+	{
+		start = Power_Rtc_Now();
+		HAL_SuspendTick();
+		HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+		Power_Clock_Restore();
+
+		/* Keep HAL timeouts and log stamps on wall time */
+		stop_us = (uint32_t)(((uint64_t)Power_Rtc_Elapsed(start) * 1000000U) / power_stats.rtc_hz);
+		stop_rem_us += stop_us;
+		uwTick += stop_rem_us / 1000U;
+		stop_rem_us %= 1000U;
+		HAL_ResumeTick();
+
+		power_stats.stops++;
+		power_stats.asleep_us += stop_us;
+		if(__HAL_GPIO_EXTI_GET_IT(POWER_WAKE_PIN) != 0U)
+		{
+			Power_Can_Woke();
+			last_rx_tick = HAL_GetTick();	// stay in Sleep for the frames that follow
+		}
+	}
+	CLEAR_BIT(POWER_EXTI_IMR, POWER_WAKE_PIN);
+	CLEAR_BIT(POWER_EXTI_FTSR, POWER_WAKE_PIN);
+	__set_PRIMASK(primask);		// Power_Wake_Isr() clears a latched edge
+
+	if(HAL_CAN_WakeUp(power_can) != HAL_OK)
+	{
+		Error_Handler();
+	}
+}
+#endif
+
+/**
+  * @brief Log the awake share and the CAN wakeup latency every POWER_REPORT_MS
+  * @retval None
+  */
+static void Power_Report(void)
+{
+	uint32_t now_us;
+	uint32_t wall_us;
+	uint32_t asleep_us;
+
+	if((HAL_GetTick() - report_tick) < POWER_REPORT_MS)
+	{
+		return;
+	}
+	report_tick = HAL_GetTick();
+
+	now_us = Trace_Time_Us();
+	wall_us = now_us - report_us;
+	asleep_us = (uint32_t)(power_stats.asleep_us - report_asleep_us);
+	report_us = now_us;
+	report_asleep_us = power_stats.asleep_us;
+
+	power_stats.awake_permille = (asleep_us < wall_us)
+			? (uint32_t)(((uint64_t)(wall_us - asleep_us) * 1000U) / wall_us) : 0U;
+	LOG_INFO(LOG_MOD_APP, "power: awake %lu/1000, wake->frame %lu us", power_stats.awake_permille,
+			Cycle_Stats_Mean(&power_stats.wake_latency) / (SystemCoreClock / 1000000U));
+}
+
+/**
+  * @brief Set up the wake sources (after the CAN peripheral is started)
+  * With POWER_LEVEL_STOP this takes POWER_LSI_CAL_MS for the LSI calibration.
+  * @retval None
+  */
+void Power_Init(CAN_HandleTypeDef *hcan)
+{
+	power_can = hcan;
+	last_rx_tick = HAL_GetTick();
+
+#if POWER_LEVEL == POWER_LEVEL_STOP
+	Power_Rtc_Init();
+	Power_Rtc_Calibrate();
+
+	__HAL_RCC_SYSCFG_CLK_ENABLE();
+	POWER_WAKE_PORT_SELECT();		// EXTI line stays masked until Power_Stop()
+	HAL_NVIC_SetPriority(POWER_WAKE_IRQn, 15, 0);
+	HAL_NVIC_EnableIRQ(POWER_WAKE_IRQn);
+#endif
+
+	report_tick = HAL_GetTick();
+	report_us = Trace_Time_Us();
+}
+
+/**
+  * @brief Wait for the next interrupt if the main loop has nothing left to do
+  * Call last in the main loop. Work queued by an ISR between the check and
+  * WFI is not missed: WFI returns on a pending interrupt even with PRIMASK set.
+  * @retval None
+  */
+void Power_Idle(void)
+{
+#if POWER_LEVEL != POWER_LEVEL_RUN
+	uint32_t primask;
+	uint32_t start_us;
+#endif
+
+	Power_Report();
+
+#if POWER_LEVEL != POWER_LEVEL_RUN
+	start_us = Trace_Time_Us();
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(CAN_IF_Rx_Pending() != FALSE || Log_Pending() != FALSE)
+	{
+		__set_PRIMASK(primask);
+		return;
+	}
+
+#if POWER_LEVEL == POWER_LEVEL_STOP
+	if(Power_Stop_Allowed() != FALSE)
+	{
+		__set_PRIMASK(primask);
+		Power_Stop();
+		return;
+	}
+#endif
+
+	HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+	power_stats.sleeps++;
+	if(NVIC_GetPendingIRQ(CAN1_RX0_IRQn) != 0U)
+	{
+		Power_Can_Woke();
+	}
+	__set_PRIMASK(primask);		// the waking ISR runs here
+	power_stats.asleep_us += Trace_Time_Us() - start_us;
+#endif
+}
+
+/**
+  * @brief CAN_IF_Poll() handled a frame: close a pending wakeup measurement
+  * @retval None
+  */
+void Power_Rx_Handled(void)
+{
+	last_rx_tick = HAL_GetTick();
+	if(wake_pending != FALSE)
+	{
+		Cycle_Stats_Add(&power_stats.wake_latency, wake_stamp);
+		wake_pending = FALSE;
+	}
+}
+
+/**
+  * @brief CAN RX pin edge that ended Stop mode (EXTI ISR)
+  * @retval None
+  */
+void Power_Wake_Isr(void)
+{
+	if(__HAL_GPIO_EXTI_GET_IT(POWER_WAKE_PIN) != 0U)
+	{
+		__HAL_GPIO_EXTI_CLEAR_IT(POWER_WAKE_PIN);
+	}
+}
@@ -0,0 +1,173 @@
+/*
+ * publish.c
+ *
+ * Send-on-change signal publisher (see publish.h)
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "publish.h"
+#include "can_if.h"
+
+extern CAN_HandleTypeDef hcan1;
+
+typedef struct
+{
+	int32_t  value;                      // latest Publish_Set()
+	int32_t  sent;                       // value of the last frame
+	uint32_t sent_tick;
+	uint8_t  valid;                      // set at least once
+	uint8_t  ever_sent;
+	uint8_t  dirty;                      // change waiting for its frame
+} Publish_Signal_t;
+
+volatile Publish_Stats_t publish_stats[PUBLISH_SIGNAL_COUNT];
+
+static const Publish_Config_t config[PUBLISH_SIGNAL_COUNT] = PUBLISH_SIGNALS;
+static Publish_Signal_t signals[PUBLISH_SIGNAL_COUNT];
+
+/**
+  * @brief Distance between two values, wrap-safe
+  * @retval |a - b|
+  */
+static uint32_t Publish_Delta(int32_t a, int32_t b)
+{
+	return (a > b) ? (uint32_t)a - (uint32_t)b : (uint32_t)b - (uint32_t)a;
+}
+
+/**
+  * @brief No signal has a value yet, nothing is sent before the first update
+  * @retval None
+  */
+void Publish_Init(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < PUBLISH_SIGNAL_COUNT; i++)
+	{
+		signals[i].valid = FALSE;
+		signals[i].ever_sent = FALSE;
+		signals[i].dirty = FALSE;
+	}
+}
+
+/**
+  * @brief New value of a signal (any context)
+  * @retval None
+  */
+void Publish_Set(uint32_t signal, int32_t value)
+{
+	Publish_Signal_t *s;
+	uint32_t basepri;
+
+	if(signal >= PUBLISH_SIGNAL_COUNT)
+	{
+		return;
+	}
+	s = &signals[signal];
+
+	basepri = Irq_Lock();
+	s->value = value;
+	s->valid = TRUE;
+	publish_stats[signal].updates++;
+	if(s->ever_sent && Publish_Delta(value, s->sent) <= config[signal].deadband)
+	{
+		s->dirty = FALSE;				// back within the band of what is on the bus
+		publish_stats[signal].suppressed++;
+	}
+	else
+	{
+		if(s->dirty)
+		{
+			publish_stats[signal].coalesced++;
+		}
+		s->dirty = TRUE;
+	}
+	Irq_Unlock(basepri);
+}
+
+/**
+  * @brief Send the changes and refreshes that are due (main loop context)
+  * @retval None
+  */
+void Publish_Process(void)
+{
+	uint32_t now = HAL_GetTick();
+	const Publish_Config_t *cfg;
+	Publish_Signal_t *s;
+	CAN_Frame_t *frame;
+	uint32_t basepri;
+	uint32_t since;
+	uint8_t refresh;
+	uint8_t dirty;
+	uint8_t queued;
+	int32_t value;
+	uint32_t i;
+
+	for(i = 0; i < PUBLISH_SIGNAL_COUNT; i++)
+	{
+		s = &signals[i];
+		cfg = &config[i];
+
+		basepri = Irq_Lock();
+		value = s->value;
+		dirty = s->dirty;
+		Irq_Unlock(basepri);
+
+		if(s->valid == FALSE)
+		{
+			continue;
+		}
+
+		since = now - s->sent_tick;
+		refresh = (s->ever_sent && cfg->max_period_ms != 0U && since >= cfg->max_period_ms) ? TRUE : FALSE;
+		if(dirty == FALSE && refresh == FALSE)
+		{
+			continue;
+		}
+		if(refresh == FALSE && s->ever_sent && since < cfg->min_interval_ms)
+		{
+			continue;						// change held back, a newer one may replace it
+		}
+
+		frame = Frame_Pool_Alloc();
+		if(frame == NULL)
+		{
+			publish_stats[i].busy++;
+			continue;
+		}
+
+		queued = FALSE;
+		if(Publish_Fill_Callback(i, value, frame) != FALSE)
+		{
+			CAN_IF_Frame_Deadline(frame, cfg->deadline_ms);
+			queued = (CAN_IF_Send(&hcan1, frame) == HAL_OK) ? TRUE : FALSE;
+		}
+
+		if(queued)
+		{
+			basepri = Irq_Lock();
+			if(s->value == value)
+			{
+				s->dirty = FALSE;			// not if an update came in meanwhile
+			}
+			s->sent = value;
+			Irq_Unlock(basepri);
+
+			s->sent_tick = now;
+			s->ever_sent = TRUE;
+			publish_stats[i].sent++;
+			if(dirty == FALSE)
+			{
+				publish_stats[i].refreshes++;
+			}
+		}
+		else
+		{
+			publish_stats[i].busy++;
+		}
+
+		Frame_Pool_Release(frame);
+	}
+}
@@ -0,0 +1,223 @@
+/*
+ * sensor.c
+ *
+ * ADC + DMA sampling, decimation and the seqlock snapshot (see sensor.h)
+ * ADC1 is programmed through its registers (the HAL ADC driver is not part
+ * of this project); the DMA stream goes through the HAL DMA driver like the
+ * USART2 streams.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include "sensor.h"
+#include "aggregate.h"
+
+extern DMA_HandleTypeDef hdma_adc1;
+
+typedef struct
+{
+	volatile uint32_t seq;               // odd while the writer updates sample
+	Sensor_Sample_t sample;
+} Sensor_Snapshot_t;
+
+volatile Sensor_Stats_t sensor_stats;
+
+static Sensor_Snapshot_t snapshot;
+static uint16_t samples[2U * SENSOR_BLOCK];	// SRAM1: the CCM RAM (__CAN_BUFFER) is not reachable by DMA
+static int32_t  filter_q8;                   // IIR state, 16-bit scale << 8
+
+/**
+  * @brief Publish a new sample (DMA ISR, the only writer)
+  * @retval None
+  */
+static void Sensor_Publish(uint16_t value, uint16_t mean)
+{
+	snapshot.seq++;						// odd: readers retry
+	__DMB();
+	snapshot.sample.value = value;
+	snapshot.sample.mean = mean;
+	snapshot.sample.blocks++;
+	snapshot.sample.tick = HAL_GetTick();
+	__DMB();
+	snapshot.seq++;						// even: consistent again
+}
+
+/**
+  * @brief Decimate one DMA half and filter it
+  * @retval None
+  */
+static void Sensor_Block(const uint16_t *block)
+{
+	uint32_t sum = 0;
+	uint32_t mean;
+	uint32_t i;
+
+	for(i = 0; i < SENSOR_BLOCK; i++)
+	{
+		sum += block[i];
+	}
+	mean = (sum << 4) / SENSOR_BLOCK;	// 12-bit -> 16-bit scale
+
+	if(snapshot.sample.blocks == 0U)
+	{
+		filter_q8 = (int32_t)(mean << 8);	// start at the first block, not at 0
+	}
+	else
+	{
+		filter_q8 += ((int32_t)(mean << 8) - filter_q8) >> SENSOR_IIR_SHIFT;
+	}
+
+	Sensor_Publish((uint16_t)(filter_q8 >> 8), (uint16_t)mean);
+#if AGGREGATE_ENABLE
+	Aggregate_Add(AGGREGATE_SIGNAL_SENSOR, (uint16_t)mean);
+#endif
+}
+
+/**
+  * @brief DMA is in the second half: the first one is complete
+  * @retval None
+  */
+static void Sensor_Dma_Half(DMA_HandleTypeDef *hdma)
+{
+	UNUSED(hdma);
+	Sensor_Block(&samples[0]);
+}
+
+/**
+  * @brief DMA wrapped to the first half: the second one is complete
+  * @retval None
+  */
+static void Sensor_Dma_Full(DMA_HandleTypeDef *hdma)
+{
+	UNUSED(hdma);
+	Sensor_Block(&samples[SENSOR_BLOCK]);
+}
+
+/**
+  * @brief DMA transfer error: the stream is disabled by the HAL
+  * @retval None
+  */
+static void Sensor_Dma_Error(DMA_HandleTypeDef *hdma)
+{
+	UNUSED(hdma);
+	sensor_stats.dma_errors++;
+}
+
+/**
+  * @brief Start the circular transfer at the first half and the conversions
+  * @retval None
+  */
+static void Sensor_Start(void)
+{
+	if(HAL_DMA_Start_IT(&hdma_adc1, (uint32_t)&ADC1->DR, (uint32_t)samples, 2U * SENSOR_BLOCK) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	SET_BIT(ADC1->CR2, ADC_CR2_DMA);
+	SET_BIT(ADC1->CR2, ADC_CR2_SWSTART);
+}
+
+/**
+  * @brief Configure ADC1 and DMA2 Stream0 and start sampling
+  * @retval None
+  */
+void Sensor_Init(void)
+{
+#if SENSOR_ENABLE
+	__HAL_RCC_ADC1_CLK_ENABLE();
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	/* ADC1 -> samples[], half-word, circular over both halves */
+	hdma_adc1.Instance = DMA2_Stream0;
+	hdma_adc1.Init.Channel = DMA_CHANNEL_0;
+	hdma_adc1.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+	hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+	hdma_adc1.Init.Mode = DMA_CIRCULAR;
+	hdma_adc1.Init.Priority = DMA_PRIORITY_HIGH;
+	if(HAL_DMA_Init(&hdma_adc1) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	hdma_adc1.XferHalfCpltCallback = Sensor_Dma_Half;
+	hdma_adc1.XferCpltCallback = Sensor_Dma_Full;
+	hdma_adc1.XferErrorCallback = Sensor_Dma_Error;
+
+	/* ADCCLK = PCLK2 / 4 = 21 MHz, 12-bit, one channel, continuous, DMA requests without end */
+	MODIFY_REG(ADC123_COMMON->CCR, ADC_CCR_ADCPRE, ADC_CCR_ADCPRE_0);
+#if SENSOR_ADC_CHANNEL >= 16U
+	SET_BIT(ADC123_COMMON->CCR, ADC_CCR_TSVREFE);	// temperature sensor / VREFINT
+#endif
+	ADC1->CR1 = ADC_CR1_OVRIE;
+	ADC1->SQR1 = 0;						// L = 0: one conversion
+	ADC1->SQR3 = SENSOR_ADC_CHANNEL;
+#if SENSOR_ADC_CHANNEL >= 10U
+	MODIFY_REG(ADC1->SMPR1, ADC_SMPR1_SMP10 << (3U * (SENSOR_ADC_CHANNEL - 10U)),
+	           SENSOR_ADC_SMP << (3U * (SENSOR_ADC_CHANNEL - 10U)));
+#else
+	MODIFY_REG(ADC1->SMPR2, ADC_SMPR2_SMP0 << (3U * SENSOR_ADC_CHANNEL),
+	           SENSOR_ADC_SMP << (3U * SENSOR_ADC_CHANNEL));
+#endif
+	ADC1->CR2 = ADC_CR2_CONT | ADC_CR2_DDS | ADC_CR2_ADON;
+	HAL_Delay(1);						// ADC tSTAB and temperature sensor start-up
+
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 15, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+	HAL_NVIC_SetPriority(ADC_IRQn, 15, 0);
+	HAL_NVIC_EnableIRQ(ADC_IRQn);
+
+	Sensor_Start();
+#endif
+}
+
+/**
+  * @brief ADC overrun (ADC ISR): the DMA missed a result and DMA requests stopped
+  * The transfer is restarted at the first half so the halves stay aligned.
+  * @retval None
+  */
+void Sensor_Adc_Isr(void)
+{
+	if(READ_BIT(ADC1->SR, ADC_SR_OVR))
+	{
+		CLEAR_BIT(ADC1->CR2, ADC_CR2_DMA);
+		CLEAR_BIT(ADC1->SR, ADC_SR_OVR);
+		sensor_stats.overruns++;
+		(void)HAL_DMA_Abort(&hdma_adc1);
+		Sensor_Start();
+	}
+}
+
+/**
+  * @brief Consistent copy of the latest sample (main loop, lock-free)
+  * @retval sequence number of the copy, changes with every publication
+  */
+uint32_t Sensor_Read(Sensor_Sample_t *sample)
+{
+	uint32_t seq;
+
+	for(;;)
+	{
+		seq = snapshot.seq;
+		__DMB();
+		*sample = snapshot.sample;
+		__DMB();
+		if((seq & 1U) == 0U && seq == snapshot.seq)
+		{
+			return seq;
+		}
+		sensor_stats.read_retries++;
+	}
+}
+
+/**
+  * @brief Sequence number of the snapshot, to detect a new sample without copying it
+  * @retval sequence number (odd while a publication is in progress)
+  */
+uint32_t Sensor_Seq(void)
+{
+	return snapshot.seq;
+}
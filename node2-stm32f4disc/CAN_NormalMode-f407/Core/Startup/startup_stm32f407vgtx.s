@@ -94,6 +94,20 @@ LoopFillZerobss:
   cmp r2, r4
   bcc FillZerobss
 
+/* Zero fill the ccmbss segment (CAN buffers outside the main RAM bank). */
+  ldr r2, =_sccmbss
+  ldr r4, =_eccmbss
+  movs r3, #0
+  b LoopFillCcmbss
+
+FillCcmbss:
+  str  r3, [r2]
+  adds r2, r2, #4
+
+LoopFillCcmbss:
+  cmp r2, r4
+  bcc FillCcmbss
+
 /* Call static constructors */
     bl __libc_init_array
 /* Call the application's entry point.*/
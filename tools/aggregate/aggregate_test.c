@@ -0,0 +1,246 @@
+/*
+ * aggregate_test.c
+ *
+ * Host test of node2's Core/Src/aggregate.c, built by check_aggregate.py
+ * against stub/main.h. Aggregate_Publish_Callback() is defined here and
+ * records what it is handed; it fails on demand to exercise the deferral.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aggregate.h"
+#include "can_catalog.h"
+
+#define SIG     AGGREGATE_SIGNAL_SENSOR
+#define WIN_MS  100U
+
+uint32_t stub_tick;
+int      stub_lock_depth;
+
+static uint8_t publish_ok = TRUE;
+static uint32_t publish_calls;
+static Aggregate_Summary_t last;
+static int failures;
+
+#define CHECK(cond, ...) \
+	do { if(!(cond)) { failures++; printf("FAIL %s:%d: ", __func__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+uint8_t Aggregate_Publish_Callback(const Aggregate_Summary_t *summary)
+{
+	publish_calls++;
+	if(!publish_ok)
+	{
+		return FALSE;
+	}
+	last = *summary;
+	return TRUE;
+}
+
+static uint32_t rng_state = 12345U;
+
+static uint16_t rng(void)
+{
+	rng_state = rng_state * 1103515245U + 12345U;
+	return (uint16_t)(rng_state >> 16);
+}
+
+/* Fresh module, one signal with a WIN_MS window starting at tick */
+static void setup(uint32_t tick)
+{
+	stub_tick = tick;
+	stub_lock_depth = 0;
+	publish_ok = TRUE;
+	publish_calls = 0;
+	memset(&last, 0, sizeof(last));
+	memset((void *)aggregate_stats, 0, sizeof(aggregate_stats));
+	Aggregate_Init();
+	Aggregate_Set_Window(SIG, WIN_MS);
+}
+
+/* Run the main loop at tick */
+static void process_at(uint32_t tick)
+{
+	stub_tick = tick;
+	Aggregate_Process();
+	CHECK(stub_lock_depth == 0, "lock depth %d after Aggregate_Process", stub_lock_depth);
+}
+
+static void test_reference(void)
+{
+	uint32_t n, i, count, q, r;
+	uint16_t v, min, max;
+	uint64_t sum;
+
+	for(n = 0; n < 50; n++)
+	{
+		setup(1000U * n);
+		count = 1U + rng() % 3000U;
+		min = 0xFFFFU;
+		max = 0;
+		sum = 0;
+		for(i = 0; i < count; i++)
+		{
+			v = rng();
+			Aggregate_Add(SIG, v);
+			min = (v < min) ? v : min;
+			max = (v > max) ? v : max;
+			sum += v;
+		}
+		CHECK(stub_lock_depth == 0, "lock depth %d after Aggregate_Add", stub_lock_depth);
+		q = (uint32_t)(sum / count);
+		r = (uint32_t)(sum % count);
+		if(2U * r >= count)
+		{
+			q++;						// half up
+		}
+
+		process_at(1000U * n + WIN_MS);
+		CHECK(publish_calls == 1U, "window %u: %u publishes", n, publish_calls);
+		CHECK(last.signal == SIG && last.count == count && last.min == min && last.max == max && last.mean == q,
+		      "window %u: got %u/%u/%u/%u, want %u/%u/%u/%u", n,
+		      last.count, last.min, last.max, last.mean, count, min, max, q);
+		CHECK(aggregate_stats[SIG].samples == count && aggregate_stats[SIG].published == 1U,
+		      "window %u: stats", n);
+	}
+}
+
+static void test_one_sample(void)
+{
+	setup(0);
+	Aggregate_Add(SIG, 4242U);
+	process_at(WIN_MS);
+	CHECK(publish_calls == 1U && last.count == 1U && last.min == 4242U && last.max == 4242U && last.mean == 4242U,
+	      "got %u/%u/%u/%u", last.count, last.min, last.max, last.mean);
+}
+
+static void test_empty(void)
+{
+	setup(0);
+	process_at(WIN_MS);
+	process_at(2U * WIN_MS);
+	CHECK(publish_calls == 0U, "%u publishes for empty windows", publish_calls);
+	CHECK(aggregate_stats[SIG].windows == 2U && aggregate_stats[SIG].empty == 2U && aggregate_stats[SIG].published == 0U,
+	      "windows %u empty %u published %u", aggregate_stats[SIG].windows, aggregate_stats[SIG].empty,
+	      aggregate_stats[SIG].published);
+
+	/* a sample in the next window is not mixed with anything stale */
+	Aggregate_Add(SIG, 7U);
+	process_at(3U * WIN_MS);
+	CHECK(publish_calls == 1U && last.count == 1U && last.min == 7U && last.max == 7U, "after empty windows");
+}
+
+static void test_big_sum(void)
+{
+	uint32_t i;
+
+	/* 70000 x 65535 is above 2^32: a 32-bit sum would wrap */
+	setup(0);
+	for(i = 0; i < 70000U; i++)
+	{
+		Aggregate_Add(SIG, 0xFFFFU);
+	}
+	process_at(WIN_MS);
+	CHECK(last.count == 70000U && last.mean == 0xFFFFU, "count %u mean %u", last.count, last.mean);
+
+	/* mean 65534.5 rounds up */
+	setup(0);
+	for(i = 0; i < 35000U; i++)
+	{
+		Aggregate_Add(SIG, 0xFFFFU);
+		Aggregate_Add(SIG, 0xFFFEU);
+	}
+	process_at(WIN_MS);
+	CHECK(last.mean == 0xFFFFU && last.min == 0xFFFEU, "mean %u min %u", last.mean, last.min);
+}
+
+static void test_pack(void)
+{
+	static const uint32_t counts[][2] = { { 0, 0 }, { 1, 1 }, { 4095, 4095 }, { 4096, 4095 }, { 70000, 4095 } };
+	Aggregate_Summary_t summary = { 0x0FU, 0, 0x1234U, 0xFEDCU, 0x8001U };
+	CAN_SENSOR_SUMMARY_t msg;
+	uint8_t data[CAN_DLC_SENSOR_SUMMARY];
+	uint32_t i;
+
+	for(i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+	{
+		summary.count = counts[i][0];
+		Aggregate_Pack(data, &summary);
+		CAN_SENSOR_SUMMARY_Unpack(&msg, data);
+		CHECK(msg.count == counts[i][1], "count %u packed as %u", counts[i][0], msg.count);
+		CHECK(msg.signal == 0x0FU && msg.min == 0x1234U && msg.max == 0xFEDCU && msg.mean == 0x8001U,
+		      "count %u corrupts the other fields", counts[i][0]);
+	}
+}
+
+static void test_cadence(void)
+{
+	setup(0);
+
+	/* a late pass keeps the cadence: the next window still ends at 200 */
+	Aggregate_Add(SIG, 1U);
+	process_at(150U);
+	CHECK(aggregate_stats[SIG].windows == 1U, "window at 150");
+	process_at(199U);
+	CHECK(aggregate_stats[SIG].windows == 1U, "closed early at 199");
+	process_at(200U);
+	CHECK(aggregate_stats[SIG].windows == 2U, "window at 200");
+
+	/* more than a window behind: one close, then restart at now */
+	process_at(550U);
+	CHECK(aggregate_stats[SIG].windows == 3U, "%u windows after the gap", aggregate_stats[SIG].windows);
+	process_at(600U);
+	CHECK(aggregate_stats[SIG].windows == 3U, "no catch-up burst at 600");
+	process_at(649U);
+	CHECK(aggregate_stats[SIG].windows == 3U, "closed early at 649");
+	process_at(650U);
+	CHECK(aggregate_stats[SIG].windows == 4U, "window at 650");
+
+	/* the tick wraps */
+	setup(0xFFFFFFF0U);
+	Aggregate_Add(SIG, 1U);
+	process_at(0xFFFFFFF0U + WIN_MS);
+	CHECK(aggregate_stats[SIG].windows == 1U && publish_calls == 1U, "window across the tick wrap");
+}
+
+static void test_dropped(void)
+{
+	setup(0);
+	publish_ok = FALSE;
+
+	Aggregate_Add(SIG, 10U);
+	process_at(WIN_MS);
+	process_at(WIN_MS + 1U);
+	CHECK(aggregate_stats[SIG].deferred == 2U && aggregate_stats[SIG].dropped == 0U, "deferred %u dropped %u",
+	      aggregate_stats[SIG].deferred, aggregate_stats[SIG].dropped);
+
+	/* the next window replaces the unsent summary */
+	Aggregate_Add(SIG, 20U);
+	Aggregate_Add(SIG, 30U);
+	process_at(2U * WIN_MS);
+	CHECK(aggregate_stats[SIG].dropped == 1U, "dropped %u", aggregate_stats[SIG].dropped);
+
+	publish_ok = TRUE;
+	process_at(2U * WIN_MS + 1U);
+	CHECK(aggregate_stats[SIG].published == 1U && last.count == 2U && last.min == 20U && last.mean == 25U,
+	      "published %u, count %u min %u mean %u", aggregate_stats[SIG].published, last.count, last.min, last.mean);
+	process_at(2U * WIN_MS + 2U);
+	CHECK(aggregate_stats[SIG].published == 1U, "summary published twice");
+}
+
+int main(void)
+{
+	test_reference();
+	test_one_sample();
+	test_empty();
+	test_big_sum();
+	test_pack();
+	test_cadence();
+	test_dropped();
+
+	printf("%s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+check_aggregate.py
+
+Host test of node2's window aggregator (Core/Src/aggregate.c). Builds
+aggregate_test.c with the host C compiler against stub/main.h and runs it:
+
+  reference   count, min, max and rounded mean of random windows
+  one sample  min = max = mean
+  empty       windows without samples are counted and publish nothing
+  sum         more than 2^32 in a window, mean rounding at .5
+  pack        CAN_SENSOR_SUMMARY COUNT saturates at 4095 (Aggregate_Pack)
+  cadence     late passes keep the window grid, a gap restarts it once
+  dropped     a summary the publish path refused is replaced by the next one
+
+aggregate.c, aggregate.h and can_catalog.h are copied next to the stub so
+that #include "main.h" finds the stub and not the HAL one.
+Exit status is 1 if the build or any check fails.
+
+Usage:
+  check_aggregate.py
+  check_aggregate.py --cc clang
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+NODE2 = os.path.join(HERE, '..', '..', 'node2-stm32f4disc', 'CAN_NormalMode-f407', 'Core')
+SOURCES = (os.path.join('Src', 'aggregate.c'),
+           os.path.join('Inc', 'aggregate.h'),
+           os.path.join('Inc', 'can_catalog.h'))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Build and run the aggregate.c host test')
+    ap.add_argument('--cc', default=os.environ.get('CC', 'cc'), help='host C compiler')
+    args = ap.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        for name in SOURCES:
+            shutil.copy(os.path.join(NODE2, name), tmp)
+        shutil.copy(os.path.join(HERE, 'stub', 'main.h'), tmp)
+        exe = os.path.join(tmp, 'aggregate_test')
+        cmd = [args.cc, '-std=gnu11', '-Wall', '-Wextra', '-Werror', '-I', tmp, '-o', exe,
+               os.path.join(HERE, 'aggregate_test.c'), os.path.join(tmp, 'aggregate.c')]
+        if subprocess.call(cmd) != 0:
+            print('build failed')
+            return 1
+        rc = subprocess.call([exe])
+        if rc < 0:
+            print('test killed by signal %d' % -rc)
+        return 1 if rc != 0 else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
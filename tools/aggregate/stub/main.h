@@ -0,0 +1,38 @@
+/*
+ * main.h
+ *
+ * Host stand-in for node2's Core/Inc/main.h, just what aggregate.c uses:
+ * TRUE/FALSE, HAL_GetTick() on a settable tick and Irq_Lock()/Irq_Unlock()
+ * that only track the nesting depth, so the test can see unbalanced locks.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef STUB_MAIN_H_
+#define STUB_MAIN_H_
+
+#include <stdint.h>
+
+#define TRUE  1
+#define FALSE 0
+
+extern uint32_t stub_tick;
+extern int      stub_lock_depth;
+
+static inline uint32_t HAL_GetTick(void)
+{
+	return stub_tick;
+}
+
+static inline uint32_t Irq_Lock(void)
+{
+	return (uint32_t)stub_lock_depth++;
+}
+
+static inline void Irq_Unlock(uint32_t basepri)
+{
+	stub_lock_depth = (int)basepri;
+}
+
+#endif /* STUB_MAIN_H_ */
@@ -0,0 +1,316 @@
+#!/usr/bin/env python3
+"""
+budget_report.py
+
+Per-function size and stack budget of a CubeIDE build directory (Debug/ or
+Release/ of CAN_NormalMode-l476 or CAN_NormalMode-f407):
+
+  .map   input sections after "Linker script and memory map": flash and RAM
+         per object file, size of every function section (.text.<name>)
+         and of the functions placed in .RamFunc (__CAN_ISR)
+  .list  symbol boundaries of the disassembled code sections, which also
+         covers static functions merged by LTO
+  .su    -fstack-usage frames: "file:line:col:name<TAB>bytes<TAB>kind",
+         including the *.ltrans*.su files an -flto link writes
+  .cyclo -fcyclomatic-complexity per function, when present
+
+The table lists the largest functions with their stack frame. With
+--baseline the build is compared against a stored budget; a function or
+total that grows by more than --threshold percent (and --min-bytes) is a
+regression and the exit status is 1, which fails the post-build step.
+--update writes the current build as the new budget.
+
+Usage:
+  budget_report.py Release
+  budget_report.py Release --baseline ../../tools/budget/l476.json
+  budget_report.py Release --baseline ../../tools/budget/l476.json --update
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import sys
+
+FLASH_BASE = 0x08000000
+RAM_BASES = (0x10000000, 0x20000000)    # SRAM2 / CCM, SRAM1
+FLASH_SECTIONS = ('.isr_vector', '.text', '.rodata', '.ARM', '.init_array', '.fini_array', '.preinit_array')
+RAM_SECTIONS = ('.data', '.bss', '.ram2bss', '._user_heap_stack', '.RamFunc')
+
+MAP_SECTION = re.compile(r'^ (\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S+))?$')
+MAP_PLACEMENT = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S+)$')
+MAP_SYMBOL = re.compile(r'^\s+0x([0-9a-f]+)\s+([A-Za-z_]\w*)$')
+LIST_HEADER = re.compile(r'^\s*\d+\s+(\S+)\s+([0-9a-f]{8})\s+([0-9a-f]{8})\s+[0-9a-f]{8}')
+LIST_SECTION = re.compile(r'^Disassembly of section (\S+):')
+LIST_SYMBOL = re.compile(r'^([0-9a-f]{8}) <([^>]+)>:$')
+SU_LINE = re.compile(r'^(.*):(\d+):(\d+):(.+?)\t(\d+)\t(\S+)$')
+
+
+def region(addr):
+    if FLASH_BASE <= addr < FLASH_BASE + 0x08000000:
+        return 'flash'
+    for base in RAM_BASES:
+        if base <= addr < base + 0x00100000:
+            return 'ram'
+    return None
+
+
+def find_one(build, pattern):
+    files = sorted(glob.glob(os.path.join(build, pattern)))
+    if not files:
+        sys.exit('%s: no %s' % (build, pattern))
+    return files[0]
+
+
+def short_object(path):
+    return os.path.basename(path).replace('.o', '') if path.endswith('.o') else os.path.basename(path)
+
+
+def parse_map(path):
+    """Input sections of the final image: (section, addr, size, object, [(addr, symbol)])"""
+    sections = []
+    pending = None
+    started = False
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if not started:
+                started = line.startswith('Linker script and memory map')
+                continue
+            if line.startswith('OUTPUT(') or line.startswith('/DISCARD/'):
+                break
+            m = MAP_SECTION.match(line)
+            if m and not line.startswith('  '):
+                pending = None
+                if m.group(2) is None:
+                    pending = m.group(1)             # name too long: placement on the next line
+                else:
+                    sections.append([m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4), []])
+                continue
+            m = MAP_PLACEMENT.match(line)
+            if m and pending is not None:
+                sections.append([pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3), []])
+                pending = None
+                continue
+            m = MAP_SYMBOL.match(line)
+            if m and sections:
+                sections[-1][4].append((int(m.group(1), 16), m.group(2)))
+    return [s for s in sections if s[2] != 0 and s[1] != 0]
+
+
+def map_functions(sections):
+    """{name: (size, object, in_ram)} from .text.<name> sections and the symbols inside .RamFunc"""
+    funcs = {}
+    for name, addr, size, obj, symbols in sections:
+        if name.startswith('.text.'):
+            func = symbols[0][1] if len(symbols) == 1 else name[len('.text.'):]
+            funcs[func] = (size, short_object(obj), False)
+        elif name.startswith('.RamFunc') and symbols:
+            symbols = sorted(symbols)
+            for i, (sym_addr, sym) in enumerate(symbols):
+                end = symbols[i + 1][0] if i + 1 < len(symbols) else addr + size
+                funcs[sym] = (end - sym_addr, short_object(obj), True)
+    return funcs
+
+
+def map_objects(sections):
+    """{object: {'flash': bytes, 'ram': bytes}}; .data counts in both (copied at start-up)"""
+    objects = {}
+    for name, addr, size, obj, _ in sections:
+        kind = region(addr)
+        if kind is None:
+            continue
+        entry = objects.setdefault(short_object(obj), {'flash': 0, 'ram': 0})
+        entry[kind] += size
+        if kind == 'ram' and (name.startswith('.data') or name.startswith('.RamFunc')):
+            entry['flash'] += size
+    return objects
+
+
+def parse_list(path):
+    """({name: size} of disassembled symbols, {section: size} from the header)"""
+    headers = {}
+    funcs = {}
+    current = []
+    section = None
+
+    def close():
+        if section is None or not current:
+            return
+        end = headers.get(section, (0, 0))
+        end = end[1] + end[0]
+        for i, (addr, name) in enumerate(current):
+            nxt = current[i + 1][0] if i + 1 < len(current) else end
+            if nxt > addr:
+                funcs[name] = nxt - addr
+
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = LIST_HEADER.match(line)
+            if m and section is None:
+                headers[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+                continue
+            m = LIST_SECTION.match(line)
+            if m:
+                close()
+                section, current = m.group(1), []
+                continue
+            m = LIST_SYMBOL.match(line)
+            if m:
+                current.append((int(m.group(1), 16), m.group(2)))
+    close()
+    return funcs, {name: size for name, (size, _) in headers.items()}
+
+
+def parse_su(build):
+    """{name: (bytes, kind, source)}; a static name defined in several files keeps the largest frame"""
+    frames = {}
+    for path in glob.glob(os.path.join(build, '**', '*.su'), recursive=True):
+        with open(path, errors='replace') as f:
+            for line in f:
+                m = SU_LINE.match(line.rstrip('\n'))
+                if not m:
+                    continue
+                name = m.group(4).split('.')[0]      # LTO clones: name.constprop.0, name.isra.0
+                frame = int(m.group(5))
+                if name not in frames or frame > frames[name][0]:
+                    kind = m.group(6).replace(',ignoring_inline_asm', '')
+                    frames[name] = (frame, kind, os.path.basename(m.group(1)))
+    return frames
+
+
+def parse_cyclo(build):
+    cyclo = {}
+    for path in glob.glob(os.path.join(build, '**', '*.cyclo'), recursive=True):
+        with open(path, errors='replace') as f:
+            for line in f:
+                parts = line.rstrip('\n').rsplit('\t', 1)
+                if len(parts) == 2 and parts[1].isdigit():
+                    cyclo[parts[0].rsplit(':', 1)[-1]] = int(parts[1])
+    return cyclo
+
+
+def collect(build):
+    sections = parse_map(find_one(build, '*.map'))
+    list_funcs, list_sections = parse_list(find_one(build, '*.list'))
+    frames = parse_su(build)
+    cyclo = parse_cyclo(build)
+    funcs = {}
+    for name, (size, obj, in_ram) in map_functions(sections).items():
+        funcs[name] = {'size': size, 'object': obj, 'ram': in_ram}
+    for name, size in list_funcs.items():
+        if name.startswith('$') or name.startswith('.'):
+            continue
+        entry = funcs.setdefault(name, {'size': size, 'object': '', 'ram': False})
+        if not entry['ram']:
+            entry['size'] = size
+    for name, (frame, kind, source) in frames.items():
+        entry = funcs.get(name)
+        if entry is None:
+            continue                                 # removed by --gc-sections or inlined everywhere
+        entry['stack'] = frame
+        entry['stack_kind'] = kind
+    for name, value in cyclo.items():
+        if name in funcs:
+            funcs[name]['cyclo'] = value
+
+    objects = map_objects(sections)
+    flash = sum(size for name, size in list_sections.items() if name in FLASH_SECTIONS)
+    flash += sum(size for name, size in list_sections.items() if name == '.data')
+    ram = sum(size for name, size in list_sections.items() if name in RAM_SECTIONS)
+    if flash == 0:
+        flash = sum(o['flash'] for o in objects.values())
+        ram = sum(o['ram'] for o in objects.values())
+    return {'functions': funcs, 'objects': objects, 'totals': {'flash': flash, 'ram': ram}}
+
+
+def print_report(build, data, top, sort):
+    funcs = data['functions']
+    print('%s: flash %d bytes, RAM %d bytes (incl. heap/stack reserve)'
+          % (build, data['totals']['flash'], data['totals']['ram']))
+    if top == 0:
+        return
+    print('\n  %-36s %7s %6s %-8s %5s  %s' % ('function', 'bytes', 'stack', 'kind', 'cyclo', 'object'))
+    key = (lambda n: funcs[n].get('stack', 0)) if sort == 'stack' else (lambda n: funcs[n]['size'])
+    for name in sorted(funcs, key=key, reverse=True)[:top]:
+        f = funcs[name]
+        print('  %-36s %7d %6s %-8s %5s  %s%s' % (name[:36], f['size'],
+              f.get('stack', '-'), f.get('stack_kind', '-'), f.get('cyclo', '-'),
+              f['object'], ' (RAM)' if f['ram'] else ''))
+    print('\n  %-36s %7s %7s' % ('object', 'flash', 'RAM'))
+    for obj in sorted(data['objects'], key=lambda o: data['objects'][o]['flash'], reverse=True)[:top]:
+        o = data['objects'][obj]
+        print('  %-36s %7d %7d' % (obj[:36], o['flash'], o['ram']))
+
+
+def grown(old, new, threshold, min_bytes):
+    return new - old > max(min_bytes, old * threshold / 100.0)
+
+
+def check(data, budget, threshold, min_bytes):
+    """List of regressions against the stored budget"""
+    out = []
+    for name in ('flash', 'ram'):
+        old, new = budget['totals'][name], data['totals'][name]
+        if grown(old, new, threshold, min_bytes):
+            out.append('total %s %d -> %d bytes' % (name, old, new))
+    for name, old in sorted(budget['functions'].items()):
+        new = data['functions'].get(name)
+        if new is None:
+            continue
+        if grown(old['size'], new['size'], threshold, min_bytes):
+            out.append('%s: %d -> %d bytes' % (name, old['size'], new['size']))
+        if 'stack' in old and grown(old['stack'], new.get('stack', 0), threshold, 8):
+            out.append('%s: stack %d -> %d bytes' % (name, old['stack'], new.get('stack', 0)))
+        if old.get('stack_kind') == 'static' and new.get('stack_kind', 'static') != 'static':
+            out.append('%s: stack frame is now %s' % (name, new['stack_kind']))
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Per-function size and stack budget of a build directory')
+    ap.add_argument('build', help='CubeIDE build directory (Debug, Release)')
+    ap.add_argument('--baseline', help='budget JSON to compare against')
+    ap.add_argument('--update', action='store_true', help='write the current build as the budget')
+    ap.add_argument('--threshold', type=float, default=5.0, help='allowed growth [%%] (default 5)')
+    ap.add_argument('--min-bytes', type=int, default=16, help='growth always allowed [bytes] (default 16)')
+    ap.add_argument('--top', type=int, default=25, help='rows per table (default 25)')
+    ap.add_argument('--sort', choices=('size', 'stack'), default='size')
+    args = ap.parse_args()
+
+    data = collect(args.build)
+    print_report(args.build, data, args.top, args.sort)
+
+    if args.baseline and args.update:
+        with open(args.baseline, 'w') as f:
+            json.dump({'totals': data['totals'],
+                       'functions': {n: {k: v for k, v in f_.items() if k in ('size', 'stack', 'stack_kind')}
+                                     for n, f_ in sorted(data['functions'].items())}},
+                      f, indent=1, sort_keys=True)
+            f.write('\n')
+        print('\nbudget written to %s' % args.baseline)
+        return 0
+    if not args.baseline:
+        return 0
+    if not os.path.exists(args.baseline):
+        print('\n%s: no budget yet, run once with --update' % args.baseline)
+        return 0
+
+    with open(args.baseline) as f:
+        budget = json.load(f)
+    regressions = check(data, budget, args.threshold, args.min_bytes)
+    added = sorted(set(data['functions']) - set(budget['functions']))
+    print('\nbudget %s: flash %+d, RAM %+d bytes, %d new functions'
+          % (args.baseline, data['totals']['flash'] - budget['totals']['flash'],
+             data['totals']['ram'] - budget['totals']['ram'], len(added)))
+    for line in regressions:
+        print('  over budget: %s' % line)
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+"""
+stack_depth.py
+
+Worst-case main stack depth of a CubeIDE build directory (Debug/ or
+Release/ of CAN_NormalMode-l476 or CAN_NormalMode-f407). Thread code and
+every handler share the MSP, so the stack has to hold the deepest thread
+path plus one handler per preemption level that can nest on top of it:
+
+  call graph  bl / b.w targets of the disassembly; the ELF is disassembled
+              with arm-none-eabi-objdump when it is on the PATH (.data
+              included, where the __CAN_ISR functions run from), otherwise
+              the .list file is used and the RAM functions are leaves
+  frames      -fstack-usage .su files (budget_report.parse_su)
+  priorities  HAL_NVIC_SetPriority() calls in ../Core/Src, IRQn aliases from
+              ../Core/Inc, SysTick at TICK_INT_PRIORITY; an IRQ set under
+              #if alternatives keeps the more urgent one. NMI and HardFault
+              sit above every configurable level
+  stack size  _Min_Stack_Size of ../*_FLASH.ld
+
+Each handler level adds its exception frame: 8 words, or 26 words with the
+FPU context (both boards are hard-float, lazy stacking still reserves it),
+plus 4 bytes of alignment padding. Handlers with the same preemption
+priority do not nest; the deepest one counts for the level.
+
+Indirect calls (blx rN) are resolved from INDIRECT_CALLS and --indirect,
+anything else is reported and counted as 0. Recursion is reported and the
+cycle counted once. Functions without .su data (libc, assembly) count as
+0 bytes unless given with --frame.
+
+The exit status is 1 when the worst case exceeds _Min_Stack_Size.
+
+Usage:
+  stack_depth.py Debug
+  stack_depth.py Release --margin 15 --path
+  stack_depth.py Debug --indirect HAL_DMA_IRQHandler=UART_DMATransmitCplt --frame memcpy=16
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+import budget_report
+
+FRAME_BASIC = 32                        # r0-r3, r12, lr, pc, xPSR
+FRAME_FPU = 104                         # + s0-s15, FPSCR, reserved
+FRAME_ALIGN = 4                         # STKALIGN padding to 8 bytes
+
+LEVEL_NMI = -2
+LEVEL_HARDFAULT = -1
+
+# Function pointers the HAL and the application call through (blx rN);
+# names missing from the image are dropped
+INDIRECT_CALLS = {
+    'HAL_UART_IRQHandler': ['UART_RxISR_8BIT', 'UART_RxISR_16BIT', 'UART_TxISR_8BIT', 'UART_TxISR_16BIT',
+                            'UART_RxISR_8BIT_FIFOEN', 'UART_RxISR_16BIT_FIFOEN',
+                            'UART_TxISR_8BIT_FIFOEN', 'UART_TxISR_16BIT_FIFOEN',
+                            'UART_DMAAbortOnError'],
+    'HAL_DMA_IRQHandler': ['UART_DMATransmitCplt', 'UART_DMATxHalfCplt', 'UART_DMAReceiveCplt',
+                           'UART_DMARxHalfCplt', 'UART_DMAError', 'UART_DMAAbortOnError',
+                           'UART_DMATxAbortCallback', 'UART_DMARxAbortCallback',
+                           'UART_DMATxOnlyAbortCallback', 'UART_DMARxOnlyAbortCallback',
+                           'ADC_DMAConvCplt', 'ADC_DMAHalfConvCplt', 'ADC_DMAError',
+                           'Sensor_Dma_Half', 'Sensor_Dma_Full', 'Sensor_Dma_Error'],
+    'CAN_Isr_Tx': ['HAL_CAN_TxMailbox0CompleteCallback', 'HAL_CAN_TxMailbox1CompleteCallback',
+                   'HAL_CAN_TxMailbox2CompleteCallback', 'HAL_CAN_TxMailbox0AbortCallback',
+                   'HAL_CAN_TxMailbox1AbortCallback', 'HAL_CAN_TxMailbox2AbortCallback'],
+    '__libc_init_array': [],
+}
+
+CORE_HANDLERS = {
+    'NonMaskableInt': 'NMI_Handler', 'MemoryManagement': 'MemManage_Handler',
+    'BusFault': 'BusFault_Handler', 'UsageFault': 'UsageFault_Handler',
+    'SVCall': 'SVC_Handler', 'DebugMonitor': 'DebugMon_Handler',
+    'PendSV': 'PendSV_Handler', 'SysTick': 'SysTick_Handler',
+}
+
+INSN = re.compile(r'^\s*([0-9a-f]+):\s+(?:[0-9a-f]{4}(?: [0-9a-f]{4})?\s+)?(\S+)\s+(.*)$')
+TARGET = re.compile(r'^[0-9a-f]+ <([^>+]+)>$')
+BRANCH = re.compile(r'^b(?:l|eq|ne|cs|cc|hs|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le|al)?(?:\.[nw])?$')
+SET_PRIORITY = re.compile(r'HAL_NVIC_SetPriority\s*\(\s*(\w+)\s*,\s*(\w+)\s*,\s*\w+\s*\)')
+DEFINE = re.compile(r'^\s*#define\s+(\w+)\s+(\w+)')
+STACK_SIZE = re.compile(r'^\s*_Min_Stack_Size\s*=\s*(0x[0-9a-fA-F]+|\d+)\s*;')
+
+
+def callee(name):
+    """Long-branch veneers stand for their target"""
+    if name.startswith('__') and name.endswith('_veneer'):
+        return name[2:-len('_veneer')]
+    return name
+
+
+def parse_disassembly(lines):
+    """({function: set(callees)}, {function: number of unresolved blx})"""
+    calls = {}
+    indirect = {}
+    current = None
+    for line in lines:
+        m = budget_report.LIST_SYMBOL.match(line.rstrip('\n'))
+        if m:
+            current = callee(m.group(2))
+            calls.setdefault(current, set())
+            continue
+        m = INSN.match(line)
+        if not m or current is None:
+            continue
+        op, args = m.group(2), m.group(3).split(';')[0].strip()
+        if op == 'blx' and not TARGET.match(args):
+            indirect[current] = indirect.get(current, 0) + 1
+            continue
+        if op != 'blx' and not BRANCH.match(op):
+            continue
+        t = TARGET.match(args)
+        if t:
+            target = callee(t.group(1))
+            if target != current:                    # local loops branch to <name+0x..>
+                calls[current].add(target)
+    return calls, indirect
+
+
+def load_call_graph(build, objdump):
+    """Disassemble the ELF when objdump is available, else read the .list file"""
+    elf = glob.glob(os.path.join(build, '*.elf'))
+    tool = shutil.which(objdump) if objdump else None
+    if elf and tool:
+        lines = []
+        for args in (['-d'], ['-D', '-j', '.data']):
+            out = subprocess.run([tool] + args + [elf[0]], stdout=subprocess.PIPE,
+                                 universal_newlines=True, check=True).stdout
+            lines.extend(out.splitlines())
+        return parse_disassembly(lines), os.path.basename(elf[0]), True
+    path = budget_report.find_one(build, '*.list')
+    with open(path, errors='replace') as f:
+        return parse_disassembly(f), os.path.basename(path), False
+
+
+def parse_defines(project):
+    defines = {}
+    for path in glob.glob(os.path.join(project, 'Core', 'Inc', '*.h')):
+        with open(path, errors='replace') as f:
+            for line in f:
+                m = DEFINE.match(line)
+                if m:
+                    defines[m.group(1)] = m.group(2)
+    return defines
+
+
+def resolve(name, defines):
+    for _ in range(8):
+        if name not in defines:
+            break
+        name = defines[name]
+    return name
+
+
+def handler_name(irqn):
+    base = irqn[:-len('_IRQn')]
+    return CORE_HANDLERS.get(base, base + '_IRQHandler')
+
+
+def parse_priorities(project):
+    """{handler: preemption priority}; NVIC_PRIORITYGROUP_4, no subpriority bits"""
+    defines = parse_defines(project)
+    prio = {}
+    for path in sorted(glob.glob(os.path.join(project, 'Core', 'Src', '*.c'))):
+        with open(path, errors='replace') as f:
+            text = f.read()
+        for irqn, level in SET_PRIORITY.findall(text):
+            irqn = resolve(irqn, defines)
+            level = resolve(level, defines).rstrip('uU')
+            if not irqn.endswith('_IRQn') or not level.isdigit():
+                continue
+            handler = handler_name(irqn)
+            prio[handler] = min(prio.get(handler, 15), int(level))
+    tick = resolve('TICK_INT_PRIORITY', defines).rstrip('uU')
+    prio.setdefault('SysTick_Handler', int(tick) if tick.isdigit() else 0)
+    prio['HardFault_Handler'] = LEVEL_HARDFAULT
+    prio['NMI_Handler'] = LEVEL_NMI
+    return prio
+
+
+def parse_stack_size(project, path):
+    if path is None:
+        scripts = sorted(glob.glob(os.path.join(project, '*_FLASH.ld')))
+        if not scripts:
+            return None
+        path = scripts[0]
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = STACK_SIZE.match(line)
+            if m:
+                return int(m.group(1), 0)
+    return None
+
+
+class Graph(object):
+    def __init__(self, calls, indirect, frames):
+        self.calls = calls
+        self.indirect = indirect
+        self.frames = frames
+        self.memo = {}
+        self.active = set()
+        self.recursive = set()
+        self.unresolved = set()
+        self.no_frame = set()
+
+    def frame(self, name):
+        if name in self.frames:
+            return self.frames[name]
+        self.no_frame.add(name)
+        return 0
+
+    def depth(self, name):
+        """(bytes, path) of the deepest call chain starting at name"""
+        if name in self.memo:
+            return self.memo[name]
+        if name in self.active:
+            self.recursive.add(name)
+            return 0, []
+        self.active.add(name)
+        targets = set(self.calls.get(name, ()))
+        if name in INDIRECT_CALLS:
+            targets.update(t for t in INDIRECT_CALLS[name] if t in self.calls)
+        elif self.indirect.get(name):
+            self.unresolved.add(name)
+        best = (0, [])
+        for target in sorted(targets):
+            d = self.depth(target)
+            if d[0] > best[0]:
+                best = d
+        self.active.discard(name)
+        result = (self.frame(name) + best[0], [name] + best[1])
+        self.memo[name] = result
+        return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Worst-case MSP depth over the interrupt nesting levels')
+    parser.add_argument('build', help='build directory (Debug, Release)')
+    parser.add_argument('--ld', help='linker script with _Min_Stack_Size (default ../*_FLASH.ld)')
+    parser.add_argument('--objdump', default='arm-none-eabi-objdump',
+                        help='disassembler for the ELF, "" to use the .list file')
+    parser.add_argument('--indirect', action='append', default=[], metavar='CALLER=F1,F2',
+                        help='targets of the function pointers CALLER calls')
+    parser.add_argument('--frame', action='append', default=[], metavar='NAME=BYTES',
+                        help='frame of a function without .su data')
+    parser.add_argument('--no-fpu', action='store_true', help='8-word exception frames only')
+    parser.add_argument('--margin', type=int, default=10, help='percent added to the suggested stack size')
+    parser.add_argument('--path', action='store_true', help='print the deepest call chain of every entry')
+    args = parser.parse_args()
+
+    build = os.path.abspath(args.build)
+    project = os.path.dirname(build)
+
+    (calls, indirect), source, from_elf = load_call_graph(build, args.objdump)
+    frames = {name: frame for name, (frame, _, _) in budget_report.parse_su(build).items()}
+    for item in args.frame:
+        name, _, size = item.partition('=')
+        frames[name] = int(size, 0)
+    for item in args.indirect:
+        name, _, targets = item.partition('=')
+        INDIRECT_CALLS.setdefault(name, []).extend(t for t in targets.split(',') if t)
+
+    graph = Graph(calls, indirect, frames)
+    exception_frame = (FRAME_BASIC if args.no_fpu else FRAME_FPU) + FRAME_ALIGN
+    prio = parse_priorities(project)
+
+    entries = [('Reset_Handler', None)]
+    entries += sorted(((h, p) for h, p in prio.items() if h in calls), key=lambda e: (-e[1], e[0]))
+    missing = sorted(h for h in prio if h not in calls)
+
+    print('%s: call graph from %s%s' % (args.build, source, '' if from_elf else ' (RAM functions not disassembled)'))
+    print('%-32s %5s %6s %6s' % ('entry', 'prio', 'frame', 'depth'))
+    depth = {}
+    for name, level in entries:
+        d, path = graph.depth(name)
+        depth[name] = d
+        shown = 'thread' if level is None else 'NMI' if level == LEVEL_NMI else 'fault' if level < 0 else level
+        print('%-32s %5s %6d %6d' % (name, shown, graph.frame(name), d))
+        if args.path:
+            print('    ' + ' > '.join('%s(%d)' % (p, graph.frame(p)) for p in path))
+
+    # One handler per level, least urgent first: each can preempt the ones before it
+    levels = {}
+    for name, level in entries[1:]:
+        if level not in levels or depth[name] > depth[levels[level]]:
+            levels[level] = name
+    total = depth['Reset_Handler']
+    print()
+    print('nesting (exception frame %d bytes per level)' % exception_frame)
+    print('  %-30s %6d' % ('thread: Reset_Handler', total))
+    for level in sorted(levels, reverse=True):
+        name = levels[level]
+        total += exception_frame + depth[name]
+        print('  %-30s %6d  +%d' % ('%s: %s' % (level if level >= 0 else 'fault', name), total,
+                                     exception_frame + depth[name]))
+
+    if graph.recursive:
+        print('\nrecursion (cycle counted once): %s' % ', '.join(sorted(graph.recursive)))
+    if graph.unresolved:
+        print('\nunresolved indirect calls (counted as 0, see --indirect): %s' % ', '.join(sorted(graph.unresolved)))
+    reached = sorted(n for n in graph.no_frame if n in graph.memo)
+    if reached:
+        print('\nno .su frame (counted as 0, see --frame): %s' % ', '.join(reached))
+    if missing:
+        print('\nprioritised, no code of their own (Default_Handler alias or not built): %s' % ', '.join(missing))
+
+    suggested = (total * (100 + args.margin) // 100 + 7) & ~7
+    reserved = parse_stack_size(project, args.ld)
+    print()
+    if reserved is None:
+        print('worst case %d bytes, suggested _Min_Stack_Size 0x%x (+%d %%)' % (total, suggested, args.margin))
+        return 0
+    print('worst case %d bytes, _Min_Stack_Size 0x%x (%d): %+d bytes headroom, suggested 0x%x (+%d %%)'
+          % (total, reserved, reserved, reserved - total, suggested, args.margin))
+    return 1 if total > reserved else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
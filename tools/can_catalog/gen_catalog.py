@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+"""
+gen_catalog.py
+
+CAN message catalogue generator.
+Reads a DBC subset (BU_, BO_, SG_, CM_ BO_, BA_ "GenMsgRemoteRequest",
+BA_ "GenMsgNodeIndexed") and emits a header-only C file with, per message:
+  - CAN_ID_<MSG>, CAN_DLC_<MSG>
+  - for node-indexed messages (one instance per slave, ID = base + node ID,
+    the base ID itself being the broadcast request): CAN_ID_<MSG>_NODE(n)
+    and CAN_<MSG>_NODES
+  - a raw signal struct and static inline Pack/Unpack functions whose
+    shifts and masks are all constants (no loops, no branches)
+and, per node, the list of IDs it receives as bxCAN 16-bit filter entries.
+A node that sends a node-indexed message gets a function-like list,
+CAN_<NODE>_RX_FILTERS(node), since its own ID is only known at run time.
+
+Usage:
+  gen_catalog.py messages.dbc -o ../../node1-.../Core/Inc/can_catalog.h -o ...
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import re
+import sys
+
+RE_BU = re.compile(r'^BU_\s*:\s*(.*)$')
+RE_BO = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+RE_SG = re.compile(r'^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+                   r'\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]\s*"([^"]*)"\s*(.*)$')
+RE_CM = re.compile(r'^CM_\s+BO_\s+(\d+)\s+"([^"]*)"\s*;')
+RE_BA_RTR = re.compile(r'^BA_\s+"GenMsgRemoteRequest"\s+BO_\s+(\d+)\s+(\d+)\s*;')
+RE_BA_NODES = re.compile(r'^BA_\s+"GenMsgNodeIndexed"\s+BO_\s+(\d+)\s+(\d+)\s*;')
+
+
+class Signal:
+    def __init__(self, name, start, length, intel, signed, factor, offset, vmin, vmax, unit, receivers):
+        self.name = name
+        self.start = start
+        self.length = length
+        self.intel = intel
+        self.signed = signed
+        self.factor = factor
+        self.offset = offset
+        self.vmin = vmin
+        self.vmax = vmax
+        self.unit = unit
+        self.receivers = receivers
+
+    def bit_positions(self):
+        """Frame bit position (byte * 8 + bit) of every value bit, index = value bit."""
+        pos = [0] * self.length
+        if self.intel:
+            for i in range(self.length):
+                pos[i] = self.start + i
+        else:
+            p = self.start
+            for i in reversed(range(self.length)):
+                pos[i] = p
+                p = p + 15 if p % 8 == 0 else p - 1
+        return pos
+
+    def segments(self):
+        """Contiguous runs as (byte, byte_bit, value_bit, nbits)."""
+        runs = []
+        for vbit, fpos in enumerate(self.bit_positions()):
+            byte, bbit = divmod(fpos, 8)
+            if runs and runs[-1][0] == byte and runs[-1][1] + runs[-1][3] == bbit \
+                    and runs[-1][2] + runs[-1][3] == vbit:
+                runs[-1][3] += 1
+            else:
+                runs.append([byte, bbit, vbit, 1])
+        return [tuple(r) for r in runs]
+
+    def ctype(self):
+        width = 8 if self.length <= 8 else 16 if self.length <= 16 else 32
+        return ('int%d_t' if self.signed else 'uint%d_t') % width
+
+
+class Message:
+    def __init__(self, frame_id, name, dlc, sender):
+        self.frame_id = frame_id
+        self.name = name
+        self.dlc = dlc
+        self.sender = sender
+        self.signals = []
+        self.comment = ''
+        self.remote_request = False
+        self.nodes = 0                  # > 0: node-indexed, instances base + 1 .. base + nodes
+
+
+def parse(path):
+    nodes, messages, current = [], {}, None
+    with open(path, encoding='utf-8') as f:
+        for lineno, raw in enumerate(f, 1):
+            line = raw.strip()
+            m = RE_BU.match(line)
+            if m:
+                nodes = m.group(1).split()
+                continue
+            m = RE_BO.match(line)
+            if m:
+                current = Message(int(m.group(1)), m.group(2), int(m.group(3)), m.group(4))
+                if current.frame_id > 0x7FF:
+                    sys.exit('%s:%d: only standard IDs are supported' % (path, lineno))
+                messages[current.frame_id] = current
+                continue
+            m = RE_SG.match(line)
+            if m:
+                if current is None:
+                    sys.exit('%s:%d: SG_ outside of BO_' % (path, lineno))
+                if m.group(2):
+                    sys.exit('%s:%d: multiplexed signals are not supported' % (path, lineno))
+                sig = Signal(m.group(1), int(m.group(3)), int(m.group(4)), m.group(5) == '1',
+                             m.group(6) == '-', float(m.group(7)), float(m.group(8)),
+                             m.group(9), m.group(10), m.group(11),
+                             [r for r in re.split(r'[,\s]+', m.group(12)) if r])
+                if max(sig.bit_positions()) >= current.dlc * 8 or min(sig.bit_positions()) < 0:
+                    sys.exit('%s:%d: signal %s does not fit in DLC %d'
+                             % (path, lineno, sig.name, current.dlc))
+                current.signals.append(sig)
+                continue
+            m = RE_CM.match(line)
+            if m:
+                messages[int(m.group(1))].comment = m.group(2)
+                continue
+            m = RE_BA_RTR.match(line)
+            if m:
+                messages[int(m.group(1))].remote_request = m.group(2) == '1'
+                continue
+            m = RE_BA_NODES.match(line)
+            if m:
+                messages[int(m.group(1))].nodes = int(m.group(2))
+    for msg in messages.values():
+        if msg.nodes and msg.frame_id + msg.nodes > 0x7FF:
+            sys.exit('%s: %s: node-indexed range exceeds 0x7FF' % (path, msg.name))
+    return nodes, sorted(messages.values(), key=lambda msg: msg.frame_id)
+
+
+def receives(node, msg):
+    """(id expression, rtr) entries a node must accept for this message."""
+    entries = []
+    up = msg.name.upper()
+    if any(node in sig.receivers for sig in msg.signals):
+        if msg.nodes:
+            entries += [('0x%03XU' % (msg.frame_id + n), 0) for n in range(1, msg.nodes + 1)]
+        else:
+            entries.append(('0x%03XU' % msg.frame_id, 0))
+    if msg.remote_request and node == msg.sender:
+        if msg.nodes:
+            entries.append(('CAN_ID_%s_NODE(node)' % up, 1))   # own instance
+        entries.append(('0x%03XU' % msg.frame_id, 1))         # broadcast request
+    return entries
+
+
+def emit(nodes, messages, source):
+    out = []
+    w = out.append
+    w('/*')
+    w(' * can_catalog.h')
+    w(' *')
+    w(' * CAN message catalogue')
+    w(' * GENERATED by tools/can_catalog/gen_catalog.py from %s - do not edit.' % source)
+    w(' * Shared by node1 and node2: IDs, DLCs, filter entries and pack/unpack helpers.')
+    w(' */')
+    w('')
+    w('#ifndef INC_CAN_CATALOG_H_')
+    w('#define INC_CAN_CATALOG_H_')
+    w('')
+    w('#include <stdint.h>')
+    w('')
+    w('/* bxCAN filter register encodings for a standard ID */')
+    w('#define CAN_FILTER16(id, rtr)    ((uint16_t)(((id) << 5) | ((rtr) << 4)))')
+    w('#define CAN_FILTER32_HIGH(id)    ((uint16_t)((id) << 5))')
+    w('')
+    for msg in messages:
+        up = msg.name.upper()
+        w('/* ---------------- %s ---------------- */' % up)
+        if msg.comment:
+            w('/* %s */' % msg.comment)
+        w('#define CAN_ID_%-20s 0x%03XU' % (up, msg.frame_id))
+        w('#define CAN_DLC_%-19s %dU' % (up, msg.dlc))
+        w('#define CAN_RTR_REQUEST_%-11s %d' % (up, 1 if msg.remote_request else 0))
+        if msg.nodes:
+            w('#define CAN_%-23s %dU' % (up + '_NODES', msg.nodes))
+            w('#define CAN_ID_%-20s (CAN_ID_%s + (n))' % (up + '_NODE(n)', up))
+        for sig in msg.signals:
+            if sig.factor != 1.0 or sig.offset != 0.0:
+                w('#define CAN_%s_%s_FACTOR %sf' % (up, sig.name.upper(), repr(sig.factor)))
+                w('#define CAN_%s_%s_OFFSET %sf' % (up, sig.name.upper(), repr(sig.offset)))
+        w('')
+        w('typedef struct')
+        w('{')
+        for sig in msg.signals:
+            unit = (' ' + sig.unit) if sig.unit else ''
+            w('\t%-8s %s;%s// raw, [%s..%s]%s' % (sig.ctype(), sig.name.lower(),
+                                                 ' ' * max(1, 12 - len(sig.name)),
+                                                 sig.vmin, sig.vmax, unit))
+        w('} CAN_%s_t;' % up)
+        w('')
+        # pack
+        w('static inline void CAN_%s_Pack(uint8_t data[], const CAN_%s_t *msg)' % (up, up))
+        w('{')
+        per_byte = {b: [] for b in range(msg.dlc)}
+        for sig in msg.signals:
+            raw = '(uint32_t)msg->%s' % sig.name.lower()
+            for byte, bbit, vbit, n in sig.segments():
+                expr = '(%s >> %d)' % (raw, vbit) if vbit else raw
+                if n < 8:
+                    expr = '(%s & 0x%02XU)' % (expr, (1 << n) - 1)
+                if bbit:
+                    expr = '(%s << %d)' % (expr, bbit)
+                per_byte[byte].append(expr)
+        for byte in range(msg.dlc):
+            rhs = ' | '.join(per_byte[byte]) if per_byte[byte] else '0U'
+            w('\tdata[%d] = (uint8_t)(%s);' % (byte, rhs))
+        w('}')
+        w('')
+        # unpack
+        w('static inline void CAN_%s_Unpack(CAN_%s_t *msg, const uint8_t data[])' % (up, up))
+        w('{')
+        for sig in msg.signals:
+            parts = []
+            for byte, bbit, vbit, n in sig.segments():
+                expr = '(uint32_t)data[%d]' % byte
+                if bbit:
+                    expr = '(%s >> %d)' % (expr, bbit)
+                if n < 8:
+                    expr = '(%s & 0x%02XU)' % (expr, (1 << n) - 1)
+                if vbit:
+                    expr = '(%s << %d)' % (expr, vbit)
+                parts.append(expr)
+            rhs = ' | '.join(parts)
+            if sig.signed and sig.length < 32:
+                sh = 32 - sig.length
+                rhs = '(int32_t)((%s) << %d) >> %d' % (rhs, sh, sh)
+            w('\tmsg->%s = (%s)(%s);' % (sig.name.lower(), sig.ctype(), rhs))
+        w('}')
+        w('')
+    w('/* ---------------- Receive lists (bxCAN 16-bit list-mode entries) ---------------- */')
+    for node in nodes:
+        entries = [e for msg in messages for e in receives(node, msg)]
+        ids = ['CAN_FILTER16(%s, %d)' % e for e in entries]
+        if len(ids) > 4:
+            ids = ', \\\n\t'.join(', '.join(ids[i:i + 4]) for i in range(0, len(ids), 4))
+            ids = ' \\\n\t' + ids + ' \\\n'
+        else:
+            ids = ' ' + ', '.join(ids) + ' '
+        param = '(node)' if any('(node)' in e[0] for e in entries) else ''
+        w('#define CAN_%s_RX_COUNT%s %dU' % (node, ' ' * max(1, 10 - len(node)), len(entries)))
+        w('#define CAN_%s_RX_FILTERS%s%s {%s}' % (node, param, ' ' * max(1, 8 - len(node) - len(param)),
+                                                 ids))
+    w('')
+    w('#endif /* INC_CAN_CATALOG_H_ */')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Generate can_catalog.h from a DBC subset')
+    ap.add_argument('dbc')
+    ap.add_argument('-o', '--output', action='append', required=True,
+                    help='header to write (repeat for each firmware image)')
+    args = ap.parse_args()
+
+    nodes, messages = parse(args.dbc)
+    text = emit(nodes, messages, args.dbc.split('/')[-1])
+    for path in args.output:
+        with open(path, 'w', encoding='utf-8') as f:
+            f.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
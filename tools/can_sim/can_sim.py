@@ -0,0 +1,310 @@
+#!/usr/bin/env python3
+"""
+can_sim.py
+
+Bus-level simulator for the node-ID scheme and the master poll engine
+(Core/Inc/node_id.h, poll.h): one master and N virtual slaves share a
+simulated 500 kbit/s bus. Frames are sized bit-exactly (CRC-15 and stuff
+bits computed over the real header and payload), arbitration picks the
+lowest pending ID whenever the bus goes idle, and the master model follows
+poll.c:
+
+  pipelined  every --period-ms, sweep slaves 1..N with up to -k requests in
+             flight (3 TX mailboxes), retry after --timeout-us
+  broadcast  one request on the base ID per --period-ms, slave n answers
+             n * --reply-slot-ms later
+
+Slaves answer their own request after --latency-us (RX ISR -> TXRQ), the
+master reacts to a reply after --loop-us (main loop). Each slave also
+publishes one diagnostics frame per second (0x7E0 + node ID).
+
+Reported: bus load, sweep (poll cycle) time, reply latency, retries and
+missed replies, and the deepest backlog seen by the master's 3-frame RX
+FIFO (frames delivered within one ISR service time). Exit status is 1 if a live slave misses a
+reply, the bus load exceeds --max-load or the master RX FIFO would overflow.
+A --output capture can be inspected with can_trace.py (index, dump,
+latency for pipelined mode).
+
+Usage:
+  can_sim.py --nodes 30 -k 4 --period-ms 50
+  can_sim.py --nodes 30 -k 1                         # one request at a time
+  can_sim.py --nodes 30 --mode broadcast -o sim.ctr
+  can_sim.py --nodes 30 --drop 7,12                  # two silent slaves
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import heapq
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'can_trace'))
+from can_trace import FLAG_RTR, FLAG_TX, HEADER, MAGIC, VERSION, Record  # noqa: E402
+
+ID_SENSOR_DATA = 0x680           # can_catalog.h, node n on base + n
+DLC_SENSOR_DATA = 2
+ID_DIAG_BASE = 0x7E0             # can_diag.h
+DIAG_PERIOD_US = 1000000
+RX_FIFO_DEPTH = 3
+TX_MAILBOXES = 3
+
+
+def crc15(bits):
+    crc = 0
+    for b in bits:
+        nxt = b ^ ((crc >> 14) & 1)
+        crc = (crc << 1) & 0x7FFF
+        if nxt:
+            crc ^= 0x4599
+    return crc
+
+
+def frame_bits(can_id, rtr, dlc, data=b''):
+    """Bits on the wire for a standard frame, including stuffing and intermission."""
+    bits = [0]                                               # SOF
+    bits += [(can_id >> i) & 1 for i in range(10, -1, -1)]
+    bits += [1 if rtr else 0, 0, 0]                          # RTR, IDE, r0
+    bits += [(dlc >> i) & 1 for i in range(3, -1, -1)]
+    if not rtr:
+        for byte in data[:dlc]:
+            bits += [(byte >> i) & 1 for i in range(7, -1, -1)]
+    crc = crc15(bits)
+    bits += [(crc >> i) & 1 for i in range(14, -1, -1)]
+    stuffed, run, last = 0, 0, None
+    for b in bits:
+        run = run + 1 if b == last else 1
+        last = b
+        if run == 5:
+            stuffed += 1
+            last, run = 1 - b, 1                             # stuff bit starts a new run
+    return len(bits) + stuffed + 1 + 2 + 7 + 3               # CRC delim, ACK, EOF, IFS
+
+
+class Bus:
+    def __init__(self, bitrate):
+        self.bit_us = 1e6 / bitrate
+        self.future = []         # heap of (ready_us, seq, frame)
+        self.ready = []          # heap of (can_id, seq, frame), contending for the bus
+        self.seq = 0
+        self.busy_us = 0.0
+
+    def queue(self, t_us, sender, can_id, rtr, dlc, data=b''):
+        heapq.heappush(self.future, (t_us, self.seq, (sender, can_id, rtr, dlc, data)))
+        self.seq += 1
+
+    def next_start(self, t_idle):
+        """Time the next frame would start, None if nothing is queued."""
+        if self.ready:
+            return t_idle
+        return max(t_idle, self.future[0][0]) if self.future else None
+
+    def next_frame(self, t_idle):
+        """Arbitration: among frames ready when the bus goes idle, lowest ID wins."""
+        start = t_idle
+        if not self.ready:
+            if not self.future:
+                return None
+            start = max(t_idle, self.future[0][0])
+        while self.future and self.future[0][0] <= start:
+            _, seq, frame = heapq.heappop(self.future)
+            heapq.heappush(self.ready, (frame[1], seq, frame))
+        frame = heapq.heappop(self.ready)[2]
+        duration = frame_bits(frame[1], frame[2], frame[3], frame[4]) * self.bit_us
+        self.busy_us += duration
+        return start, start + duration, frame
+
+
+class PipelinedMaster:
+    """poll.c, POLL_MODE_PIPELINED."""
+
+    def __init__(self, args, bus):
+        self.a, self.bus = args, bus
+        self.next_node = args.nodes + 1
+        self.inflight = {}               # reply ID -> [sent_us, retries]
+        self.tx_pending = 0              # requests waiting in a TX mailbox
+        self.period_start = None
+        self.cycle_start = None
+        self.cycles, self.latencies = [], []
+        self.requests = self.retries = self.missed = self.unexpected = 0
+        self.wake_at = 0.0
+
+    def request(self, t, can_id):
+        if self.tx_pending >= TX_MAILBOXES:
+            return False
+        self.bus.queue(t, 0, can_id, True, DLC_SENSOR_DATA)
+        self.tx_pending += 1
+        self.requests += 1
+        return True
+
+    def process(self, t):
+        a = self.a
+        for can_id, ent in list(self.inflight.items()):
+            if t - ent[0] < a.timeout_us:
+                continue
+            if ent[1] < a.retries:
+                if self.request(t, can_id):
+                    ent[0], ent[1] = t, ent[1] + 1
+                    self.retries += 1
+            else:
+                self.missed += 1
+                del self.inflight[can_id]
+        if self.next_node > a.nodes and not self.inflight:
+            if self.cycle_start is not None:
+                self.cycles.append(t - self.cycle_start)
+                self.cycle_start = None
+            tick = int(t // 1000)
+            if self.period_start is not None and tick - self.period_start < a.period_ms:
+                self.wake_at = (self.period_start + a.period_ms) * 1000.0
+                return
+            self.period_start, self.cycle_start, self.next_node = tick, t, 1
+        while len(self.inflight) < a.outstanding and self.next_node <= a.nodes:
+            can_id = ID_SENSOR_DATA + self.next_node
+            if not self.request(t, can_id):
+                break
+            self.inflight[can_id] = [t, 0]
+            self.next_node += 1
+        self.wake_at = min([e[0] + a.timeout_us for e in self.inflight.values()] or [float('inf')])
+
+    def on_sent(self, t):
+        self.tx_pending -= 1
+        self.wake_at = min(self.wake_at, t + self.a.loop_us)
+
+    def on_reply(self, t, can_id):
+        ent = self.inflight.pop(can_id, None)
+        if ent is None:
+            self.unexpected += 1
+        else:
+            self.latencies.append(t - ent[0])
+        self.wake_at = min(self.wake_at, t + self.a.loop_us)
+
+
+class BroadcastMaster:
+    """poll.c, POLL_MODE_BROADCAST."""
+
+    def __init__(self, args, bus):
+        self.a, self.bus = args, bus
+        self.sent_at, self.seen = None, set()
+        self.cycles, self.latencies = [], []
+        self.requests = self.retries = self.missed = self.unexpected = 0
+        self.wake_at = 0.0
+
+    def process(self, t):
+        if self.sent_at is not None:
+            self.missed += self.a.nodes - len(self.seen)
+            self.cycles.append(self.a.period_ms * 1000.0)
+        self.seen = set()
+        self.sent_at = None
+        self.bus.queue(t, 0, ID_SENSOR_DATA, True, DLC_SENSOR_DATA)
+        self.requests += 1
+        self.wake_at = t + self.a.period_ms * 1000.0
+
+    def on_sent(self, t):
+        self.sent_at = t
+
+    def on_reply(self, t, can_id):
+        if self.sent_at is None or can_id in self.seen:
+            self.unexpected += 1
+            return
+        self.seen.add(can_id)
+        self.latencies.append(t - self.sent_at)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Multi-node CAN bus simulator')
+    ap.add_argument('-n', '--nodes', type=int, default=30, help='slaves, node IDs 1..N (max 31)')
+    ap.add_argument('-m', '--mode', choices=('pipelined', 'broadcast'), default='pipelined')
+    ap.add_argument('-k', '--outstanding', type=int, default=4, help='POLL_OUTSTANDING')
+    ap.add_argument('--period-ms', type=int, default=50, help='POLL_PERIOD_MS')
+    ap.add_argument('--timeout-us', type=float, default=2000.0, help='POLL_TIMEOUT_US')
+    ap.add_argument('--retries', type=int, default=1, help='POLL_RETRIES')
+    ap.add_argument('--reply-slot-ms', type=int, default=1, help='broadcast: NODE_REPLY_SLOT_MS')
+    ap.add_argument('--bitrate', type=int, default=500000)
+    ap.add_argument('--latency-us', type=float, default=5.0, help='slave request -> TXRQ')
+    ap.add_argument('--loop-us', type=float, default=20.0, help='master reply -> next request')
+    ap.add_argument('--isr-us', type=float, default=10.0, help='master RX ISR service time')
+    ap.add_argument('-d', '--duration', type=float, default=10.0, help='simulated seconds')
+    ap.add_argument('--drop', default='', help='comma separated silent node IDs')
+    ap.add_argument('--max-load', type=float, default=20.0, help='bus load limit [%%]')
+    ap.add_argument('-o', '--output', help='write the master view as a .ctr capture')
+    args = ap.parse_args()
+
+    if not 1 <= args.nodes <= 31:
+        sys.exit('--nodes must be 1..31')
+    if min(args.period_ms, args.reply_slot_ms, args.outstanding) < 1:
+        sys.exit('--period-ms, --reply-slot-ms and -k must be at least 1')
+    silent = {int(x) for x in args.drop.split(',') if x}
+    end_us = args.duration * 1e6
+    bus = Bus(args.bitrate)
+    master = (PipelinedMaster if args.mode == 'pipelined' else BroadcastMaster)(args, bus)
+
+    for node in range(1, args.nodes + 1):
+        for t_us in range(node * 1000, int(end_us), DIAG_PERIOD_US):   # staggered boot
+            bus.queue(float(t_us), node, ID_DIAG_BASE + node, False, 8, bytes(8))
+
+    t, records, rx_times = 0.0, [], []
+    while True:
+        start = bus.next_start(t)
+        if master.wake_at <= end_us and (start is None or master.wake_at < start):
+            master.process(max(master.wake_at, 0.0))
+            continue
+        if start is None or start > end_us:
+            break
+        start, t, (sender, can_id, rtr, dlc, data) = bus.next_frame(t)
+        records.append(Record(int(t), can_id, (FLAG_RTR if rtr else 0) | (FLAG_TX if sender == 0 else 0),
+                              dlc, 0, data.ljust(8, b'\0')))
+        if sender == 0:
+            master.on_sent(t)
+            if can_id == ID_SENSOR_DATA:
+                tick_ms = int(t // 1000)
+                for node in range(1, args.nodes + 1):
+                    if node not in silent:
+                        due = (tick_ms + node * args.reply_slot_ms) * 1000.0
+                        bus.queue(due, node, ID_SENSOR_DATA + node, False, DLC_SENSOR_DATA, b'\xAB\xCD')
+            elif can_id - ID_SENSOR_DATA not in silent:
+                bus.queue(t + args.latency_us, can_id - ID_SENSOR_DATA, can_id, False, DLC_SENSOR_DATA,
+                          b'\xAB\xCD')
+        else:
+            rx_times.append(t)
+            if not rtr and 1 <= can_id - ID_SENSOR_DATA <= args.nodes:
+                master.on_reply(t, can_id)
+
+    # deepest master FIFO backlog: frames arriving while the ISR is still busy
+    backlog, depth, free_at = 0, 0, 0.0
+    for rx in rx_times:
+        depth = depth + 1 if rx < free_at else 1
+        free_at = max(free_at, rx) + args.isr_us
+        backlog = max(backlog, depth)
+
+    live_missed = master.missed - (len(master.cycles) + 1) * len(silent & set(range(1, args.nodes + 1)))
+    load = 100.0 * bus.busy_us / end_us
+    cycles = sorted(master.cycles)
+    latencies = sorted(master.latencies)
+
+    print('%d slaves, %s, %d kbit/s, %.1f s simulated' % (args.nodes, args.mode, args.bitrate // 1000,
+                                                         args.duration))
+    print('  bus load        %.1f %% (limit %.0f %%)' % (load, args.max_load))
+    if cycles:
+        print('  poll cycle      %d sweeps, min %.2f ms, median %.2f ms, max %.2f ms (period %d ms)'
+              % (len(cycles), cycles[0] / 1000, cycles[len(cycles) // 2] / 1000, cycles[-1] / 1000,
+                 args.period_ms))
+    print('  requests        %d, %d retries, %d replies, %d missed, %d unexpected'
+          % (master.requests, master.retries, len(latencies), master.missed, master.unexpected))
+    if latencies:
+        print('  reply latency   min %.0f us, median %.0f us, max %.0f us'
+              % (latencies[0], latencies[len(latencies) // 2], latencies[-1]))
+    print('  master RX FIFO  deepest backlog %d of %d' % (backlog, RX_FIFO_DEPTH))
+
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(HEADER.pack(MAGIC, VERSION, 0))
+            for rec in records:
+                f.write(rec.pack())
+
+    ok = live_missed <= 0 and load <= args.max_load and backlog <= RX_FIFO_DEPTH
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+can_console.py
+
+Host side of the node command console (Core/Inc/console.h).
+Sends one UART_LINK_TYPE_CMD packet and prints the matching reply; trace
+and text packets arriving in between are ignored.
+
+Usage:
+  can_console.py /dev/ttyACM0 ping
+  can_console.py /dev/ttyACM0 period 250              # TIM6 TX period [ms]
+  can_console.py /dev/ttyACM0 filters 651 651:r 65D   # receive list, ":r" = remote frame
+  can_console.py /dev/ttyACM0 log 1                   # trace: 0 off, 1 text, 2 text + frames
+  can_console.py /dev/ttyACM0 log can 4               # module (app/can/diag/link/all) level 0..4
+  can_console.py /dev/ttyACM0 bittiming 6 11 2 1      # prescaler, BS1, BS2, SJW [tq]
+  can_console.py /dev/ttyACM0 stats
+  can_console.py /dev/ttyACM0 rxload                  # RX CPU load per frame rate, interrupt vs polling
+  can_console.py /dev/ttyACM0 isr save hal.json       # CAN ISR cycles per vector, kept as a baseline
+  can_console.py /dev/ttyACM0 isr hal.json            # ... compared against the baseline
+  can_console.py /dev/ttyACM0 publish                 # send-on-change: updates vs frames per signal
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import json
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+from can_trace import BAUDS, LINK_TYPE_CMD, LINK_TYPE_REPLY, cobs_decode, crc16_ccitt, link_encode
+
+OP_PING = 0x01
+OP_SET_TX_PERIOD = 0x02
+OP_SET_FILTERS = 0x03
+OP_SET_LOG = 0x04
+OP_SET_BITTIMING = 0x05
+OP_GET_STATS = 0x06
+OP_GET_RX_LOAD = 0x07
+OP_GET_ISR_CYCLES = 0x08
+OP_GET_PUBLISH = 0x09
+
+STATUS = {0x00: 'ok', 0x01: 'bad length', 0x02: 'bad argument', 0x03: 'unknown opcode',
+          0x04: 'HAL error'}
+
+LOG_MODULES = {'app': 0, 'can': 1, 'diag': 2, 'link': 3, 'all': 0xFF}
+
+STATS = ('bus_off', 'error_passive', 'error_warning', 'rx_fifo_overrun',
+         'pool_high_water', 'pool_alloc_fail', 'rx_ring_full',
+         'link_tx_packets', 'link_tx_dropped', 'link_rx_packets', 'link_rx_bad', 'link_rx_overrun',
+         'log_suppressed', 'log_dropped', 'log_format_cycles')
+
+ISR_VECTORS = ('tx', 'rx0', 'rx1', 'sce')
+
+PUBLISH_SIGNALS = ('led_cmd',)             # PUBLISH_SIGNAL_xxx order (publish.h)
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd)
+        attr = termios.tcgetattr(fd)
+        attr[4] = attr[5] = BAUDS[baud]
+        termios.tcsetattr(fd, termios.TCSANOW, attr)
+        termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+def transact(fd, op, args, timeout):
+    os.write(fd, link_encode(LINK_TYPE_CMD, bytes([op]) + args))
+    buf = b''
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        ready, _, _ = select.select([fd], [], [], max(0.0, deadline - time.monotonic()))
+        if not ready:
+            break
+        buf += os.read(fd, 4096)
+        blocks = buf.split(b'\0')
+        buf = blocks.pop()
+        for block in blocks:
+            packet = cobs_decode(block) if block else None
+            if packet is None or len(packet) < 5 \
+                    or crc16_ccitt(packet[:-2]) != packet[-2] | (packet[-1] << 8):
+                continue
+            if packet[0] == LINK_TYPE_REPLY and packet[1] == op:
+                return packet[2], packet[3:-2]
+    sys.exit('no reply within %.1f s' % timeout)
+
+
+def encode_filters(specs):
+    out = b''
+    for spec in specs:
+        ident, _, kind = spec.partition(':')
+        value = int(ident, 16)
+        if value > 0x7FF:
+            sys.exit('%s: only standard IDs can be filtered' % spec)
+        out += struct.pack('<H', value | (0x8000 if kind.lower() == 'r' else 0))
+    return out
+
+
+def print_rx_load(data):
+    """RX CPU load curve: one row per frame rate bucket, both RX modes"""
+    mode, buckets, bucket_fps, fps = struct.unpack_from('<BBHH', data, 0)
+    loads = struct.unpack_from('<%dH' % (2 * buckets), data, 6)
+    print('  mode %s, %d frames/s' % ('polling' if mode else 'interrupt', fps))
+    print('  %-14s %10s %10s' % ('frames/s', 'irq [%]', 'poll [%]'))
+    for i in range(buckets):
+        top = '+' if i == buckets - 1 else '-%d' % ((i + 1) * bucket_fps - 1)
+        cells = ['%10s' % ('-' if v == 0xFFFF else '%.1f' % (v / 10.0)) for v in (loads[i], loads[buckets + i])]
+        print('  %-14s %s %s' % ('%d%s' % (i * bucket_fps, top), cells[0], cells[1]))
+
+
+def print_isr_cycles(data, args):
+    """Per-vector CAN ISR cycles; 'save FILE' keeps them, 'FILE' compares against them"""
+    flags = data[0]
+    vectors = {}
+    for i, name in enumerate(ISR_VECTORS):
+        count, lo, hi, mean = struct.unpack_from('<IHHH', data, 1 + 10 * i)
+        vectors[name] = {'count': count, 'min': lo, 'max': hi, 'mean': mean}
+    build = '%s, %s' % ('lean handlers' if flags & 2 else 'HAL_CAN_IRQHandler', 'RAM' if flags & 1 else 'flash')
+    base = None
+    if len(args) == 2 and args[0] == 'save':
+        with open(args[1], 'w') as f:
+            json.dump({'build': build, 'vectors': vectors}, f, indent=1)
+    elif args:
+        with open(args[0]) as f:
+            base = json.load(f)
+
+    print('  %s' % build)
+    print('  %-6s %10s %7s %7s %7s' % ('vector', 'entries', 'min', 'max', 'mean'), end='')
+    print('   vs %s' % base['build'] if base else '')
+    for name in ISR_VECTORS:
+        v = vectors[name]
+        print('  %-6s %10d %7d %7d %7d' % (name, v['count'], v['min'], v['max'], v['mean']), end='')
+        b = base['vectors'][name] if base else None
+        if b and b['count'] and v['count']:
+            saved = b['mean'] - v['mean']
+            print('   %+d cycles (%+.0f%%)' % (-saved, -100.0 * saved / b['mean'] if b['mean'] else 0.0))
+        else:
+            print('')
+
+
+def print_publish(data):
+    """Send-on-change counters; saved = updates that did not become a frame"""
+    print('  %-10s %9s %9s %9s %10s %9s %7s' % ('signal', 'updates', 'sent', 'refresh', 'suppressed',
+                                              'coalesced', 'saved'))
+    for i in range(data[0]):
+        updates, sent, refreshes, suppressed, coalesced = struct.unpack_from('<5I', data, 1 + 20 * i)
+        name = PUBLISH_SIGNALS[i] if i < len(PUBLISH_SIGNALS) else str(i)
+        saved = '%.1f%%' % (100.0 * (updates - sent) / updates) if updates else '-'
+        print('  %-10s %9d %9d %9d %10d %9d %7s' % (name, updates, sent, refreshes, suppressed, coalesced, saved))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Node command console')
+    ap.add_argument('port')
+    ap.add_argument('-b', '--baud', type=int, default=2000000)
+    ap.add_argument('-t', '--timeout', type=float, default=1.0)
+    ap.add_argument('command', choices=('ping', 'period', 'filters', 'log', 'bittiming', 'stats', 'rxload', 'isr',
+                                            'publish'))
+    ap.add_argument('args', nargs='*')
+    args = ap.parse_args()
+
+    if args.command == 'ping':
+        op, payload = OP_PING, b''
+    elif args.command == 'period':
+        op, payload = OP_SET_TX_PERIOD, struct.pack('<H', int(args.args[0]))
+    elif args.command == 'filters':
+        op, payload = OP_SET_FILTERS, encode_filters(args.args)
+    elif args.command == 'log' and len(args.args) == 2:
+        module = LOG_MODULES[args.args[0]] if args.args[0] in LOG_MODULES else int(args.args[0])
+        op, payload = OP_SET_LOG, bytes([module, int(args.args[1])])
+    elif args.command == 'log':
+        op, payload = OP_SET_LOG, bytes([int(args.args[0])])
+    elif args.command == 'bittiming':
+        prescaler, bs1, bs2, sjw = (int(x) for x in args.args)
+        op, payload = OP_SET_BITTIMING, struct.pack('<HBBB', prescaler, bs1, bs2, sjw)
+    elif args.command == 'stats':
+        op, payload = OP_GET_STATS, b''
+    elif args.command == 'rxload':
+        op, payload = OP_GET_RX_LOAD, b''
+    elif args.command == 'isr':
+        op, payload = OP_GET_ISR_CYCLES, b''
+    else:
+        op, payload = OP_GET_PUBLISH, b''
+
+    fd = open_port(args.port, args.baud)
+    status, data = transact(fd, op, payload, args.timeout)
+    os.close(fd)
+
+    print('%s: %s' % (args.command, STATUS.get(status, 'status 0x%02X' % status)))
+    if op == OP_GET_STATS and status == 0 and len(data) >= 2 + 4 * len(STATS):
+        print('  %-18s %d' % ('tec', data[0]))
+        print('  %-18s %d' % ('rec', data[1]))
+        for name, value in zip(STATS, struct.unpack_from('<%dI' % len(STATS), data, 2)):
+            print('  %-18s %d' % (name, value))
+    if op == OP_GET_RX_LOAD and status == 0 and len(data) >= 6:
+        print_rx_load(data)
+    if op == OP_GET_ISR_CYCLES and status == 0 and len(data) >= 1 + 10 * len(ISR_VECTORS):
+        print_isr_cycles(data, args.args)
+    if op == OP_GET_PUBLISH and status == 0 and len(data) >= 1:
+        print_publish(data)
+    return 0 if status == 0 else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
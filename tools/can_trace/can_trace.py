@@ -0,0 +1,492 @@
+#!/usr/bin/env python3
+"""
+can_trace.py
+
+Capture, index, export and replay CAN traffic traced by a node on its
+debug UART. The firmware sends COBS-framed, CRC-16 checked packets
+(Core/Inc/uart_link.h): CAN frame packets are indexed, text packets are
+passed through. The older "@tick ..." text trace is still accepted with
+--protocol text.
+
+  capture  read a node's UART stream (file, pty or tty) into a .ctr capture
+  index    per-ID summary of a capture: count, first/last time, mean period
+  dump     print records, optionally filtered by ID and time window
+  export   write a candump (-L) or Vector ASC log
+  latency  remote request -> data reply time on the requesting node
+  replay   send a capture onto a SocketCAN interface (e.g. vcan0) at 1x..100x
+
+.ctr capture file: 8-byte header b'CTRC' + u16 version + u16 reserved, then
+fixed 24-byte little-endian records, ordered by time:
+  u64 time_us, u32 can_id, u8 flags, u8 dlc, u16 node, u8 data[8]
+flags: bit0 remote frame, bit1 transmitted by the node, bit2 extended ID.
+Fixed-size records make a time window a binary search instead of a scan.
+
+Usage:
+  can_trace.py capture /dev/ttyACM0 -b 2000000 -o node1.ctr
+  can_trace.py index node1.ctr
+  can_trace.py export node1.ctr -f candump -o node1.log
+  can_trace.py latency node1.ctr --id 651
+  can_trace.py replay node1.ctr -i vcan0 --speed 10
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import os
+import re
+import select
+import socket
+import struct
+import sys
+import termios
+import time
+import tty
+
+MAGIC = b'CTRC'
+VERSION = 1
+HEADER = struct.Struct('<4sHH')
+RECORD = struct.Struct('<QIBBH8s')
+
+FLAG_RTR = 0x01
+FLAG_TX = 0x02
+FLAG_EXT = 0x04
+
+# "@<tick_ms> <R|T> <id> <D|R> <dlc> [bytes]"
+RE_TRACE = re.compile(rb'^@(\d+) ([RT]) ([0-9A-Fa-f]{1,8}) ([DR]) ([0-8])((?: [0-9A-Fa-f]{2}){0,8})\s*$')
+
+# uart_link.h
+LINK_TYPE_CAN = 0x01
+LINK_TYPE_TEXT = 0x02
+LINK_TYPE_CMD = 0x10
+LINK_TYPE_REPLY = 0x11
+LINK_CAN_EXT = 0x80000000
+LINK_CAN_RTR = 0x40000000
+LINK_CAN_TX = 0x20000000
+LINK_CAN_HEAD = struct.Struct('<IIB')
+
+CAN_EFF_FLAG = 0x80000000
+CAN_RTR_FLAG = 0x40000000
+CAN_FRAME = struct.Struct('=IB3x8s')
+
+BAUDS = {9600: termios.B9600, 19200: termios.B19200, 38400: termios.B38400,
+         57600: termios.B57600, 115200: termios.B115200, 230400: termios.B230400,
+         460800: termios.B460800, 921600: termios.B921600}
+for _rate in (1000000, 1500000, 2000000, 2500000, 3000000, 3500000, 4000000):
+    if hasattr(termios, 'B%d' % _rate):
+        BAUDS[_rate] = getattr(termios, 'B%d' % _rate)
+
+
+class Record:
+    __slots__ = ('time_us', 'can_id', 'flags', 'dlc', 'node', 'data')
+
+    def __init__(self, time_us, can_id, flags, dlc, node, data):
+        self.time_us = time_us
+        self.can_id = can_id
+        self.flags = flags
+        self.dlc = dlc
+        self.node = node
+        self.data = data
+
+    def pack(self):
+        return RECORD.pack(self.time_us, self.can_id, self.flags, self.dlc, self.node,
+                           self.data.ljust(8, b'\0'))
+
+    @classmethod
+    def unpack(cls, raw):
+        time_us, can_id, flags, dlc, node, data = RECORD.unpack(raw)
+        n = 0 if flags & FLAG_RTR else dlc
+        return cls(time_us, can_id, flags, dlc, node, data[:n])
+
+
+# ---------------------------------------------------------------- capture
+
+class TickUnwrapper:
+    """Extend a wrapping 32-bit node timestamp into a monotonic 64-bit time (us)."""
+
+    def __init__(self, us_per_tick):
+        self.us_per_tick = us_per_tick
+        self.last = None
+        self.high = 0
+
+    def __call__(self, tick):
+        if self.last is not None and tick < self.last:
+            self.high += 1 << 32
+        self.last = tick
+        return (self.high + tick) * self.us_per_tick
+
+
+def crc16_ccitt(data):
+    """CRC-16/CCITT-FALSE, same as UART_Link_Crc16()."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+        if not b or code == 0xFF:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+    out[code_at] = code
+    return bytes(out) + b'\0'
+
+
+def link_encode(kind, payload):
+    """One uart_link packet on the wire, same as Link_Encode()."""
+    packet = bytes([kind]) + payload
+    return cobs_encode(packet + struct.pack('<H', crc16_ccitt(packet)))
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+class CobsDecoder:
+    """uart_link packets -> Records; TEXT packets are passed through."""
+
+    def __init__(self, node):
+        self.node = node
+        self.buf = b''
+        self.clock = TickUnwrapper(1)
+        self.text = b''
+        self.bad = 0
+
+    def feed(self, chunk, records, text):
+        self.buf += chunk
+        blocks = self.buf.split(b'\0')
+        self.buf = blocks.pop()
+        for block in blocks:
+            packet = cobs_decode(block) if block else None
+            if packet is None or len(packet) < 3 \
+                    or crc16_ccitt(packet[:-2]) != packet[-2] | (packet[-1] << 8):
+                self.bad += 1
+                continue
+            kind, body = packet[0], packet[1:-2]
+            if kind == LINK_TYPE_CAN and len(body) >= LINK_CAN_HEAD.size:
+                time_us, ident, dlc = LINK_CAN_HEAD.unpack_from(body)
+                flags = (FLAG_EXT if ident & LINK_CAN_EXT else 0) \
+                    | (FLAG_RTR if ident & LINK_CAN_RTR else 0) \
+                    | (FLAG_TX if ident & LINK_CAN_TX else 0)
+                records.append(Record(self.clock(time_us), ident & 0x1FFFFFFF, flags, dlc,
+                                      self.node, body[LINK_CAN_HEAD.size:]))
+            elif kind == LINK_TYPE_TEXT:
+                lines = (self.text + body).split(b'\n')
+                self.text = lines.pop()
+                text.extend(line.rstrip(b'\r') for line in lines if line.strip())
+            else:
+                self.bad += 1
+
+
+class LineDecoder:
+    """Text trace lines -> Records. Free-form debug lines are passed through."""
+
+    def __init__(self, node):
+        self.node = node
+        self.buf = b''
+        self.clock = TickUnwrapper(1000)
+        self.bad = 0
+
+    def feed(self, chunk, records, text):
+        self.buf += chunk
+        lines = self.buf.split(b'\n')
+        self.buf = lines.pop()
+        for line in lines:
+            m = RE_TRACE.match(line)
+            if m is None:
+                line = line.rstrip(b'\r')
+                if line:
+                    text.append(line)
+                continue
+            can_id = int(m.group(3), 16)
+            flags = (FLAG_TX if m.group(2) == b'T' else 0) \
+                | (FLAG_RTR if m.group(4) == b'R' else 0) \
+                | (FLAG_EXT if can_id > 0x7FF else 0)
+            records.append(Record(self.clock(int(m.group(1))), can_id, flags,
+                                  int(m.group(5)), self.node, bytes.fromhex(m.group(6).decode())))
+
+
+def open_source(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd)
+        if baud:
+            if baud not in BAUDS:
+                sys.exit('unsupported baud rate %d' % baud)
+            attr = termios.tcgetattr(fd)
+            attr[4] = attr[5] = BAUDS[baud]
+            termios.tcsetattr(fd, termios.TCSANOW, attr)
+        termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+def cmd_capture(args):
+    fd = open_source(args.source, args.baud)
+    live = os.isatty(fd) or not os.path.isfile(args.source)
+    decoder = (CobsDecoder if args.protocol == 'cobs' else LineDecoder)(args.node)
+    text_out = open(args.text, 'ab') if args.text else None
+    count = 0
+    deadline = time.monotonic() + args.duration if args.duration else None
+
+    with open(args.output, 'wb') as out:
+        out.write(HEADER.pack(MAGIC, VERSION, 0))
+        try:
+            while deadline is None or time.monotonic() < deadline:
+                if live:
+                    ready, _, _ = select.select([fd], [], [], 0.2)
+                    if not ready:
+                        continue
+                chunk = os.read(fd, 65536)
+                if not chunk:
+                    if live:
+                        continue
+                    break
+                records, text = [], []
+                decoder.feed(chunk, records, text)
+                if records:
+                    out.write(b''.join(r.pack() for r in records))
+                    count += len(records)
+                if text_out and text:
+                    text_out.write(b'\n'.join(text) + b'\n')
+        except KeyboardInterrupt:
+            pass
+    os.close(fd)
+    if text_out:
+        text_out.close()
+    print('%d frames -> %s, %d bad packets' % (count, args.output, decoder.bad), file=sys.stderr)
+    return 0
+
+
+# ---------------------------------------------------------------- reading
+
+class Capture:
+    def __init__(self, path):
+        self.f = open(path, 'rb')
+        magic, version, _ = HEADER.unpack(self.f.read(HEADER.size))
+        if magic != MAGIC or version != VERSION:
+            sys.exit('%s: not a v%d capture' % (path, VERSION))
+        self.f.seek(0, os.SEEK_END)
+        self.count = (self.f.tell() - HEADER.size) // RECORD.size
+
+    def time_at(self, i):
+        self.f.seek(HEADER.size + i * RECORD.size)
+        return struct.unpack('<Q', self.f.read(8))[0]
+
+    def lower_bound(self, time_us):
+        lo, hi = 0, self.count
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self.time_at(mid) < time_us:
+                lo = mid + 1
+            else:
+                hi = mid
+        return lo
+
+    def records(self, t_from=None, t_to=None, ids=None):
+        start = self.lower_bound(int(t_from * 1e6)) if t_from is not None else 0
+        self.f.seek(HEADER.size + start * RECORD.size)
+        while True:
+            block = self.f.read(RECORD.size * 4096)
+            if not block:
+                return
+            for off in range(0, len(block) - RECORD.size + 1, RECORD.size):
+                rec = Record.unpack(block[off:off + RECORD.size])
+                if t_to is not None and rec.time_us > t_to * 1e6:
+                    return
+                if ids is None or rec.can_id in ids:
+                    yield rec
+
+
+def parse_ids(text):
+    return {int(x, 16) for x in text.split(',')} if text else None
+
+
+def cmd_index(args):
+    cap = Capture(args.capture)
+    table = {}
+    for rec in cap.records():
+        key = (rec.can_id, bool(rec.flags & FLAG_RTR), bool(rec.flags & FLAG_TX))
+        ent = table.setdefault(key, [0, rec.time_us, rec.time_us])
+        ent[0] += 1
+        ent[2] = rec.time_us
+    print('%-9s %-4s %-3s %9s %12s %12s %12s' % ('ID', 'TYPE', 'DIR', 'COUNT', 'FIRST[s]', 'LAST[s]',
+                                                 'PERIOD[ms]'))
+    for (can_id, rtr, tx), (n, first, last) in sorted(table.items()):
+        period = '%.3f' % ((last - first) / 1000.0 / (n - 1)) if n > 1 else '-'
+        print('%-9X %-4s %-3s %9d %12.3f %12.3f %12s' % (can_id, 'RTR' if rtr else 'DATA',
+                                                         'TX' if tx else 'RX', n, first / 1e6,
+                                                         last / 1e6, period))
+    print('%d records' % cap.count)
+    return 0
+
+
+def cmd_dump(args):
+    cap = Capture(args.capture)
+    for rec in cap.records(args.t_from, args.t_to, parse_ids(args.id)):
+        payload = ('R%d' % rec.dlc) if rec.flags & FLAG_RTR else rec.data.hex(' ').upper()
+        print('%12.3f %s %8X [%d] %s' % (rec.time_us / 1e6, 'T' if rec.flags & FLAG_TX else 'R',
+                                         rec.can_id, rec.dlc, payload))
+    return 0
+
+
+# ---------------------------------------------------------------- export
+
+def cmd_latency(args):
+    cap = Capture(args.capture)
+    pending, samples, unanswered = {}, [], 0
+    for rec in cap.records(args.t_from, args.t_to, parse_ids(args.id)):
+        if rec.flags & FLAG_TX and rec.flags & FLAG_RTR:
+            if rec.can_id in pending:
+                unanswered += 1
+            pending[rec.can_id] = rec.time_us
+        elif not rec.flags & (FLAG_TX | FLAG_RTR) and rec.can_id in pending:
+            samples.append(rec.time_us - pending.pop(rec.can_id))
+    unanswered += len(pending)
+    if not samples:
+        print('no request/reply pairs, %d unanswered' % unanswered)
+        return 1
+    samples.sort()
+    print('%d replies, %d unanswered' % (len(samples), unanswered))
+    print('  min %d us, median %d us, p99 %d us, max %d us, mean %.1f us'
+          % (samples[0], samples[len(samples) // 2], samples[(len(samples) * 99) // 100],
+             samples[-1], sum(samples) / len(samples)))
+    return 0
+
+
+def candump_line(rec, iface, base):
+    ident = ('%08X' if rec.flags & FLAG_EXT else '%03X') % rec.can_id
+    payload = ('R%d' % rec.dlc) if rec.flags & FLAG_RTR else rec.data.hex().upper()
+    return '(%.6f) %s %s#%s\n' % (base + rec.time_us / 1e6, iface, ident, payload)
+
+
+def asc_line(rec, channel):
+    ident = ('%Xx' if rec.flags & FLAG_EXT else '%X') % rec.can_id
+    direction = 'Tx' if rec.flags & FLAG_TX else 'Rx'
+    if rec.flags & FLAG_RTR:
+        body = 'r'
+    else:
+        body = 'd %d %s' % (rec.dlc, ' '.join('%02X' % b for b in rec.data))
+    return '%11.6f %d  %-15s %s   %s\n' % (rec.time_us / 1e6, channel, ident, direction, body.rstrip())
+
+
+def cmd_export(args):
+    cap = Capture(args.capture)
+    out = open(args.output, 'w') if args.output else sys.stdout
+    if args.format == 'asc':
+        out.write('date %s\n' % time.strftime('%a %b %d %I:%M:%S %p %Y'))
+        out.write('base hex  timestamps absolute\n')
+        out.write('no internal events logged\n')
+    for rec in cap.records(args.t_from, args.t_to, parse_ids(args.id)):
+        if args.format == 'asc':
+            out.write(asc_line(rec, args.channel))
+        else:
+            out.write(candump_line(rec, args.interface, args.base))
+    if args.format == 'asc':
+        out.write('End TriggerBlock\n')
+    if out is not sys.stdout:
+        out.close()
+    return 0
+
+
+# ---------------------------------------------------------------- replay
+
+def cmd_replay(args):
+    if not 1.0 <= args.speed <= 100.0:
+        sys.exit('--speed must be within 1..100')
+    cap = Capture(args.capture)
+    sock = socket.socket(socket.AF_CAN, socket.SOCK_RAW, socket.CAN_RAW)
+    sock.bind((args.interface,))
+
+    t0_wall = None
+    t0_rec = 0
+    sent = 0
+    for rec in cap.records(args.t_from, args.t_to, parse_ids(args.id)):
+        if args.rx_only and rec.flags & FLAG_TX:
+            continue
+        if t0_wall is None:
+            t0_wall, t0_rec = time.monotonic(), rec.time_us
+        delay = t0_wall + (rec.time_us - t0_rec) / 1e6 / args.speed - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        can_id = rec.can_id | (CAN_EFF_FLAG if rec.flags & FLAG_EXT else 0) \
+            | (CAN_RTR_FLAG if rec.flags & FLAG_RTR else 0)
+        sock.send(CAN_FRAME.pack(can_id, rec.dlc, rec.data.ljust(8, b'\0')))
+        sent += 1
+    print('%d frames replayed on %s' % (sent, args.interface), file=sys.stderr)
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description='CAN trace capture / export / replay')
+    sub = ap.add_subparsers(dest='cmd', required=True)
+
+    p = sub.add_parser('capture', help='record a node trace stream')
+    p.add_argument('source', help='trace file, pty or tty (e.g. /dev/ttyACM0)')
+    p.add_argument('-o', '--output', required=True, help='.ctr capture to write')
+    p.add_argument('-b', '--baud', type=int, default=2000000, help='tty baud rate')
+    p.add_argument('-p', '--protocol', choices=('cobs', 'text'), default='cobs',
+                   help='uart_link packets (default) or "@tick" text lines')
+    p.add_argument('-n', '--node', type=int, default=0, help='node number stored in each record')
+    p.add_argument('-t', '--text', help='append free-form debug lines to this file')
+    p.add_argument('-d', '--duration', type=float, help='stop after this many seconds')
+    p.set_defaults(func=cmd_capture)
+
+    def add_window(p):
+        p.add_argument('capture')
+        p.add_argument('--id', help='comma separated hex IDs')
+        p.add_argument('--from', dest='t_from', type=float, help='start time [s]')
+        p.add_argument('--to', dest='t_to', type=float, help='end time [s]')
+
+    p = sub.add_parser('index', help='per-ID summary')
+    p.add_argument('capture')
+    p.set_defaults(func=cmd_index)
+
+    p = sub.add_parser('dump', help='print records')
+    add_window(p)
+    p.set_defaults(func=cmd_dump)
+
+    p = sub.add_parser('export', help='write candump / ASC log')
+    add_window(p)
+    p.add_argument('-f', '--format', choices=('candump', 'asc'), default='candump')
+    p.add_argument('-o', '--output')
+    p.add_argument('-i', '--interface', default='can0', help='candump interface name')
+    p.add_argument('-c', '--channel', type=int, default=1, help='ASC channel number')
+    p.add_argument('--base', type=float, default=0.0, help='candump epoch offset [s]')
+    p.set_defaults(func=cmd_export)
+
+    p = sub.add_parser('latency', help='remote request -> reply time')
+    add_window(p)
+    p.set_defaults(func=cmd_latency)
+
+    p = sub.add_parser('replay', help='send a capture onto SocketCAN')
+    add_window(p)
+    p.add_argument('-i', '--interface', default='vcan0')
+    p.add_argument('-s', '--speed', type=float, default=1.0, help='1..100x')
+    p.add_argument('--rx-only', action='store_true', help='skip frames the node transmitted')
+    p.set_defaults(func=cmd_replay)
+
+    args = ap.parse_args()
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""
+check_points.py
+
+Host check of the node1 operating-point table (CLOCK_SCALE_POINTS in
+Core/Inc/clock_scale.h) against the STM32L476 limits:
+
+  PLL      HSE / PLLM in 4..16 MHz, PLLN 8..86, PLLR 2/4/6/8,
+           VCO 64..344 MHz (range 1) or 64..128 MHz (range 2)
+  SYSCLK   <= 80 MHz in range 1, <= 26 MHz in range 2
+  flash    exactly the minimum wait states for SYSCLK in that range: fewer
+           misreads flash, more costs a cycle per miss for nothing
+  CAN      exactly the bus bitrate, BRP 1..1024, BS1 1..16, BS2 1..8,
+           8..25 time quanta, sample point 75..90 %
+  USART2   UART_LINK_BAUD within 1 % with 16x or 8x oversampling
+  TIM6     exactly CLOCK_SCALE_TIM_HZ from a 16-bit prescaler
+
+It also checks that the table is ordered and that its last point is the one
+SystemClock_Config(), CAN1_Init() and TIMER6_Init() in main.c boot with.
+Exit status is 1 on any violation.
+
+--search lists every PLL/bit-timing combination that passes, as candidate
+rows for the table.
+
+Usage:
+  check_points.py
+  check_points.py --search --range 2
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import os
+import re
+import sys
+
+NODE1 = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..',
+                     'node1-nucleo-l476rg', 'CAN_NormalMode-l476', 'Core')
+
+PLLM = 1
+FIELDS = ('sysclk_hz', 'range', 'flash_ws', 'pll_n', 'pll_r',
+          'can_brp', 'can_bs1', 'can_bs2', 'tim_psc', 'max_fps')
+
+SYSCLK_MAX = {1: 80000000, 2: 26000000}
+VCO_MAX = {1: 344000000, 2: 128000000}
+VCO_MIN = 64000000
+# highest HCLK per wait-state count (RM0351, flash read access latency; the
+# same steps as RCC_SetFlashLatencyFromMSIRange() in the L4 HAL for range 2)
+FLASH_WS = {1: (16000000, 32000000, 48000000, 64000000, 80000000),
+            2: (6000000, 12000000, 18000000, 26000000)}
+SAMPLE_MIN = 75.0
+SAMPLE_MAX = 90.0
+UART_ERR_MAX = 1.0
+
+
+def read(name):
+    with open(os.path.join(NODE1, name)) as f:
+        return f.read()
+
+
+def define(text, name):
+    m = re.search(r'#define\s+%s\s+\(?(\d+)U?' % name, text)
+    if not m:
+        sys.exit('%s not found' % name)
+    return int(m.group(1))
+
+
+def parse_points(text):
+    m = re.search(r'#define\s+CLOCK_SCALE_POINTS\s*\\\s*\{(.*?)\}\s*\\?\s*\n\s*#define', text, re.S)
+    if not m:
+        sys.exit('CLOCK_SCALE_POINTS not found')
+    rows = []
+    for row in re.findall(r'\{([^{}]*)\}', m.group(1)):
+        values = [int(v.strip().rstrip('U')) for v in row.split(',') if v.strip()]
+        if len(values) != len(FIELDS):
+            sys.exit('bad row: {%s}' % row)
+        rows.append(dict(zip(FIELDS, values)))
+    return rows
+
+
+def min_ws(sysclk, rng):
+    for ws, top in enumerate(FLASH_WS[rng]):
+        if sysclk <= top:
+            return ws
+    return None
+
+
+def uart(pclk, baud):
+    """Oversampling, achieved baud and error in % as HAL_UART_Init would set them"""
+    if pclk >= 16 * baud:
+        div = (pclk + baud // 2) // baud
+        actual = pclk / div
+        over = 16
+    elif pclk >= 8 * baud:
+        div = (2 * pclk + baud // 2) // baud
+        actual = 2 * pclk / div
+        over = 8
+    else:
+        return None, 0.0, 100.0
+    return over, actual, abs(actual - baud) * 100.0 / baud
+
+
+def check(p, hse, bitrate, baud, tim_hz):
+    errors = []
+    rng = p['range']
+    if rng not in SYSCLK_MAX:
+        return ['range must be 1 or 2']
+
+    vco = hse // PLLM * p['pll_n']
+    if not 8 <= p['pll_n'] <= 86:
+        errors.append('PLLN %d outside 8..86' % p['pll_n'])
+    if p['pll_r'] not in (2, 4, 6, 8):
+        errors.append('PLLR %d not 2/4/6/8' % p['pll_r'])
+    if not VCO_MIN <= vco <= VCO_MAX[rng]:
+        errors.append('VCO %.1f MHz outside range %d limits' % (vco / 1e6, rng))
+    if vco // p['pll_r'] != p['sysclk_hz'] or vco % p['pll_r']:
+        errors.append('PLL gives %.3f MHz, table says %.3f MHz' % (vco / p['pll_r'] / 1e6, p['sysclk_hz'] / 1e6))
+    sysclk = p['sysclk_hz']
+    if sysclk > SYSCLK_MAX[rng]:
+        errors.append('SYSCLK above %d MHz for range %d' % (SYSCLK_MAX[rng] // 1000000, rng))
+    ws = min_ws(sysclk, rng)
+    if ws is None or p['flash_ws'] < ws:
+        errors.append('flash needs %s wait states' % ws)
+    elif p['flash_ws'] > ws:
+        errors.append('%d flash wait states, %d is enough' % (p['flash_ws'], ws))
+
+    tq = 1 + p['can_bs1'] + p['can_bs2']
+    if not 1 <= p['can_brp'] <= 1024 or not 1 <= p['can_bs1'] <= 16 or not 1 <= p['can_bs2'] <= 8:
+        errors.append('CAN BRP/BS1/BS2 out of range')
+    if not 8 <= tq <= 25:
+        errors.append('%d time quanta per bit' % tq)
+    if sysclk % (p['can_brp'] * tq) or sysclk // (p['can_brp'] * tq) != bitrate:
+        errors.append('CAN bitrate %.1f bit/s' % (sysclk / (p['can_brp'] * tq)))
+    sample = (1 + p['can_bs1']) * 100.0 / tq
+    if not SAMPLE_MIN <= sample <= SAMPLE_MAX:
+        errors.append('sample point %.1f %%' % sample)
+
+    over, _, err = uart(sysclk, baud)
+    if over is None or err > UART_ERR_MAX:
+        errors.append('USART2 %d baud error %.2f %%' % (baud, err))
+
+    if p['tim_psc'] > 0xFFFF or sysclk % (p['tim_psc'] + 1) or sysclk // (p['tim_psc'] + 1) != tim_hz:
+        errors.append('TIM6 %.1f Hz' % (sysclk / (p['tim_psc'] + 1)))
+    return errors
+
+
+def boot_point(main_c):
+    """The point main.c configures before Clock_Scale_Init()"""
+    def field(pattern):
+        m = re.search(pattern, main_c)
+        if not m:
+            sys.exit('main.c: %s not found' % pattern)
+        return int(m.group(1))
+    return {
+        'pll_n': field(r'PLL\.PLLN\s*=\s*(\d+)'),
+        'pll_r': field(r'PLL\.PLLR\s*=\s*RCC_PLLR_DIV(\d+)'),
+        'can_brp': field(r'hcan1\.Init\.Prescaler\s*=\s*(\d+)'),
+        'can_bs1': field(r'hcan1\.Init\.TimeSeg1\s*=\s*CAN_BS1_(\d+)TQ'),
+        'can_bs2': field(r'hcan1\.Init\.TimeSeg2\s*=\s*CAN_BS2_(\d+)TQ'),
+        'tim_psc': field(r'htimer6\.Init\.Prescaler\s*=\s*(\d+)'),
+    }
+
+
+def search(hse, bitrate, baud, tim_hz, rng):
+    rows = {}
+    for pll_n in range(8, 87):
+        for pll_r in (2, 4, 6, 8):
+            vco = hse // PLLM * pll_n
+            if vco % pll_r:
+                continue
+            sysclk = vco // pll_r
+            if sysclk in rows or sysclk % tim_hz:
+                continue
+            for tq in range(25, 7, -1):
+                if sysclk % (bitrate * tq):
+                    continue
+                brp = sysclk // (bitrate * tq)
+                bs2 = max(1, round(tq * (100.0 - 87.5) / 100.0))
+                p = {'sysclk_hz': sysclk, 'range': rng, 'flash_ws': min_ws(sysclk, rng) or 0,
+                     'pll_n': pll_n, 'pll_r': pll_r, 'can_brp': brp, 'can_bs1': tq - 1 - bs2,
+                     'can_bs2': bs2, 'tim_psc': sysclk // tim_hz - 1, 'max_fps': 0}
+                if not check(p, hse, bitrate, baud, tim_hz):
+                    rows[sysclk] = '%9d  %5d %2d  %5d %5d  %3d %3d %3d  %7d  %5.1f %%' % (
+                        sysclk, rng, p['flash_ws'], pll_n, pll_r, brp, p['can_bs1'], bs2,
+                        p['tim_psc'], (1 + p['can_bs1']) * 100.0 / tq)
+                    break
+    print('sysclk_hz  range ws  pll_n pll_r  brp bs1 bs2  tim_psc  sample')
+    for sysclk in sorted(rows):
+        print(rows[sysclk])
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Check the L476 operating-point table')
+    ap.add_argument('--search', action='store_true', help='list valid PLL/bit-timing combinations')
+    ap.add_argument('--range', type=int, default=2, choices=(1, 2), help='regulator range for --search')
+    args = ap.parse_args()
+
+    header = read(os.path.join('Inc', 'clock_scale.h'))
+    hse = define(header, 'CLOCK_SCALE_HSE_HZ')
+    tim_hz = define(header, 'CLOCK_SCALE_TIM_HZ')
+    bitrate = define(read(os.path.join('Inc', 'poll.h')), 'POLL_BITRATE')
+    baud = define(read(os.path.join('Inc', 'uart_link.h')), 'UART_LINK_BAUD')
+
+    if args.search:
+        search(hse, bitrate, baud, tim_hz, args.range)
+        return 0
+
+    points = parse_points(header)
+    failed = False
+    if len(points) != define(header, 'CLOCK_SCALE_POINT_COUNT'):
+        print('CLOCK_SCALE_POINT_COUNT does not match the table')
+        failed = True
+
+    for i, p in enumerate(points):
+        errors = check(p, hse, bitrate, baud, tim_hz)
+        if i > 0 and (p['sysclk_hz'] <= points[i - 1]['sysclk_hz'] or
+                      (p['max_fps'] != 0 and p['max_fps'] <= points[i - 1]['max_fps'])):
+            errors.append('not above the previous point')
+        if i == len(points) - 1 and p['max_fps'] != 0:
+            errors.append('the last point must have max_fps 0')
+        over, actual, err = uart(p['sysclk_hz'], baud)
+        print('%5.1f MHz  range %d  %d WS  CAN %d x %d tq  UART %dx %.0f baud (%.2f %%)  %s' % (
+            p['sysclk_hz'] / 1e6, p['range'], p['flash_ws'], p['can_brp'],
+            1 + p['can_bs1'] + p['can_bs2'], over or 0, actual, err,
+            'ok' if not errors else '; '.join(errors)))
+        failed |= bool(errors)
+
+    boot = boot_point(read(os.path.join('Src', 'main.c')))
+    last = points[-1]
+    diff = [k for k in boot if boot[k] != last[k]]
+    if diff:
+        print('last point differs from main.c in %s' % ', '.join(diff))
+        failed = True
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""
+check_link.py
+
+Host test of the debug link codec (Core/Src/link_codec.c), the command
+console (Core/Src/console.c) and the frame trace (Core/Src/trace.c). Builds
+link_test.c with the host C compiler against stub/main.h, once per node, and
+runs it:
+
+  crc         CRC-16/CCITT-FALSE check value
+  cobs        encode of long zero-free runs, all zeros and random data
+  round trip  every payload length through Link_Encode() / Link_Rx_Feed()
+  reject      single-bit errors, truncated, overlong and malformed frames,
+              resync on the next delimiter
+  console     every command decoded from the wire: reply per command, unknown
+              opcodes, length and range errors, HAL failures, GET_STATS layout
+  trace       Trace_CAN_Frame() packet layout and verbosity levels; the wire
+              bytes are then decoded by tools/can_trace/can_trace.py and must
+              give back the same records, across the 2^32 us wrap
+
+The node's headers are copied next to the stub, all but main.h, so that the
+opcodes, status codes and packet types are the firmware's own.
+Exit status is 1 if a build or any check fails.
+
+Usage:
+  check_link.py
+  check_link.py --node 2 --cc clang
+
+Created on: Oct 18, 2026
+Author: Barış Can Coşkun
+"""
+
+import argparse
+import glob
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, '..', 'can_trace'))
+import can_trace  # noqa: E402
+
+NODES = {
+    1: os.path.join(HERE, '..', '..', 'node1-nucleo-l476rg', 'CAN_NormalMode-l476', 'Core'),
+    2: os.path.join(HERE, '..', '..', 'node2-stm32f4disc', 'CAN_NormalMode-f407', 'Core'),
+}
+SOURCES = ('link_codec.c', 'console.c', 'trace.c')
+
+
+def check_trace(wire, want):
+    """Decode the firmware's trace packets with can_trace.py; the failure count."""
+    records, text = [], []
+    decoder = can_trace.CobsDecoder(0)
+    with open(wire, 'rb') as f:
+        decoder.feed(f.read(), records, text)
+    with open(want) as f:
+        expected = [line.split() for line in f]
+
+    failures = 0
+    if decoder.bad or text or len(records) != len(expected):
+        print('trace: %d records, %d expected, %d bad packets' % (len(records), len(expected), decoder.bad))
+        return 1
+    for rec, fields in zip(records, expected):
+        got = [rec.time_us, rec.can_id, rec.flags, rec.dlc, rec.data.hex()]
+        if got != [int(v) for v in fields[:4]] + [fields[4] if len(fields) > 4 else '']:
+            print('trace: decoded %s, want %s' % (got, fields))
+            failures += 1
+    return failures
+
+
+def run(node, cc):
+    core = NODES[node]
+    with tempfile.TemporaryDirectory() as tmp:
+        for header in glob.glob(os.path.join(core, 'Inc', '*.h')):
+            if os.path.basename(header) != 'main.h':
+                shutil.copy(header, tmp)
+        shutil.copy(os.path.join(HERE, 'stub', 'main.h'), tmp)
+        for name in SOURCES:
+            shutil.copy(os.path.join(core, 'Src', name), tmp)
+        exe = os.path.join(tmp, 'link_test')
+        cmd = [cc, '-std=gnu11', '-Wall', '-Wextra', '-Wno-unused-parameter', '-Werror', '-I', tmp, '-o', exe,
+               os.path.join(HERE, 'link_test.c')] + [os.path.join(tmp, name) for name in SOURCES]
+        if subprocess.call(cmd) != 0:
+            print('node%d: build failed' % node)
+            return 1
+        wire = os.path.join(tmp, 'trace.bin')
+        print('node%d: ' % node, end='', flush=True)
+        rc = subprocess.call([exe, wire])
+        if rc < 0:
+            print('test killed by signal %d' % -rc)
+        if rc != 0:
+            return 1
+        return 1 if check_trace(wire, wire + '.want') else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Build and run the link codec / console / trace host test')
+    ap.add_argument('--node', type=int, choices=sorted(NODES), help='one node only (default: both)')
+    ap.add_argument('--cc', default=os.environ.get('CC', 'cc'), help='host C compiler')
+    args = ap.parse_args()
+
+    failed = 0
+    for node in ([args.node] if args.node else sorted(NODES)):
+        failed |= run(node, args.cc)
+    return failed
+
+
+if __name__ == '__main__':
+    sys.exit(main())
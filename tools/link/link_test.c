@@ -0,0 +1,634 @@
+/*
+ * link_test.c
+ *
+ * Host test of the debug link codec (link_codec.c), the command console
+ * (console.c) and the frame trace (trace.c), built by check_link.py against
+ * stub/main.h. Commands go the whole way: Link_Encode() -> Link_Rx_Feed() ->
+ * Console_Poll(), and every reply is encoded and decoded again the same way.
+ * With a file argument the trace packets are also written there as wire
+ * bytes, for check_link.py to decode with tools/can_trace/can_trace.py.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "link_codec.h"
+#include "console.h"
+#include "can_catalog.h"
+#include "can_diag.h"
+#include "can_if.h"
+#include "it.h"
+#include "log.h"
+#include "publish.h"
+#include "trace.h"
+#include "uart_link.h"
+
+static int failures;
+
+#define CHECK(cond, ...) \
+	do { if(!(cond)) { failures++; printf("FAIL %s:%d: ", __func__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+static uint32_t rng_state = 2026U;
+
+static uint8_t rng(void)
+{
+	rng_state = rng_state * 1103515245U + 12345U;
+	return (uint8_t)(rng_state >> 16);
+}
+
+/* ---------------- Firmware state console.c reads and writes ---------------- */
+
+volatile uint32_t uwTick;
+RCC_TypeDef stub_rcc;
+SysTick_Type stub_systick;
+DWT_Type stub_dwt;
+CoreDebug_Type stub_core_debug;
+
+static TIM_TypeDef tim6_regs;
+static CAN_TypeDef can1_regs;
+TIM_HandleTypeDef htimer6 = { &tim6_regs, { 0, 0 } };
+CAN_HandleTypeDef hcan1 = { &can1_regs, { 0, 0, 0, 0 }, 0 };
+
+volatile CAN_Diag_Counters_t can_diag;
+volatile Frame_Pool_Stats_t frame_pool_stats;
+volatile UART_Link_Stats_t uart_link_stats;
+volatile Log_Stats_t log_stats;
+volatile CAN_IF_Rx_Stats_t can_rx_stats;
+volatile Cycle_Stats_t can_isr_cycles[CAN_ISR_COUNT];
+volatile Publish_Stats_t publish_stats[PUBLISH_SIGNAL_COUNT];
+
+static uint32_t pclk1_hz;
+static HAL_StatusTypeDef can_init_status;
+static uint32_t can_restarts;
+static uint32_t filter_calls;
+static uint16_t filter_entries[CONSOLE_FILTERS_MAX];
+static uint32_t filter_count;
+static uint32_t log_calls;
+static uint8_t log_module;
+static uint8_t log_level;
+
+uint32_t HAL_GetTick(void)
+{
+	return uwTick;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+	return pclk1_hz;
+}
+
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef *hcan)
+{
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Init(CAN_HandleTypeDef *hcan)
+{
+	return can_init_status;
+}
+
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan)
+{
+	can_restarts++;
+	return HAL_OK;
+}
+
+void CAN_IF_Config_List_Filters(CAN_HandleTypeDef *hcan, const uint16_t entries[], uint32_t count)
+{
+	filter_calls++;
+	filter_count = count;
+	memcpy(filter_entries, entries, count * sizeof(entries[0]));
+}
+
+void Log_Set_Level(uint8_t module, uint8_t level)
+{
+	log_calls++;
+	log_module = module;
+	log_level = level;
+}
+
+/* ---------------- Link stand-in: one command in, replies out ---------------- */
+
+static Link_Rx_t cmd_rx;
+static uint8_t cmd_ready;
+static uint32_t replies;
+static uint8_t reply[LINK_PACKET_MAX];
+static uint32_t reply_len;
+static FILE *trace_wire;
+static FILE *trace_want;
+
+const uint8_t *UART_Link_Receive(uint32_t *len)
+{
+	if(!cmd_ready)
+	{
+		return NULL;
+	}
+	cmd_ready = FALSE;
+	*len = cmd_rx.len;
+	return cmd_rx.packet;
+}
+
+uint8_t UART_Link_Send(uint8_t type, const uint8_t *payload, uint32_t len)
+{
+	static Link_Rx_t rx;
+	uint8_t wire[LINK_WIRE_MAX];
+	uint32_t n = Link_Encode(wire, type, payload, len);
+	uint32_t i;
+
+	replies++;
+	CHECK(n != 0U, "reply of %u bytes does not fit a packet", len);
+	if(type == UART_LINK_TYPE_CAN && trace_wire != NULL)
+	{
+		fwrite(wire, 1, n, trace_wire);
+	}
+	Link_Rx_Reset(&rx);
+	for(i = 0; i < n; i++)
+	{
+		if(Link_Rx_Feed(&rx, wire[i]) == LINK_RX_PACKET)
+		{
+			memcpy(reply, rx.packet, rx.len);
+			reply_len = rx.len;
+		}
+	}
+	return TRUE;
+}
+
+void UART_Link_Text(const char *text)
+{
+	UART_Link_Send(UART_LINK_TYPE_TEXT, (const uint8_t *)text, (uint32_t)strlen(text));
+}
+
+/**
+  * @brief Send one packet through the codec and run the console on it
+  * @retval number of replies (0 or 1)
+  */
+static uint32_t console_run(uint8_t type, const uint8_t *cmd, uint32_t len)
+{
+	uint8_t wire[LINK_WIRE_MAX];
+	uint32_t n = Link_Encode(wire, type, cmd, len);
+	uint32_t i;
+
+	Link_Rx_Reset(&cmd_rx);
+	for(i = 0; i < n; i++)
+	{
+		cmd_ready = (Link_Rx_Feed(&cmd_rx, wire[i]) == LINK_RX_PACKET);
+	}
+	replies = 0;
+	reply_len = 0;
+	Console_Poll();
+	return replies;
+}
+
+/* The status byte of the reply to one command */
+static uint8_t console_status(const uint8_t *cmd, uint32_t len)
+{
+	if(console_run(UART_LINK_TYPE_CMD, cmd, len) != 1U || reply_len < 3U ||
+	   reply[0] != UART_LINK_TYPE_REPLY || reply[1] != cmd[0])
+	{
+		return 0xFFU;
+	}
+	return reply[2];
+}
+
+/* ---------------- Codec ---------------- */
+
+static void test_crc(void)
+{
+	CHECK(Link_Crc16((const uint8_t *)"123456789", 9) == 0x29B1U, "check value %04X",
+	      Link_Crc16((const uint8_t *)"123456789", 9));
+	CHECK(Link_Crc16(NULL, 0) == 0xFFFFU, "empty input");
+}
+
+/* Reference COBS decoder, for runs longer than a link packet */
+static uint32_t cobs_decode(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	uint32_t in = 0;
+	uint32_t out = 0;
+	uint8_t code;
+
+	while(in < len)
+	{
+		code = src[in++];
+		memcpy(&dst[out], &src[in], code - 1U);
+		out += code - 1U;
+		in += code - 1U;
+		if(code != 0xFFU && in < len)
+		{
+			dst[out++] = 0;
+		}
+	}
+	return out;
+}
+
+static void test_cobs(void)
+{
+	static const uint32_t lengths[] = { 0, 1, 253, 254, 255, 508, 600 };
+	uint8_t src[600];
+	uint8_t wire[620];
+	uint8_t back[620];
+	uint32_t n;
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
+
+	for(k = 0; k < 3U; k++)
+	{
+		for(i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+		{
+			for(j = 0; j < lengths[i]; j++)
+			{
+				src[j] = (k == 0U) ? (uint8_t)(1U + j % 255U) : (k == 1U) ? 0U : rng();
+			}
+			n = Link_Cobs_Encode(wire, src, lengths[i]);
+			CHECK(n <= lengths[i] + lengths[i] / 254U + 2U, "len %u: %u wire bytes", lengths[i], n);
+			CHECK(wire[n - 1U] == 0U && memchr(wire, 0, n - 1U) == NULL, "len %u: zero inside the frame", lengths[i]);
+			CHECK(cobs_decode(back, wire, n - 1U) == lengths[i] && memcmp(back, src, lengths[i]) == 0,
+			      "len %u pattern %u: round trip", lengths[i], k);
+		}
+	}
+}
+
+static uint8_t feed(Link_Rx_t *rx, const uint8_t *wire, uint32_t n)
+{
+	uint8_t status = LINK_RX_NONE;
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+	{
+		status = Link_Rx_Feed(rx, wire[i]);
+		if(i + 1U < n && status != LINK_RX_NONE)
+		{
+			return 0xFFU;			// ended before the delimiter
+		}
+	}
+	return status;
+}
+
+static void test_round_trip(void)
+{
+	static Link_Rx_t rx;
+	uint8_t payload[LINK_PAYLOAD_MAX + 1U];
+	uint8_t wire[LINK_WIRE_MAX];
+	uint32_t len;
+	uint32_t n;
+	uint32_t i;
+	uint32_t k;
+
+	Link_Rx_Reset(&rx);
+	for(k = 0; k < 4U; k++)
+	{
+		for(len = 0; len <= LINK_PAYLOAD_MAX; len++)
+		{
+			for(i = 0; i < len; i++)
+			{
+				payload[i] = (k == 0U) ? 0U : (k == 1U) ? 0xFFU : (k == 2U) ? (uint8_t)i : rng();
+			}
+			n = Link_Encode(wire, (uint8_t)(k + len), payload, len);
+			CHECK(n != 0U && n <= LINK_WIRE_MAX, "len %u: %u wire bytes", len, n);
+			CHECK(feed(&rx, wire, n) == LINK_RX_PACKET, "len %u pattern %u: not decoded", len, k);
+			CHECK(rx.len == len + 1U && rx.packet[0] == (uint8_t)(k + len) && memcmp(&rx.packet[1], payload, len) == 0,
+			      "len %u pattern %u: decoded differently", len, k);
+		}
+	}
+	CHECK(Link_Encode(wire, 0x01U, payload, LINK_PAYLOAD_MAX + 1U) == 0U, "oversized payload encoded");
+}
+
+static void test_reject(void)
+{
+	static Link_Rx_t rx;
+	uint8_t payload[16];
+	uint8_t wire[LINK_WIRE_MAX];
+	uint8_t bad[LINK_WIRE_MAX];
+	uint32_t n;
+	uint32_t i;
+	uint32_t bit;
+	uint8_t status;
+
+	for(i = 0; i < sizeof(payload); i++)
+	{
+		payload[i] = rng();
+	}
+	payload[3] = 0;
+	n = Link_Encode(wire, 0x10U, payload, sizeof(payload));
+
+	/* every single-bit error that keeps the framing is caught */
+	Link_Rx_Reset(&rx);
+	for(i = 0; i + 1U < n; i++)
+	{
+		for(bit = 0; bit < 8U; bit++)
+		{
+			memcpy(bad, wire, n);
+			bad[i] ^= (uint8_t)(1U << bit);
+			if(bad[i] == 0U)
+			{
+				continue;			// a new delimiter, not a bit error inside the frame
+			}
+			status = feed(&rx, bad, n);
+			CHECK(status == LINK_RX_BAD, "byte %u bit %u: status %u", i, bit, status);
+		}
+	}
+
+	/* truncated frame, then the next good one still decodes */
+	status = feed(&rx, wire, n / 2U);
+	status = Link_Rx_Feed(&rx, 0x00U);
+	CHECK(status == LINK_RX_BAD, "truncated frame: status %u", status);
+	CHECK(feed(&rx, wire, n) == LINK_RX_PACKET, "no resync after a truncated frame");
+
+	/* back-to-back delimiters are idle, not errors */
+	CHECK(Link_Rx_Feed(&rx, 0x00U) == LINK_RX_NONE && Link_Rx_Feed(&rx, 0x00U) == LINK_RX_NONE, "idle delimiters");
+
+	/* shorter than type + CRC */
+	bad[0] = 0x02U;
+	bad[1] = 0x7EU;
+	bad[2] = 0x00U;
+	CHECK(feed(&rx, bad, 3U) == LINK_RX_BAD, "one-byte packet accepted");
+
+	/* longer than LINK_WIRE_MAX without a delimiter */
+	for(i = 0; i < LINK_WIRE_MAX + 10U; i++)
+	{
+		CHECK(Link_Rx_Feed(&rx, 0x55U) == LINK_RX_NONE, "overflow byte %u", i);
+	}
+	CHECK(Link_Rx_Feed(&rx, 0x00U) == LINK_RX_BAD, "overflowed frame accepted");
+	CHECK(feed(&rx, wire, n) == LINK_RX_PACKET, "no resync after an overflow");
+
+	/* a code byte pointing past the frame */
+	bad[0] = 0x20U;
+	bad[1] = 0x01U;
+	bad[2] = 0x02U;
+	bad[3] = 0x00U;
+	CHECK(feed(&rx, bad, 4U) == LINK_RX_BAD, "code past the frame accepted");
+}
+
+/* ---------------- Console ---------------- */
+
+static void test_dispatch(void)
+{
+	uint8_t cmd[4];
+
+	cmd[0] = CONSOLE_OP_PING;
+	CHECK(console_status(cmd, 1U) == CONSOLE_OK && reply_len == 3U, "ping");
+	cmd[0] = 0x7FU;
+	CHECK(console_status(cmd, 1U) == CONSOLE_ERR_OPCODE, "unknown opcode");
+
+	CHECK(console_run(UART_LINK_TYPE_TEXT, cmd, 1U) == 0U, "non-command packet answered");
+	CHECK(console_run(UART_LINK_TYPE_CMD, cmd, 0U) == 0U, "command without opcode answered");
+}
+
+static void test_tx_period(void)
+{
+	uint8_t cmd[4] = { CONSOLE_OP_SET_TX_PERIOD };
+
+	pclk1_hz = 21000000U;
+	stub_rcc.CFGR = RCC_HCLK_DIV4;		// timers at 2 x PCLK1
+	htimer6.Init.Prescaler = 4199U;			// 10 kHz
+
+	CHECK(console_status(cmd, 2U) == CONSOLE_ERR_LENGTH, "one-byte period");
+	cmd[1] = 0;
+	cmd[2] = 0;
+	CHECK(console_status(cmd, 3U) == CONSOLE_ERR_ARG, "period 0");
+	cmd[1] = 0xE8U;
+	cmd[2] = 0x03U;							// 1000 ms
+	tim6_regs.CNT = 77U;
+	CHECK(console_status(cmd, 3U) == CONSOLE_OK && tim6_regs.ARR == 9999U && tim6_regs.CNT == 0U,
+	      "1000 ms: ARR %u", tim6_regs.ARR);
+	cmd[1] = 0x00U;
+	cmd[2] = 0x28U;							// 10240 ms: reload 102400
+	CHECK(console_status(cmd, 3U) == CONSOLE_ERR_ARG && tim6_regs.ARR == 9999U, "reload above 16 bits");
+}
+
+static void test_filters(void)
+{
+	uint8_t cmd[2U + 2U * (CONSOLE_FILTERS_MAX + 1U)] = { CONSOLE_OP_SET_FILTERS };
+
+	filter_calls = 0;
+	CHECK(console_status(cmd, 2U) == CONSOLE_ERR_LENGTH, "odd length");
+	CHECK(console_status(cmd, 1U + 2U * (CONSOLE_FILTERS_MAX + 1U)) == CONSOLE_ERR_LENGTH, "too many entries");
+	cmd[1] = 0x00U;
+	cmd[2] = 0x08U;							// bit 11: not a standard ID
+	CHECK(console_status(cmd, 3U) == CONSOLE_ERR_ARG, "extended ID bit");
+	CHECK(filter_calls == 0U, "filters written after a rejected command");
+
+	cmd[1] = 0x23U;
+	cmd[2] = 0x01U;							// 0x123 data
+	cmd[3] = 0x56U;
+	cmd[4] = 0x84U;							// 0x456 remote
+	CHECK(console_status(cmd, 5U) == CONSOLE_OK && filter_calls == 1U && filter_count == 2U &&
+	      filter_entries[0] == CAN_FILTER16(0x123U, 0U) && filter_entries[1] == CAN_FILTER16(0x456U, 1U),
+	      "two entries");
+	CHECK(console_status(cmd, 1U) == CONSOLE_OK && filter_calls == 2U && filter_count == 0U, "empty list");
+}
+
+static void test_log(void)
+{
+	uint8_t cmd[4] = { CONSOLE_OP_SET_LOG };
+
+	log_calls = 0;
+	cmd[1] = TRACE_LEVEL_FRAMES + 1U;
+	CHECK(console_status(cmd, 2U) == CONSOLE_ERR_ARG, "trace level out of range");
+	cmd[1] = TRACE_LEVEL_TEXT;
+	CHECK(console_status(cmd, 2U) == CONSOLE_OK && trace_level == TRACE_LEVEL_TEXT, "trace level");
+
+	cmd[1] = LOG_MOD_COUNT;
+	cmd[2] = LOG_LEVEL_DEBUG;
+	CHECK(console_status(cmd, 3U) == CONSOLE_ERR_ARG, "module out of range");
+	cmd[1] = 0xFFU;
+	cmd[2] = LOG_LEVEL_DEBUG + 1U;
+	CHECK(console_status(cmd, 3U) == CONSOLE_ERR_ARG, "log level out of range");
+	CHECK(log_calls == 0U, "log level set by a rejected command");
+	cmd[2] = LOG_LEVEL_DEBUG;
+	CHECK(console_status(cmd, 3U) == CONSOLE_OK && log_calls == 1U && log_module == 0xFFU &&
+	      log_level == LOG_LEVEL_DEBUG, "all modules");
+	CHECK(console_status(cmd, 1U) == CONSOLE_ERR_LENGTH && console_status(cmd, 4U) == CONSOLE_ERR_LENGTH,
+	      "log length");
+}
+
+static void test_bit_timing(void)
+{
+	static const uint8_t bad[][6] =
+	{
+		{ CONSOLE_OP_SET_BITTIMING, 0, 0, 11, 2, 1 },		// prescaler 0
+		{ CONSOLE_OP_SET_BITTIMING, 1, 4, 11, 2, 1 },		// prescaler 1025
+		{ CONSOLE_OP_SET_BITTIMING, 6, 0, 17, 2, 1 },		// bs1 17
+		{ CONSOLE_OP_SET_BITTIMING, 6, 0, 11, 0, 1 },		// bs2 0
+		{ CONSOLE_OP_SET_BITTIMING, 6, 0, 11, 9, 1 },		// bs2 9
+		{ CONSOLE_OP_SET_BITTIMING, 6, 0, 11, 2, 5 },		// sjw 5
+	};
+	uint8_t cmd[6] = { CONSOLE_OP_SET_BITTIMING, 6, 0, 11, 2, 1 };
+	uint32_t i;
+
+	can_init_status = HAL_OK;
+	can_restarts = 0;
+	CHECK(console_status(cmd, 5U) == CONSOLE_ERR_LENGTH, "four argument bytes");
+	for(i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+	{
+		CHECK(console_status(bad[i], 6U) == CONSOLE_ERR_ARG, "bad timing %u accepted", i);
+	}
+	CHECK(can_restarts == 0U, "CAN restarted by a rejected command");
+
+	CHECK(console_status(cmd, 6U) == CONSOLE_OK && can_restarts == 1U && hcan1.Init.Prescaler == 6U &&
+	      hcan1.Init.TimeSeg1 == (10U << CAN_BTR_TS1_Pos) && hcan1.Init.TimeSeg2 == (1U << CAN_BTR_TS2_Pos) &&
+	      hcan1.Init.SyncJumpWidth == 0U, "6 x (1 + 11 + 2)");
+	can_init_status = HAL_ERROR;
+	CHECK(console_status(cmd, 6U) == CONSOLE_ERR_HAL, "HAL_CAN_Init failure");
+}
+
+static void test_stats(void)
+{
+	uint8_t cmd[1] = { CONSOLE_OP_GET_STATS };
+
+	can1_regs.ESR = (0x81UL << CAN_ESR_TEC_Pos) | (0x12UL << CAN_ESR_REC_Pos);
+	can_diag.bus_off = 0x04030201U;
+	log_stats.dropped = 0xA5U;
+	CHECK(console_status(cmd, 1U) == CONSOLE_OK, "get stats");
+	CHECK(reply_len == 3U + 2U + 15U * 4U, "reply length %u", reply_len);
+	CHECK(reply[3] == 0x81U && reply[4] == 0x12U, "TEC/REC");
+	CHECK(reply[5] == 0x01U && reply[6] == 0x02U && reply[7] == 0x03U && reply[8] == 0x04U, "bus-off, little-endian");
+	CHECK(reply[3U + 2U + 13U * 4U] == 0xA5U, "log queue full");
+}
+
+/* ---------------- Trace ---------------- */
+
+/**
+  * @brief Trace one frame at tick ms + (LOAD + 1 - val) SysTick counts and check the packet
+  * The expected record goes to trace_want in can_trace.py's terms:
+  * time_us can_id flags dlc data (flags: 1 remote, 2 transmitted, 4 extended).
+  * @retval None
+  */
+static void trace_one(char dir, const CAN_Frame_t *frame, uint32_t tick, uint32_t val)
+{
+	uint64_t time_us;
+	uint32_t id = (frame->header.IDE == CAN_ID_EXT) ? frame->header.ExtId : frame->header.StdId;
+	uint32_t flags = 0;
+	uint32_t n = (frame->header.RTR == CAN_RTR_REMOTE) ? 0U : frame->header.DLC;
+	uint32_t got_time, got_id, i;
+
+	uwTick = tick;
+	stub_systick.VAL = val;
+	time_us = (uint64_t)tick * 1000U + ((stub_systick.LOAD + 1U - val) * 1000U) / (stub_systick.LOAD + 1U);
+	flags |= (frame->header.RTR == CAN_RTR_REMOTE) ? 1U : 0U;
+	flags |= (dir == TRACE_DIR_TX) ? 2U : 0U;
+	flags |= (frame->header.IDE == CAN_ID_EXT) ? 4U : 0U;
+
+	replies = 0;
+	reply_len = 0;
+	Trace_CAN_Frame(dir, frame);
+	CHECK(replies == 1U && reply[0] == UART_LINK_TYPE_CAN && reply_len == 1U + 9U + n,
+	      "id %X: %u packets, type %u, %u bytes", id, replies, reply[0], reply_len);
+
+	got_time = reply[1] | (reply[2] << 8) | (reply[3] << 16) | ((uint32_t)reply[4] << 24);
+	got_id = reply[5] | (reply[6] << 8) | (reply[7] << 16) | ((uint32_t)reply[8] << 24);
+	CHECK(got_time == (uint32_t)time_us, "id %X: time %u, want %u", id, got_time, (uint32_t)time_us);
+	CHECK((got_id & 0x1FFFFFFFU) == id && ((got_id & UART_LINK_CAN_EXT) != 0U) == ((flags & 4U) != 0U) &&
+	      ((got_id & UART_LINK_CAN_RTR) != 0U) == ((flags & 1U) != 0U) &&
+	      ((got_id & UART_LINK_CAN_TX) != 0U) == ((flags & 2U) != 0U), "id %X sent as %08X", id, got_id);
+	CHECK(reply[9] == frame->header.DLC && memcmp(&reply[10], frame->data, n) == 0, "id %X: dlc or data", id);
+
+	if(trace_want != NULL)
+	{
+		fprintf(trace_want, "%llu %u %u %u ", (unsigned long long)time_us, id, flags, frame->header.DLC);
+		for(i = 0; i < n; i++)
+		{
+			fprintf(trace_want, "%02x", frame->data[i]);
+		}
+		fprintf(trace_want, "\n");
+	}
+}
+
+static void test_trace(void)
+{
+	CAN_Frame_t frame;
+	uint32_t dlc, i;
+
+	memset(&frame, 0, sizeof(frame));
+	stub_systick.LOAD = 79999U;				// 80 MHz core, 1 ms tick
+	trace_level = TRACE_LEVEL_FRAMES;
+
+	/* standard data frames, every length */
+	for(dlc = 0; dlc <= FRAME_DATA_MAX; dlc++)
+	{
+		frame.header.IDE = CAN_ID_STD;
+		frame.header.RTR = CAN_RTR_DATA;
+		frame.header.StdId = 0x7FFU - dlc;
+		frame.header.DLC = dlc;
+		for(i = 0; i < FRAME_DATA_MAX; i++)
+		{
+			frame.data[i] = rng();
+		}
+		trace_one(TRACE_DIR_RX, &frame, 1000U + dlc, 80000U - 1000U * dlc);
+	}
+
+	/* extended, transmitted, remote: the flags sit above the 29-bit ID */
+	frame.header.IDE = CAN_ID_EXT;
+	frame.header.ExtId = 0x1FFFFFFFU;
+	frame.header.DLC = 8U;
+	trace_one(TRACE_DIR_TX, &frame, 2000U, 1U);
+	frame.header.RTR = CAN_RTR_REMOTE;
+	frame.header.ExtId = 0x00012345U;
+	frame.header.DLC = 0U;
+	trace_one(TRACE_DIR_TX, &frame, 2001U, 40000U);
+	frame.header.IDE = CAN_ID_STD;
+	frame.header.StdId = 0x651U;
+	frame.header.DLC = 4U;						// a remote frame carries a DLC but no data
+	trace_one(TRACE_DIR_RX, &frame, 2002U, 79999U);
+
+	/* the microsecond stamp wraps after 2^32 us, the host unwraps it */
+	frame.header.RTR = CAN_RTR_DATA;
+	frame.header.StdId = 0x100U;
+	trace_one(TRACE_DIR_RX, &frame, 4294967U, 40000U);
+	trace_one(TRACE_DIR_RX, &frame, 4294968U, 79999U);
+
+	/* verbosity */
+	replies = 0;
+	trace_level = TRACE_LEVEL_TEXT;
+	Trace_CAN_Frame(TRACE_DIR_RX, &frame);
+	CHECK(replies == 0U, "frame traced at TRACE_LEVEL_TEXT");
+	Trace_Text("hello\n");
+	CHECK(replies == 1U && reply[0] == UART_LINK_TYPE_TEXT && reply_len == 7U && memcmp(&reply[1], "hello\n", 6) == 0,
+	      "text at TRACE_LEVEL_TEXT");
+	replies = 0;
+	trace_level = TRACE_LEVEL_OFF;
+	Trace_Text("hello\n");
+	Trace_CAN_Frame(TRACE_DIR_RX, &frame);
+	CHECK(replies == 0U, "%u packets at TRACE_LEVEL_OFF", replies);
+	trace_level = TRACE_LEVEL_DEFAULT;
+}
+
+int main(int argc, char **argv)
+{
+	char path[512];
+
+	if(argc > 1)
+	{
+		snprintf(path, sizeof(path), "%s.want", argv[1]);
+		trace_wire = fopen(argv[1], "wb");
+		trace_want = fopen(path, "w");
+		if(trace_wire == NULL || trace_want == NULL)
+		{
+			printf("cannot write %s\n", argv[1]);
+			return 1;
+		}
+	}
+
+	test_crc();
+	test_cobs();
+	test_round_trip();
+	test_reject();
+	test_dispatch();
+	test_tx_period();
+	test_filters();
+	test_log();
+	test_bit_timing();
+	test_stats();
+	test_trace();
+
+	if(trace_wire != NULL)
+	{
+		fclose(trace_wire);
+		fclose(trace_want);
+	}
+	printf("%s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * main.h
+ *
+ * Host stand-in for the nodes' Core/Inc/main.h, just the HAL subset that
+ * console.c, trace.c and the headers they include use. Peripherals are plain structs
+ * the test can inspect; the HAL calls are defined by link_test.c.
+ *
+ * Created on: Oct 18, 2026
+ * Author: Barış Can Coşkun
+ */
+
+#ifndef STUB_MAIN_H_
+#define STUB_MAIN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRUE  1
+#define FALSE 0
+
+#define CAN_ISR_IN_RAM   0
+#define __CAN_ISR
+#define __CAN_BUFFER
+
+extern volatile uint32_t uwTick;		// log.h rate limiter
+
+typedef enum
+{
+	HAL_OK = 0,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+/* --- CAN --- */
+typedef struct
+{
+	volatile uint32_t TIR, TDTR, TDLR, TDHR;
+} CAN_TxMailBox_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t MCR, MSR, TSR, RF0R, RF1R, IER, ESR, BTR;
+	CAN_TxMailBox_TypeDef sTxMailBox[3];
+} CAN_TypeDef;
+
+typedef struct
+{
+	uint32_t Prescaler;
+	uint32_t SyncJumpWidth;
+	uint32_t TimeSeg1;
+	uint32_t TimeSeg2;
+} CAN_InitTypeDef;
+
+typedef struct
+{
+	CAN_TypeDef *Instance;
+	CAN_InitTypeDef Init;
+	uint32_t ErrorCode;
+} CAN_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t StdId, ExtId, IDE, RTR, DLC, Timestamp, FilterMatchIndex;
+} CAN_RxHeaderTypeDef;
+
+#define CAN_ID_STD               0x00000000U
+#define CAN_ID_EXT               0x00000004U
+#define CAN_RTR_DATA             0x00000000U
+#define CAN_RTR_REMOTE           0x00000002U
+
+#define CAN_BTR_TS1_Pos          16U
+#define CAN_BTR_TS2_Pos          20U
+#define CAN_BTR_SJW_Pos          24U
+#define CAN_ESR_TEC_Pos          16U
+#define CAN_ESR_TEC              (0xFFUL << CAN_ESR_TEC_Pos)
+#define CAN_ESR_REC_Pos          24U
+#define CAN_ESR_REC              (0xFFUL << CAN_ESR_REC_Pos)
+
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef *hcan);
+HAL_StatusTypeDef HAL_CAN_Init(CAN_HandleTypeDef *hcan);
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan);
+
+/* --- TIM --- */
+typedef struct
+{
+	volatile uint32_t CNT, PSC, ARR;
+} TIM_TypeDef;
+
+typedef struct
+{
+	uint32_t Prescaler;
+	uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+	TIM_TypeDef *Instance;
+	TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+#define __HAL_TIM_SET_AUTORELOAD(h, v)  do { (h)->Instance->ARR = (v); (h)->Init.Period = (v); } while(0)
+#define __HAL_TIM_SET_COUNTER(h, v)     ((h)->Instance->CNT = (v))
+
+/* --- RCC --- */
+typedef struct
+{
+	volatile uint32_t CFGR;
+} RCC_TypeDef;
+
+extern RCC_TypeDef stub_rcc;
+#define RCC                      (&stub_rcc)
+#define RCC_CFGR_PPRE1           (0x7UL << 10)
+#define RCC_HCLK_DIV1            0x00000000UL
+#define RCC_HCLK_DIV4            (0x5UL << 10)
+
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+/* --- UART --- */
+typedef struct
+{
+	void *Instance;
+} UART_HandleTypeDef;
+
+/* --- SysTick (Trace_Time_Us) --- */
+typedef struct
+{
+	volatile uint32_t CTRL, LOAD, VAL;
+} SysTick_Type;
+
+extern SysTick_Type stub_systick;
+#define SysTick                     (&stub_systick)
+
+uint32_t HAL_GetTick(void);
+
+/* --- DWT (cycles.h) --- */
+typedef struct
+{
+	volatile uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type stub_dwt;
+extern CoreDebug_Type stub_core_debug;
+#define DWT                         (&stub_dwt)
+#define CoreDebug                   (&stub_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk      1UL
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+
+#endif /* STUB_MAIN_H_ */